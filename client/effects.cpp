@@ -0,0 +1,164 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "effects.h"
+
+#include <math.h>
+
+// each type has its own pass, the loops carry no switch and the compiler can vectorize them
+static void UpdateFade(EffectArrays &effects)
+{
+    for (size_t i = 0; i < effects.Count; i++) {
+        effects.Alphas[i] = effects.Lifetimes[i] / effects.MaxLifetimes[i];
+        effects.DrawPositions[i] = effects.Positions[i];
+    }
+}
+
+static void UpdateRiseFade(EffectArrays &effects)
+{
+    for (size_t i = 0; i < effects.Count; i++) {
+        float param = effects.Lifetimes[i] / effects.MaxLifetimes[i];
+        effects.Alphas[i] = param;
+        effects.DrawPositions[i] = Vector2{effects.Positions[i].x, effects.Positions[i].y - (1.0f - param) * 30};
+    }
+}
+
+static void UpdateRotateFade(EffectArrays &effects)
+{
+    for (size_t i = 0; i < effects.Count; i++) {
+        float param = effects.Lifetimes[i] / effects.MaxLifetimes[i];
+        effects.Alphas[i] = param;
+        effects.Rotations[i] = (1.0f - param) * 360;
+        effects.DrawPositions[i] = effects.Positions[i];
+    }
+}
+
+static void UpdateScaleFade(EffectArrays &effects)
+{
+    for (size_t i = 0; i < effects.Count; i++) {
+        float param = effects.Lifetimes[i] / effects.MaxLifetimes[i];
+        effects.Alphas[i] = param;
+        effects.Scales[i] = 1 + (1.0f - param);
+        effects.DrawPositions[i] = effects.Positions[i];
+    }
+}
+
+// flies from where it started to the target over its lifetime
+static void UpdateToTarget(EffectArrays &effects)
+{
+    for (size_t i = 0; i < effects.Count; i++) {
+        float travel = 1.0f - effects.Lifetimes[i] / effects.MaxLifetimes[i];
+        const Vector2 &from = effects.Positions[i];
+        const Vector2 &to = effects.Targets[i];
+        effects.DrawPositions[i] = Vector2{from.x + (to.x - from.x) * travel, from.y + (to.y - from.y) * travel};
+    }
+}
+
+static void RemoveAt(EffectArrays &effects, size_t index)
+{
+    size_t last = --effects.Count;
+    effects.Positions[index] = effects.Positions[last];
+    effects.Targets[index] = effects.Targets[last];
+    effects.Lifetimes[index] = effects.Lifetimes[last];
+    effects.MaxLifetimes[index] = effects.MaxLifetimes[last];
+    effects.SpriteIds[index] = effects.SpriteIds[last];
+}
+
+EffectSystem::EffectSystem(size_t capacityPerType)
+    : Capacity(capacityPerType)
+{
+    for (EffectArrays &effects : Effects) {
+        effects.Positions.resize(Capacity);
+        effects.Targets.resize(Capacity);
+        effects.Lifetimes.resize(Capacity);
+        effects.MaxLifetimes.resize(Capacity);
+        effects.SpriteIds.resize(Capacity);
+        effects.DrawPositions.resize(Capacity);
+        effects.Rotations.resize(Capacity);
+        effects.Scales.resize(Capacity);
+        effects.Alphas.resize(Capacity);
+    }
+}
+
+bool EffectSystem::Add(const Vector2 &position, EffectType effect, int spriteId, const Vector2 &target, float lifetime)
+{
+    EffectArrays &effects = Effects[size_t(effect)];
+    if (effects.Count == Capacity)
+        return false;
+
+    size_t index = effects.Count++;
+    effects.Positions[index] = position;
+    effects.Targets[index] = target;
+    effects.Lifetimes[index] = lifetime;
+    effects.MaxLifetimes[index] = lifetime;
+    effects.SpriteIds[index] = spriteId;
+
+    // how every type looks before it has aged at all
+    effects.DrawPositions[index] = position;
+    effects.Rotations[index] = 0;
+    effects.Scales[index] = 1;
+    effects.Alphas[index] = 1;
+    return true;
+}
+
+void EffectSystem::Update(float deltaTime)
+{
+    for (EffectArrays &effects : Effects) {
+        for (size_t i = 0; i < effects.Count;) {
+            effects.Lifetimes[i] -= deltaTime;
+
+            // the one moved in from the end hasn't aged yet, so look at this index again
+            if (effects.Lifetimes[i] < 0)
+                RemoveAt(effects, i);
+            else
+                i++;
+        }
+    }
+
+    UpdateFade(Effects[size_t(EffectType::Fade)]);
+    UpdateRiseFade(Effects[size_t(EffectType::RiseFade)]);
+    UpdateRotateFade(Effects[size_t(EffectType::RotateFade)]);
+    UpdateScaleFade(Effects[size_t(EffectType::ScaleFade)]);
+    UpdateToTarget(Effects[size_t(EffectType::ToTarget)]);
+}
+
+void EffectSystem::Clear()
+{
+    for (EffectArrays &effects : Effects)
+        effects.Count = 0;
+}
+
+size_t EffectSystem::Size() const
+{
+    size_t size = 0;
+    for (const EffectArrays &effects : Effects)
+        size += effects.Count;
+    return size;
+}
+
+const EffectArrays &EffectSystem::Get(EffectType effect) const
+{
+    return Effects[size_t(effect)];
+}
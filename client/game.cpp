@@ -4,123 +4,216 @@
 #include "monsters.h"
 #include "audio.h"
 #include "resource_ids.h"
+#include "sim_convert.h"
 
 #include "raylib.h"
 #include "raymath.h"
 
+#include <math.h>
+#include <algorithm>
+
 constexpr bool disableLostFocusPause = true;
 
-GameState::GameState()
-    : Player1(1, "Player1"), Player2(2, "Player2")
+static Vector2 ReadPosition(const sim::Rect &bounds, uint16_t x, uint16_t y)
 {
-    Player1.ActivateItem = [this](int item)
-    { ActivateItem(Player1, item); };
-    Player1.DropItem = [this](int item)
-    { DropItem(Player1, item); };
-
-    Player2.ActivateItem = [this](int item)
-    { ActivateItem(Player2, item); };
-    Player2.DropItem = [this](int item)
-    { DropItem(Player2, item); };
+    return Vector2{net::DequantizeCoordinate(x, bounds.x, bounds.width),
+                   net::DequantizeCoordinate(y, bounds.y, bounds.height)};
 }
 
-void GameState::LoadLevel(const char *level)
+// snapshots keep every list sorted by id
+template<typename T>
+static const T *FindById(const std::vector<T> &entities, uint32_t id)
 {
-    LoadMap(level);
-    Player1.Sprite = AddSprite(PlayerSprite, Player1.Position);
-    Player1.Sprite->Bobble = true;
-    Player1.Sprite->Shadow = true;
-
-    Player2.Sprite = AddSprite(PlayerSprite, Player2.Position);
-    Player2.Sprite->Bobble = true;
-    Player2.Sprite->Shadow = true;
+    auto itr = std::lower_bound(entities.begin(), entities.end(), id,
+                                [](const T &entity, uint32_t id) { return entity.id() < id; });
+    return itr != entities.end() && itr->id() == id ? &*itr : nullptr;
 }
 
-void GameState::StartLevel()
+// where an entity is between an older state and a newer one, just the newer one if the older doesn't have it
+template<typename T>
+static Vector2 InterpolatePosition(const std::vector<T> &older, const T &newer, float alpha, const sim::Rect &bounds)
 {
-    GameClock = 0;
+    Vector2 position = ReadPosition(bounds, newer.x(), newer.y());
 
-    Player1.LastConsumeable = -100;
-    Player1.LastAttack = -100;
+    const T *from = FindById(older, newer.id());
+    if (from == nullptr)
+        return position;
 
-    Player2.LastConsumeable = -100;
-    Player2.LastAttack = -100;
+    return Vector2Lerp(ReadPosition(bounds, from->x(), from->y()), position, alpha);
+}
 
-    Player1.Waiting = false;
-    Player2.Waiting = false;
+// remote sprites are placed every frame, the tick interpolation must not blend them a second time
+static void HoldSprite(SpriteInstance *sprite)
+{
+    if (sprite != nullptr)
+        sprite->PreviousPosition = sprite->Position;
+}
 
-    auto *spawn = GetFirstMapObjectOfType(PlayerSpawnType);
-    if (spawn != nullptr) {
-        Player1.Position.x = spawn->Bounds.x;
-        Player1.Position.y = spawn->Bounds.y;
+void EntitySprites::Begin()
+{
+    Stamp++;
+}
 
-        Player2.Position.x = spawn->Bounds.x;
-        Player2.Position.y = spawn->Bounds.y;
+SpriteInstance *EntitySprites::Touch(uint32_t id, int frame, const Vector2 &position)
+{
+    Entry &entry = Sprites[id];
+    SpriteInstance *sprite = GetSprite(entry.Sprite);
+    if (sprite == nullptr) {
+        entry.Sprite = AddSprite(frame, position);
+        sprite = GetSprite(entry.Sprite);
+        sprite->Bobble = true;
+        sprite->Shadow = true;
     }
 
-    Player1.TargetActive = false;
-    Player2.TargetActive = false;
+    sprite->SpriteFrame = frame;
+    sprite->Position = position;
+    entry.Stamp = Stamp;
+    return sprite;
+}
 
-    Exits.clear();
-    for (const TileObject *exit : GetMapObjectsOfType(ExitType)) {
-        const Property *level = exit->GetProperty("target_level");
-        if (level != nullptr) {
-            if (level->Value == "-1")
-                Exits.emplace_back(Exit{exit->Bounds, "endgame"});
-            else
-                Exits.emplace_back(Exit{exit->Bounds, "level" + level->Value + ".tmx"});
+void EntitySprites::End()
+{
+    for (auto itr = Sprites.begin(); itr != Sprites.end();) {
+        if (itr->second.Stamp == Stamp) {
+            itr++;
+            continue;
         }
+
+        RemoveSprite(itr->second.Sprite);
+        itr = Sprites.erase(itr);
     }
+}
 
-    Chests.clear();
+SpriteInstance *EntitySprites::Move(uint32_t id, int frame, const Vector2 &position)
+{
+    auto itr = Sprites.find(id);
+    if (itr == Sprites.end())
+        return nullptr;
 
-    Player1.TargetChest = nullptr;
-    Player2.TargetChest = nullptr;
-    Player1.TargetMob = nullptr;
-    Player2.TargetMob = nullptr;
+    SpriteInstance *sprite = GetSprite(itr->second.Sprite);
+    if (sprite == nullptr)
+        return nullptr;
 
-    for (const TileObject *chest : GetMapObjectsOfType(ChestType)) {
-        const Property *contents = chest->GetProperty("contents");
-        if (contents != nullptr)
-            Chests.emplace_back(Chest{chest->Bounds, contents->Value});
-    }
+    sprite->SpriteFrame = frame;
+    sprite->Position = position;
+    return sprite;
+}
 
-    ItemDrops.clear();
+void EntitySprites::Remove(uint32_t id)
+{
+    auto itr = Sprites.find(id);
+    if (itr == Sprites.end())
+        return;
 
-    for (const TileObject *mobSpawn : GetMapObjectsOfType(MobSpawnType)) {
-        const Property *mobType = mobSpawn->GetProperty("mob_type");
+    RemoveSprite(itr->second.Sprite);
+    Sprites.erase(itr);
+}
 
-        MOB *monster = GetMob(mobType->GetInt());
-        if (monster == nullptr)
-            continue;
+void EntitySprites::Clear()
+{
+    Sprites.clear();
+}
 
-        Vector2 pos = Vector2{mobSpawn->Bounds.x, mobSpawn->Bounds.y};
-        auto *sprite = AddSprite(monster->Sprite, pos);
-        sprite->Bobble = true;
-        sprite->Shadow = true;
+GameState::GameState()
+    : Player1(1, "Player1"), Player2(2, "Player2")
+{
+    Player1.ActivateItem = [this](int item)
+    { ActivateItem(Player1, item); };
+    Player1.DropItem = [this](int item)
+    { DropItem(Player1, item); };
 
-        Mobs.push_back(MobInstance{monster->Id, pos, monster->Health, sprite->Id});
-    }
+    Player2.ActivateItem = [this](int item)
+    { ActivateItem(Player2, item); };
+    Player2.DropItem = [this](int item)
+    { DropItem(Player2, item); };
+
+    // online every message goes straight to what applies it
+    Dispatcher.On<Serialize::Welcome>([this](const Serialize::Welcome *welcome)
+                                      { Player1.Id = welcome->player_id(); });
+    Dispatcher.On<Serialize::WorldState>([this](const Serialize::WorldState *state)
+                                         { ApplyWorldState(state); });
+    Dispatcher.On<Serialize::WorldEvents>([this](const Serialize::WorldEvents *events)
+                                          { ApplyWorldEvents(events); });
+    Dispatcher.On<Serialize::Interest>([this](const Serialize::Interest *interest)
+                                       { ApplyInterest(interest); });
 }
 
-void GameState::InitGame(GameMode mode, uint8_t id)
+void GameState::LoadLevel(const char *level)
 {
+    // loading the map removes every sprite
+    LoadMap(level);
+    MobSprites.Clear();
+    DropSprites.Clear();
+    OtherPlayerSprites.Clear();
+
+    // the map is already loaded to draw it, the simulation builds its collision from the same objects
+    World.SetLevel(sim::CreateLevel(level, GetMapData(), CollisionMode));
+
+    Player1.Sprite = AddSprite(PlayerSprite, ToVector2(Player1.Position));
+    Player2.Sprite = AddSprite(PlayerSprite, ToVector2(Player2.Position));
+
+    SpriteInstance *sprite1 = GetSprite(Player1.Sprite);
+    sprite1->Bobble = true;
+    sprite1->Shadow = true;
+
+    SpriteInstance *sprite2 = GetSprite(Player2.Sprite);
+    sprite2->Bobble = true;
+    sprite2->Shadow = true;
+    sprite2->Active = Player2.Id != 0;
+}
+
+void GameState::StartLevel()
+{
+    World.StartLevel();
+
+    // everything was just placed, don't blend in from where it was on the last level
+    UpdateSprites();
+    ResetSpriteInterpolation();
+    TickAccumulator = 0;
+}
+
+void GameState::InitGame(GameMode mode, sim::PlayerId id, net::RoomId room)
+{
+    // the ids can change between games and the world finds players by id
+    World.RemovePlayer(Player1.Id);
+    World.RemovePlayer(Player2.Id);
+
     Mode = mode;
     if (mode == GameMode::ONLINE) {
         ENetClient = net::ENetClient::Create(id);
         ENetClient->TraceLog = TraceLog;
-        if (ENetClient->Connect("localhost", 8000) != 0) {
+        if (ENetClient->Connect("localhost", 8000, room) != 0) {
             TraceLog(LOG_ERROR, "Error connect");
             Mode = GameMode::LOCAL;
         }
 
+        // both are settled once the server has welcomed us and sent the first state
         Player1.Id = id;
-        Player2.Id = 3 - id;
+        Player2.Id = 0;
     }
     else {
         Player1.Id = 1;
         Player2.Id = 2;
     }
+
+    World.AddPlayer(Player1);
+    World.AddPlayer(Player2);
+
+    // online the server says which level to load once it has let us in
+    if (Mode == GameMode::ONLINE) {
+        Input = net::InputCommand();
+        MoveHeld = false;
+        MoveSequence = 0;
+        LevelMoveSequence = 0;
+        std::fill(MoveHistory.begin(), MoveHistory.end(), Serialize::MoveStep());
+        CorrectionOffset = Vector2{0, 0};
+        LevelTick = 0;
+        StateTick = 0;
+        RenderTick = 0;
+        Snapshots.Clear();
+        return;
+    }
+
     // load start level
     LoadLevel("maps/level0.tmx");
     StartLevel();
@@ -129,15 +222,31 @@ void GameState::InitGame(GameMode mode, uint8_t id)
 void GameState::QuitGame()
 {
     ClearMap();
+    MobSprites.Clear();
+    DropSprites.Clear();
+    OtherPlayerSprites.Clear();
+    Player1.Sprite = SpriteHandle();
+    Player2.Sprite = SpriteHandle();
+}
+
+Player *GameState::GetPlayer(uint32_t id)
+{
+    if (id == 0)
+        return nullptr;
+    if (id == Player1.Id)
+        return &Player1;
+    if (id == Player2.Id)
+        return &Player2;
+    return nullptr;
 }
 
 void GameState::GetPlayerInput()
 {
-    float moveUnit = 2.0f;
+    float moveUnit = GetMoveUnit();
 
     // User1 input
     bool player1KeyPressed = false;
-    Vector2 player1TargetPosition = Player1.Position;
+    Vector2 player1TargetPosition = ToVector2(Player1.Position);
 
     if (IsKeyDown(KEY_LEFT)) {
         player1TargetPosition.x -= moveUnit;
@@ -159,701 +268,662 @@ void GameState::GetPlayerInput()
         player1KeyPressed = true;
     }
 
-    // check for key inputs
-    if (!Player1.Waiting && player1KeyPressed) {
-        if (PointInMap(player1TargetPosition)) {
-            Player1.TargetActive = true;
-            Player1.Target = player1TargetPosition;
-            if (Mode == GameMode::ONLINE)
-                ENetClient->SendPosition(player1TargetPosition.x, player1TargetPosition.y);
-        }
-
-        Player1.TargetChest = nullptr;
-        for (auto &chest : Chests) {
-            if (CheckCollisionPointRec(player1TargetPosition, chest.Bounds)) {
-                Player1.TargetChest = &chest;
-            }
-        }
-
-        // if player is close to any mob
-        if (!Player1.Waiting) {
-            for (auto &mob : Mobs) {
-                if (CheckCollisionPointCircle(player1TargetPosition, mob.Position, 20)) {
-                    Player1.TargetMob = &mob;
-
-                    if (Vector2Distance(Player1.Position, mob.Position) <= Player1.GetAttack().Range + 40)
-                        Player1.TargetActive = false;
-                    break;
-                }
-            }
-        }
+    if (Mode == GameMode::ONLINE) {
+        // the next prediction tick makes a move of it, the other player has their own client
+        MoveHeld = player1KeyPressed;
+        MoveOffset = Vector2Subtract(player1TargetPosition, ToVector2(Player1.Position));
+        return;
     }
 
+    if (player1KeyPressed)
+        World.SetMoveTarget(Player1, ToVec2(player1TargetPosition));
+
     // User2 input
     bool player2KeyPressed = false;
-    Vector2 player2TargetPosition;
+    Vector2 player2TargetPosition = ToVector2(Player2.Position);
 
-    if (Mode != GameMode::ONLINE) {
-        player2TargetPosition = Player2.Position;
-        if (IsKeyDown(KEY_A)) {
-            player2TargetPosition.x -= moveUnit;
-            player2KeyPressed = true;
-        }
-
-        if (IsKeyDown(KEY_D)) {
-            player2TargetPosition.x += moveUnit;
-            player2KeyPressed = true;
-        }
+    if (IsKeyDown(KEY_A)) {
+        player2TargetPosition.x -= moveUnit;
+        player2KeyPressed = true;
+    }
 
-        if (IsKeyDown(KEY_W)) {
-            player2TargetPosition.y -= moveUnit;
-            player2KeyPressed = true;
-        }
+    if (IsKeyDown(KEY_D)) {
+        player2TargetPosition.x += moveUnit;
+        player2KeyPressed = true;
+    }
 
-        if (IsKeyDown(KEY_S)) {
-            player2TargetPosition.y += moveUnit;
-            player2KeyPressed = true;
-        }
+    if (IsKeyDown(KEY_W)) {
+        player2TargetPosition.y -= moveUnit;
+        player2KeyPressed = true;
     }
-    else {
-        auto pos = ENetClient->GetPosition(Player2.Id);
-        if (pos != nullptr) {
-            player2KeyPressed = true;
-            player2TargetPosition.x = pos->x();
-            player2TargetPosition.y = pos->y();
-        }
+
+    if (IsKeyDown(KEY_S)) {
+        player2TargetPosition.y += moveUnit;
+        player2KeyPressed = true;
     }
 
-    if (!Player2.Waiting && player2KeyPressed) {
-        if (PointInMap(player2TargetPosition)) {
-            Player2.TargetActive = true;
-            Player2.Target = player2TargetPosition;
-        }
+    if (player2KeyPressed)
+        World.SetMoveTarget(Player2, ToVec2(player2TargetPosition));
+}
 
-        Player2.TargetChest = nullptr;
-        for (auto &chest : Chests) {
-            if (CheckCollisionPointRec(player2TargetPosition, chest.Bounds)) {
-                Player2.TargetChest = &chest;
-            }
-        }
+void GameState::ActivateItem(Player &player, int slotIndex)
+{
+    if (Mode != GameMode::ONLINE) {
+        World.ActivateItem(player, slotIndex);
+        return;
+    }
 
-        if (!Player2.Waiting) {
-            for (auto &mob : Mobs) {
-                if (CheckCollisionPointCircle(player2TargetPosition, mob.Position, 20)) {
-                    Player2.TargetMob = &mob;
+    // only our own inventory can be used from here
+    if (&player != &Player1)
+        return;
 
-                    if (Vector2Distance(Player2.Position, mob.Position) <= Player2.GetAttack().Range + 40)
-                        Player2.TargetActive = false;
-                    break;
-                }
-            }
-        }
-    }
+    Input.ActivateSlot = int16_t(slotIndex);
+    SendInput();
 }
 
-/// <summary>
-/// Get user's target position. Set set TargetChest and TargetMob if players is close to it.
-/// </summary>
-/// <param name="player"></param>
-void GameState::GetPlayerInput(Player& player)
+void GameState::DropItem(Player &player, int slotIndex)
 {
+    if (Mode != GameMode::ONLINE) {
+        World.DropItem(player, slotIndex);
+        return;
+    }
 
-    if (player.Id == Player1.Id) {
-        // Player1
-        bool keyPressed = false;
-        Vector2 targetPosition = player.Position;
+    if (&player != &Player1)
+        return;
 
-        if (IsKeyDown(KEY_LEFT)) {
-            targetPosition.x -= MoveUnit;
-            keyPressed = true;
-        }
+    Input.DropSlot = int16_t(slotIndex);
+    SendInput();
+}
 
-        if (IsKeyDown(KEY_RIGHT)) {
-            targetPosition.x += MoveUnit;
-            keyPressed = true;
-        }
+void GameState::SendInput()
+{
+    if (Input.ActivateSlot < 0 && Input.DropSlot < 0)
+        return;
 
-        if (IsKeyDown(KEY_UP)) {
-            targetPosition.y -= MoveUnit;
-            keyPressed = true;
-        }
+    Input.Sequence = ++InputSequence;
+    ENetClient->SendInput(Input);
+    Input = net::InputCommand();
+}
 
-        if (IsKeyDown(KEY_DOWN)) {
-            targetPosition.y += MoveUnit;
-            keyPressed = true;
-        }
+void GameState::PollServer()
+{
+    ENetClient->Poll(Dispatcher);
+}
 
-        // check for key inputs
-        if (!player.Waiting && keyPressed) {
-            if (PointInMap(targetPosition)) {
-                player.TargetActive = true;
-                player.Target = targetPosition;
-                if (Mode == GameMode::ONLINE)
-                    ENetClient->SendPosition(targetPosition.x, targetPosition.y);
-            }
+void GameState::ApplyWorldState(const Serialize::WorldState *state)
+{
+    // states aren't ordered with the level change, anything older than it belongs to the last level
+    if (World.GetLevel() == nullptr || state->tick() <= LevelTick || state->tick() <= StateTick)
+        return;
 
-            // if player is close to any chest
-            player.TargetChest = nullptr;
-            for (auto& chest : Chests) {
-                if (CheckCollisionPointRec(targetPosition, chest.Bounds)) {
-                    player.TargetChest = &chest;
-                }
-            }
+    // the baseline is one we acked, unless it is so old it was already replaced
+    const net::Snapshot *baseline = nullptr;
+    if (state->baseline() != 0) {
+        if (state->tick() - state->baseline() >= net::CLIENT_SNAPSHOT_HISTORY)
+            return;
 
-            // if player is close to any mob
-            if (!player.Waiting) {
-                for (auto& mob : Mobs) {
-                    if (CheckCollisionPointCircle(targetPosition, mob.Position, 20)) {
-                        player.TargetMob = &mob;
-
-                        if (Vector2Distance(player.Position, mob.Position) <= player.GetAttack().Range + 40)
-                            player.TargetActive = false;
-                        break;
-                    }
-                }
-            }
-        }
+        baseline = Snapshots.Find(state->baseline());
+        if (baseline == nullptr)
+            return;
     }
-    else {
-        // Player2
-        bool keyPressed = false;
-        Vector2 targetPosition = player.Position;
-
-        if (Mode == GameMode::LOCAL) {
-            if (IsKeyDown(KEY_A)) {
-                targetPosition.x -= MoveUnit;
-                keyPressed = true;
-            }
 
-            if (IsKeyDown(KEY_D)) {
-                targetPosition.x += MoveUnit;
-                keyPressed = true;
-            }
+    net::Snapshot &snapshot = Snapshots.Add(state->tick());
+    if (!net::ReadSnapshot(state, baseline, snapshot))
+        return;
 
-            if (IsKeyDown(KEY_W)) {
-                targetPosition.y -= MoveUnit;
-                keyPressed = true;
-            }
+    StateTick = state->tick();
+    ENetClient->SendAck(StateTick);
 
-            if (IsKeyDown(KEY_S)) {
-                targetPosition.y += MoveUnit;
-                keyPressed = true;
-            }
-        }
-        else {
-            auto pos = ENetClient->GetPosition(player.Id);
-            if (pos != nullptr) {
-                keyPressed = true;
-                targetPosition.x = pos->x();
-                targetPosition.y = pos->y();
-            }
-        }
-           
-        if (!player.Waiting && keyPressed) {
-            // Try to get the position from network
-            auto pos = ENetClient->GetPosition(player.Id);
-            if (pos != nullptr) {
-                Vector2 targetPosition = { pos->x(), pos->y() };
-                player.TargetActive = true;
-                player.Target = targetPosition;
-
-                // if player is close to any chest
-                player.TargetChest = nullptr;
-                for (auto& chest : Chests) {
-                    if (CheckCollisionPointRec(targetPosition, chest.Bounds)) {
-                        player.TargetChest = &chest;
-                    }
-                }
-
-                // if player is close to any mob
-                if (!player.Waiting) {
-                    for (auto& mob : Mobs) {
-                        if (CheckCollisionPointCircle(targetPosition, mob.Position, 20)) {
-                            player.TargetMob = &mob;
-
-                            if (Vector2Distance(player.Position, mob.Position) <= player.GetAttack().Range + 40)
-                                player.TargetActive = false;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    ApplySnapshot(snapshot);
 }
 
-Player *GameState::GetClosestPlayer(const Vector2 &position)
+void GameState::ApplySnapshot(const net::Snapshot &snapshot)
 {
-    auto vecToPlayer1 = Vector2Subtract(Player1.Position, position);
-    auto distance1 = Vector2Length(vecToPlayer1);
+    const sim::Rect &bounds = World.GetLevel()->Map.Bounds;
 
-    auto vecToPlayer2 = Vector2Subtract(Player2.Position, position);
-    float distance2 = Vector2Length(vecToPlayer2);
+    // sprites aren't moved here, ours follows the prediction and the rest are drawn behind the newest state
+    World.TickCount = snapshot.Tick;
 
-    if (distance1 < distance2)
-        return &Player1;
+    ChoosePartner(snapshot);
 
-    return &Player2;
-}
+    Vector2 drawnPosition = Vector2Add(ToVector2(Player1.Position), CorrectionOffset);
+    bool reconcile = false;
 
-void GameState::CullDeadMobs()
-{
-    for (auto mobItr = Mobs.begin(); mobItr != Mobs.end();) {
-        MOB *monsterInfo = GetMob(mobItr->MobId);
-        if (monsterInfo != nullptr && mobItr->Health > 0) {
-            mobItr++;
+    for (const Serialize::PlayerSnapshot &state : snapshot.Players) {
+        Player *player = GetPlayer(state.id());
+        if (player == nullptr)
             continue;
-        }
 
-        if (monsterInfo != nullptr)
-            DropLoot(monsterInfo->lootTable.c_str(), mobItr->Position);
+        if (player == &Player1)
+            reconcile = true;
+
+        player->Position = ToVec2(ReadPosition(bounds, state.x(), state.y()));
+        player->Target = ToVec2(ReadPosition(bounds, state.target_x(), state.target_y()));
+        player->TargetActive = (state.flags() & net::PLAYER_FLAG_TARGET_ACTIVE) != 0;
+        player->Waiting = (state.flags() & net::PLAYER_FLAG_WAITING) != 0;
+        player->Health = state.health();
+        player->Gold = state.gold();
+        player->EquippedWeapon = state.equipped_weapon();
+        player->EquippedArmor = state.equipped_armor();
+        player->BuffItem = state.buff_item();
+        player->BuffDefense = state.buff_defense();
+        player->BuffLifetimeLeft = net::DequantizeTime(state.buff_lifetime());
+        player->AttackCooldown = net::DequantizeTime(state.attack_cooldown());
+        player->ItemCooldown = net::DequantizeTime(state.item_cooldown());
+        player->BackpackContents.clear();
+    }
+
+    for (const Serialize::InventorySlot &slot : snapshot.Inventory) {
+        Player *player = GetPlayer(slot.player_id());
+        if (player != nullptr)
+            player->BackpackContents.emplace_back(sim::InventoryContents{slot.item_id(), slot.quantity()});
+    }
+
+    // mobs keep the server's ids so their sprites follow them from one state to the next
+    World.Mobs.Clear();
+    for (const Serialize::MobSnapshot &state : snapshot.Mobs) {
+        MOB *monster = GetMob(state.mob_type());
+        if (monster == nullptr)
+            continue;
 
-        RemoveSprite(mobItr->SpriteId);
-        if (monsterInfo != nullptr)
-            AddEffect(mobItr->Position, EffectType::RotateFade, monsterInfo->Sprite, 3.5f);
+        World.Mobs.Add(*monster, ToVec2(ReadPosition(bounds, state.x(), state.y())), state.id());
 
-        mobItr = Mobs.erase(mobItr);
+        size_t index = World.Mobs.Size() - 1;
+        World.Mobs.Health[index] = state.health();
+        World.Mobs.Triggered[index] = state.triggered() != 0;
     }
-}
 
-void GameState::UpdateMobSprites()
-{
-    for (auto &mob : Mobs) {
-        UpdateSprite(mob.SpriteId, mob.Position);
+    World.ItemDrops.clear();
+    for (const Serialize::DropSnapshot &state : snapshot.Drops) {
+        World.ItemDrops.emplace_back(sim::ItemDrop{state.id(),
+                                                   TreasureInstance{state.item_id(), state.quantity()},
+                                                   ToVec2(ReadPosition(bounds, state.x(), state.y()))});
     }
-}
 
-void GameState::UpdateMobs()
-{
-    Positions positions{Player1.Position, Player2.Position};
-    CullDeadMobs();
+    for (size_t i = 0; i < World.Chests.size() && i < snapshot.Chests.size(); i++)
+        World.Chests[i].Opened = snapshot.Chests[i] != 0;
 
-    // check for mob actions
-    for (auto &mob : Mobs) {
-        auto *player = GetClosestPlayer(mob.Position);
-        if (player->Waiting)
-            continue;
+    // after the mobs, moves aimed at one stop short of it just like they did on the server
+    if (reconcile)
+        ReconcilePlayer(snapshot.MoveAck, drawnPosition);
+}
 
-        auto vecToPlayer = Vector2Subtract(player->Position, mob.Position);
-        auto distance = Vector2Length(vecToPlayer);
+void GameState::PredictTick(float deltaTime)
+{
+    // nothing to walk around in until the server has sent a level
+    if (World.GetLevel() != nullptr) {
+        uint32_t flags = 0;
+        Vector2 target = ToVector2(Player1.Position);
+        if (MoveHeld && !Player1.Waiting) {
+            flags |= net::MOVE_FLAG_TARGET;
+            target = Vector2Add(target, MoveOffset);
+        }
 
-        MOB *monsterInfo = GetMob(mob.MobId);
+        Serialize::MoveStep move(++MoveSequence, flags, target.x, target.y);
+        MoveHistory[MoveSequence % MoveHistory.size()] = move;
+        ApplyMove(move, deltaTime);
 
-        if (monsterInfo == nullptr)
-            continue;
+        // every move goes out with the few before it, so a lost packet is covered by the next one
+        Serialize::MoveStep moves[net::MOVE_REDUNDANCY];
+        uint32_t count = std::min(MoveSequence - LevelMoveSequence, net::MOVE_REDUNDANCY);
+        for (uint32_t i = 0; i < count; i++)
+            moves[i] = MoveHistory[(MoveSequence - count + 1 + i) % MoveHistory.size()];
 
-        if (!mob.Triggered) {
-            // see if the mob should wake up
-            if (distance > monsterInfo->DetectionRadius) // too far away
-                continue;
+        ENetClient->SendMove(moves, count);
+    }
 
-            if (Ray2DHitsMap(player->Position, mob.Position))
-                continue; // something is blocking line of sight
+    CorrectionOffset = Vector2Scale(CorrectionOffset, exp2f(-deltaTime / CorrectionHalfLife));
 
-            // we see our prey, wake up and get em.
-            mob.Triggered = true;
+    UpdateSprites();
+    UpdateEffects(deltaTime);
+}
 
-            PlaySound(AlertSoundId);
-            AddEffect(mob.Position, EffectType::RiseFade, AwakeSprite, 1);
-        }
+void GameState::ApplyMove(const Serialize::MoveStep &step, float deltaTime)
+{
+    if ((step.flags() & net::MOVE_FLAG_TARGET) != 0)
+        World.SetMoveTarget(Player1, sim::Vec2{step.x(), step.y()});
 
-        if (mob.Triggered) {
-            if (distance < monsterInfo->Attack.Range) {
-                // try to attack the player
-                if (GetGameTime() - mob.LastAttack >= monsterInfo->Attack.Cooldown) {
-                    mob.LastAttack = GetGameTime();
-                    int damage = ResolveAttack(monsterInfo->Attack, player->GetDefense());
-
-                    if (monsterInfo->Attack.Melee)
-                        AddEffect(player->Position, EffectType::RotateFade, MobAttackSprite);
-                    else
-                        AddEffect(mob.Position, EffectType::ToTarget, ProjectileSprite, player->Position, 0.5f);
-
-                    if (damage == 0) {
-                        PlaySound(MissSoundId);
-                    }
-                    else {
-                        PlaySound(HitSoundId);
-                        PlaySound(PlayerDamageSoundId);
-                        AddEffect(Vector2{player->Position.x, player->Position.y - 16},
-                                  EffectType::RiseFade,
-                                  DamageSprite);
-                        player->Health -= damage;
-                    }
-                }
-            }
-            else {
-                // try to move
-                Vector2 movement = Vector2Normalize(vecToPlayer);
+    World.MoveTowardTarget(Player1, deltaTime);
+}
 
-                float frameSpeed = monsterInfo->Speed * GetFrameTime();
-                Vector2 newPos = Vector2Add(mob.Position, Vector2Scale(movement, frameSpeed));
+void GameState::ReconcilePlayer(uint32_t moveAck, const Vector2 &drawnPosition)
+{
+    // the state has us where the server put us after moveAck, the moves after it haven't reached the server yet
+    uint32_t first = std::max(moveAck, LevelMoveSequence) + 1;
+    if (first <= MoveSequence && MoveSequence - first >= MoveHistory.size())
+        first = MoveSequence - uint32_t(MoveHistory.size()) + 1;
 
-                if (PointInMap(newPos))
-                    mob.Position = newPos;
-            }
-        }
+    for (uint32_t sequence = first; sequence <= MoveSequence; sequence++) {
+        const Serialize::MoveStep &move = MoveHistory[sequence % MoveHistory.size()];
+        if (move.sequence() == sequence)
+            ApplyMove(move, GetTickStep());
     }
-}
 
-void GameState::UpdateSprites()
-{
-    Player1.UpdateSprite();
-    Player2.UpdateSprite();
-    UpdateMobSprites();
+    // a small miss fades out from where we were drawn, a big one is a new level or a shove and is jumped to
+    CorrectionOffset = Vector2Subtract(drawnPosition, ToVector2(Player1.Position));
+    if (Vector2Length(CorrectionOffset) > MaxSmoothedCorrection)
+        CorrectionOffset = Vector2{0, 0};
+
+    UpdateSprites();
 }
 
-void GameState::UpdateGame()
+void GameState::UpdateRemoteSprites(float deltaTime)
 {
-    if (IsKeyPressed(KEY_ESCAPE)) {
+    if (World.GetLevel() == nullptr || StateTick <= LevelTick)
+        return;
 
-        if (Player1.InventoryOpen || Player2.InventoryOpen) {
-            Player1.InventoryOpen = false;
-            Player2.InventoryOpen = false;
-        }
-        else {
-            PauseGame();
-            return;
-        }
-    }
+    // the clock runs at the server's rate and is eased toward its delay behind the newest state,
+    // so states arriving unevenly don't show, it only jumps when it is too far off to ease
+    double delayedTick = double(StateTick) - InterpolationDelayTicks;
+    RenderTick += deltaTime * net::SERVER_TICK_RATE;
 
-    if (!disableLostFocusPause && !IsWindowFocused()) {
-        PauseGame();
+    double drift = delayedTick - RenderTick;
+    if (fabs(drift) > net::CLIENT_SNAPSHOT_HISTORY / 2.0)
+        RenderTick = delayedTick;
+    else
+        RenderTick += drift * std::min(1.0, deltaTime * 2.0);
+
+    // never ahead of what we have, never back on the last level
+    RenderTick = std::clamp(RenderTick, double(LevelTick + 1), double(StateTick));
+
+    // the newest state at or before the render tick and the oldest after it, states that were lost are skipped
+    uint32_t tick = uint32_t(RenderTick);
+    const net::Snapshot *from = nullptr;
+    const net::Snapshot *to = nullptr;
+
+    for (uint32_t t = tick; t > LevelTick && tick - t < net::CLIENT_SNAPSHOT_HISTORY && from == nullptr; t--)
+        from = Snapshots.Find(t);
+    for (uint32_t t = tick + 1; t <= StateTick && to == nullptr; t++)
+        to = Snapshots.Find(t);
+
+    if (from == nullptr)
+        from = to;
+    if (to == nullptr)
+        to = from;
+    if (from == nullptr)
         return;
-    }
 
-    // only update our game clock when we are unpaused
-    GameClock += GetFrameTime();
-    GetPlayerInput();
-    //GetPlayerInput(Player1);
-    //GetPlayerInput(Player2);
-
-    MovePlayer(Player1);
-    MovePlayer(Player2);
+    float alpha = to->Tick == from->Tick ? 1 : float((RenderTick - from->Tick) / double(to->Tick - from->Tick));
+    const sim::Rect &bounds = World.GetLevel()->Map.Bounds;
 
-    ApplyAction(Player1);
-    ApplyAction(Player2);
+    for (const Serialize::PlayerSnapshot &player : to->Players) {
+        if (player.id() == Player1.Id)
+            continue;
 
-    UpdateMobs();
+        Vector2 position = InterpolatePosition(from->Players, player, alpha, bounds);
+        int frame = GetPlayerSpriteFrame(player.equipped_armor());
 
-    if (Player1.Health < 0 || Player2.Health < 0) {
-        // you died, change to the end screen
-        EndGame(false, Player1.Gold + Player2.Gold);
+        if (player.id() != Player2.Id) {
+            HoldSprite(OtherPlayerSprites.Move(player.id(), frame, position));
+        }
+        else if (SpriteInstance *sprite = GetSprite(Player2.Sprite)) {
+            sprite->SpriteFrame = frame;
+            sprite->Position = position;
+            HoldSprite(sprite);
+        }
     }
 
-    UpdateSprites();
+    for (const Serialize::MobSnapshot &mob : to->Mobs) {
+        MOB *monster = GetMob(mob.mob_type());
+        if (monster != nullptr)
+            HoldSprite(MobSprites.Move(mob.id(), monster->Sprite, InterpolatePosition(from->Mobs, mob, alpha, bounds)));
+    }
 
-    SetVisiblePoint(Player1.Position);
-    SetVisiblePoint(Player2.Position);
+    for (const Serialize::DropSnapshot &drop : to->Drops) {
+        Item *item = GetItem(drop.item_id());
+        if (item != nullptr)
+            HoldSprite(DropSprites.Move(drop.id(), item->Sprite, InterpolatePosition(from->Drops, drop, alpha, bounds)));
+    }
 }
 
-MobInstance *GameState::GetNearestMobInSight(Vector2 &position)
+void GameState::ChoosePartner(const net::Snapshot &snapshot)
 {
-    MobInstance *nearest = nullptr;
-    float nearestDistance = 9999999.9f;
-
-    for (auto &mob : Mobs) {
-        if (Ray2DHitsMap(mob.Position, position))
+    sim::PlayerId partner = 0;
+    for (const Serialize::PlayerSnapshot &state : snapshot.Players) {
+        if (state.id() == Player1.Id)
             continue;
 
-        float dist = Vector2Distance(mob.Position, position);
-
-        if (dist < nearestDistance) {
-            nearest = &mob;
-            nearestDistance = dist;
+        // keep the one we have for as long as they are around
+        if (state.id() == Player2.Id) {
+            partner = Player2.Id;
+            break;
         }
+
+        if (partner == 0)
+            partner = state.id();
+    }
+
+    if (partner != Player2.Id) {
+        // the old partner is out of view, the new one is drawn by Player2 from now on
+        OtherPlayerSprites.Remove(partner);
+        Player2.Id = partner;
+        Player2.InventoryOpen = false;
     }
 
-    return nearest;
+    if (SpriteInstance *sprite = GetSprite(Player2.Sprite))
+        sprite->Active = Player2.Id != 0;
 }
 
-void GameState::UseConsumable(Player &player, Item *item)
+void GameState::ApplyInterest(const Serialize::Interest *interest)
 {
-    if (item == nullptr || !item->IsActivatable())
+    // it comes after the level change on the same channel, so it is always about the level we have
+    if (World.GetLevel() == nullptr)
         return;
 
-    float time = GetGameTime() - player.LastConsumeable;
-    if (time < 1)
-        return;
+    if (interest->left() != nullptr) {
+        for (const Serialize::EntityRef *entity : *interest->left())
+            RemoveEntitySprite(*entity);
+    }
 
-    player.LastConsumeable = GetGameTime();
+    if (interest->entered() != nullptr) {
+        for (const Serialize::EntityRef *entity : *interest->entered())
+            AddEntitySprite(*entity);
+    }
+}
 
-    switch (item->Effect) {
-        case ActivatableEffects::Healing:player.Health += item->Value;
-            if (player.Health > MaxHealth)
-                player.Health = MaxHealth;
+void GameState::AddEntitySprite(const Serialize::EntityRef &entity)
+{
+    Vector2 position = {entity.x(), entity.y()};
 
-            PlaySound(PlayerHealSoundId);
-            AddEffect(player.Position, EffectType::RiseFade, HealingSprite, 2);
+    switch (entity.kind()) {
+        case net::ENTITY_KIND_PLAYER:
+            // we and our partner have sprites of our own
+            if (GetPlayer(entity.id()) == nullptr)
+                OtherPlayerSprites.Touch(entity.id(), GetPlayerSpriteFrame(entity.type()), position);
             break;
 
-        case ActivatableEffects::Defense:player.BuffDefense = item->Value;
-            player.BuffLifetimeLeft = item->Durration;
-            player.BuffItem = item->Sprite;
+        case net::ENTITY_KIND_MOB: {
+            MOB *monster = GetMob(entity.type());
+            if (monster != nullptr)
+                MobSprites.Touch(entity.id(), monster->Sprite, position);
             break;
+        }
 
-        case ActivatableEffects::Damage: {
-            MobInstance *mob = GetNearestMobInSight(player.Position);
-            if (mob != nullptr) {
-                mob->Health -= item->Value;
-                PlaySound(CreatureDamageSoundId);
-                AddEffect(player.Position, EffectType::ToTarget, item->Sprite, mob->Position, 1);
-                AddEffect(mob->Position, EffectType::RotateFade, item->Sprite, 1);
-            }
+        case net::ENTITY_KIND_DROP: {
+            Item *item = GetItem(entity.type());
+            if (item != nullptr)
+                DropSprites.Touch(entity.id(), item->Sprite, position);
             break;
         }
+
+        default: break;
     }
 }
 
-void GameState::PlaceItemDrop(TreasureInstance &item, Vector2 &dropPoint)
+void GameState::RemoveEntitySprite(const Serialize::EntityRef &entity)
 {
-    Item *itemRecord = GetItem(item.ItemId);
-    if (!itemRecord)
+    switch (entity.kind()) {
+        case net::ENTITY_KIND_PLAYER: OtherPlayerSprites.Remove(entity.id());
+            break;
+
+        case net::ENTITY_KIND_MOB: MobSprites.Remove(entity.id());
+            break;
+
+        case net::ENTITY_KIND_DROP: DropSprites.Remove(entity.id());
+            break;
+
+        default: break;
+    }
+}
+
+void GameState::ApplyWorldEvents(const Serialize::WorldEvents *events)
+{
+    // a level change comes on its own
+    if (events->level() != nullptr) {
+        LevelTick = events->tick();
+        StateTick = LevelTick;
+        RenderTick = LevelTick;
+        Snapshots.Clear();
+
+        LevelMoveSequence = MoveSequence;
+        CorrectionOffset = Vector2{0, 0};
+        LoadLevel(events->level()->c_str());
+        StartLevel();
+        return;
+    }
+
+    if (events->events() == nullptr)
         return;
 
-    bool valid = false;
-    while (!valid) {
-        float angle = float(GetRandomValue(-180, 180));
-        Vector2 vec = {cosf(angle * DEG2RAD), sinf(angle * DEG2RAD)};
-        vec = Vector2Add(dropPoint, Vector2Scale(vec, 45));
+    for (const Serialize::GameEvent *event : *events->events()) {
+        HandleWorldEvent(sim::Event{sim::EventType(event->type()),
+                                    uint8_t(event->flags()),
+                                    event->id(),
+                                    event->value(),
+                                    sim::Vec2{event->x(), event->y()},
+                                    sim::Vec2{event->target_x(), event->target_y()}});
+    }
+}
 
-        if (PointInMap(vec) && Vector2Distance(vec, Player1.Position) > PickupDistance &&
-            Vector2Distance(vec, Player2.Position) > PickupDistance) {
-            item.Position = vec;
-            valid = true;
+void GameState::HandleWorldEvents()
+{
+    std::string nextLevel;
+    for (const sim::Event &event : World.Events) {
+        if (event.Type == sim::EventType::LevelExit) {
+            if (event.Value >= 0 && event.Value < int(World.Exits.size()))
+                nextLevel = "maps/" + World.Exits[event.Value].Destination;
+            break;
         }
+
+        HandleWorldEvent(event);
     }
 
-    auto *sprite = AddSprite(itemRecord->Sprite, item.Position);
-    sprite->Shadow = true;
-    sprite->Bobble = true;
-    item.SpriteId = sprite->Id;
+    World.Events.clear();
 
-    ItemDrops.push_back(item);
+    if (!nextLevel.empty()) {
+        LoadLevel(nextLevel.c_str());
+        StartLevel();
+    }
 }
 
-void GameState::ActivateItem(Player &player, int slotIndex)
+void GameState::HandleWorldEvent(const sim::Event &event)
 {
-    if (slotIndex < 0 || slotIndex >= player.BackpackContents.size())
-        return;
+    Vector2 position = ToVector2(event.Position);
+    Vector2 target = ToVector2(event.Target);
 
-    InventoryContents &inventorySlot = player.BackpackContents[slotIndex];
+    switch (event.Type) {
+        case sim::EventType::MobAwoke: PlaySound(AlertSoundId);
+            AddEffect(position, EffectType::RiseFade, AwakeSprite, 1);
+            break;
 
-    Item *item = GetItem(inventorySlot.ItemId);
-    if (item == nullptr)
-        return;
+        case sim::EventType::PlayerAttacked: AddEffect(position, EffectType::ScaleFade, ClickTargetSprite);
+            if ((event.Flags & sim::EventFlagMelee) == 0)
+                AddEffect(target, EffectType::ToTarget, ProjectileSprite, position, 0.25f);
+
+            if (event.Value == 0) {
+                PlaySound(MissSoundId);
+            }
+            else {
+                PlaySound(HitSoundId);
+                PlaySound(CreatureDamageSoundId);
+                AddEffect(Vector2{position.x, position.y - 16}, EffectType::RiseFade, DamageSprite);
+            }
+            break;
 
-    TreasureInstance removedItem = player.RemoveInventoryItem(slotIndex, 1);
+        case sim::EventType::MobAttacked:
+            if ((event.Flags & sim::EventFlagMelee) != 0)
+                AddEffect(target, EffectType::RotateFade, MobAttackSprite);
+            else
+                AddEffect(position, EffectType::ToTarget, ProjectileSprite, target, 0.5f);
 
-    if (removedItem.Quantity == 0)
-        return;
+            if (event.Value == 0) {
+                PlaySound(MissSoundId);
+            }
+            else {
+                PlaySound(HitSoundId);
+                PlaySound(PlayerDamageSoundId);
+                AddEffect(Vector2{target.x, target.y - 16}, EffectType::RiseFade, DamageSprite);
+            }
+            break;
 
-    switch (item->ItemType) {
-        case ItemTypes::Activatable:UseConsumable(player, item);
-            removedItem.ItemId = -1;
-            removedItem.Quantity = 0;
+        case sim::EventType::MobDied: {
+            MOB *monster = GetMob(event.Value);
+            if (monster != nullptr)
+                AddEffect(position, EffectType::RotateFade, monster->Sprite, 3.5f);
             break;
+        }
 
-        case ItemTypes::Weapon: {
-            // save our current weapon
-            int weapon = player.EquippedWeapon;
+        case sim::EventType::ChestOpened: PlaySound(ChestOpenSoundId);
+            break;
 
-            // equip new weapon
-            player.EquippedWeapon = removedItem.ItemId;
+        case sim::EventType::LootDropped: AddEffect(position, EffectType::ScaleFade, LootSprite, 1);
+            break;
 
-            // replace the removed item with the old weapon
-            removedItem.ItemId = weapon;
+        case sim::EventType::ItemPickedUp: PlaySound(ItemPickupSoundId);
             break;
-        }
 
-        case ItemTypes::Armor: {
-            // save our current armor
-            int armor = player.EquippedArmor;
+        case sim::EventType::GoldPickedUp: PlaySound(CoinSoundId);
+            break;
 
-            // equip new weapon
-            player.EquippedArmor = removedItem.ItemId;
+        case sim::EventType::PlayerHealed: PlaySound(PlayerHealSoundId);
+            AddEffect(position, EffectType::RiseFade, HealingSprite, 2);
+            break;
 
-            // replace the removed item with the old weapon
-            removedItem.ItemId = armor;
+        case sim::EventType::SpellCast: {
+            Item *item = GetItem(event.Value);
+            PlaySound(CreatureDamageSoundId);
+            if (item != nullptr) {
+                AddEffect(position, EffectType::ToTarget, item->Sprite, target, 1);
+                AddEffect(target, EffectType::RotateFade, item->Sprite, 1);
+            }
             break;
         }
-    }
 
-    // put whatever we have back, or drop it
-    if (removedItem.ItemId != -1) {
-        // stick it back in our bag
-        if (!player.PickupItem(removedItem)) {
-            // no room, drop it
-            PlaceItemDrop(removedItem, player.Position);
-        }
-    }
-}
+        case sim::EventType::GameWon: EndGame(true, event.Value);
+            break;
 
-void GameState::DropItem(Player &player, int item)
-{
-    TreasureInstance drop = player.RemoveInventoryItem(item, 999);
-    PlaceItemDrop(drop, player.Position);
-}
+        case sim::EventType::GameLost: EndGame(false, event.Value);
+            break;
 
-const Player &GameState::GetPartner(Player &player)
-{
-    if (player.Id == 1)
-        return Player2;
-    return Player1;
+        // online the server sends the next level, locally HandleWorldEvents loads it
+        case sim::EventType::LevelExit: break;
+    }
 }
 
-void GameState::MovePlayer(Player &player)
+void GameState::UpdateSprites()
 {
-    // does the player want to move
-    if (player.TargetActive) {
-        Vector2 movement = Vector2Subtract(player.Target, player.Position);
-        float distance = Vector2Length(movement);
+    Player1.UpdateSprite();
 
-        float frameSpeed = GetFrameTime() * player.Speed;
+    if (Mode == GameMode::ONLINE) {
+        // we are drawn where we predicted plus what is left of the last correction, UpdateRemoteSprites does the rest
+        if (SpriteInstance *sprite = GetSprite(Player1.Sprite))
+            sprite->Position = Vector2Add(sprite->Position, CorrectionOffset);
+        return;
+    }
 
-        if (distance <= frameSpeed) {
-            player.Position = player.Target;
-            player.TargetActive = false;
-        }
-        else {
-            movement = Vector2Normalize(movement);
-            Vector2 newPos = Vector2Add(player.Position, Vector2Scale(movement, frameSpeed));
+    Player2.UpdateSprite();
 
-            if (!PointInMap(newPos)) {
-                player.TargetActive = false;
-            }
-            else {
-                player.Position = newPos;
-            }
-        }
+    MobSprites.Begin();
+    for (size_t i = 0; i < World.Mobs.Size(); i++) {
+        MOB *monster = GetMob(World.Mobs.MobIds[i]);
+        if (monster != nullptr)
+            MobSprites.Touch(World.Mobs.InstanceIds[i], monster->Sprite, ToVector2(World.Mobs.GetPosition(i)));
     }
+    MobSprites.End();
 
-    // see if the player entered an exit
-    for (auto &exit : Exits) {
-        if (CheckCollisionPointRec(player.Position, exit.Bounds)) {
-            player.Waiting = true;
-            player.TargetChest = nullptr;
-            player.TargetChest = nullptr;
-
-            if (GetPartner(player).Waiting) {
-                if (exit.Destination == "endgame") {
-                    EndGame(true, player.Gold + 100);
-                }
-                else {
-                    std::string map = "maps/" + exit.Destination;
-                    LoadLevel(map.c_str());
-                    StartLevel();
-                }
-            }
-            break;
-        }
+    DropSprites.Begin();
+    for (const sim::ItemDrop &drop : World.ItemDrops) {
+        Item *item = GetItem(drop.Item.ItemId);
+        if (item != nullptr)
+            DropSprites.Touch(drop.Id, item->Sprite, ToVector2(drop.Position));
     }
+    DropSprites.End();
 }
 
-void GameState::DropLoot(const char *contents, Vector2 &dropPoint)
+void GameState::UpdateGame()
 {
-    std::vector<TreasureInstance> loot = GetLoot(contents);
-    for (TreasureInstance &item : loot) {
-        PlaceItemDrop(item, dropPoint);
-        AddEffect(item.Position, EffectType::ScaleFade, LootSprite, 1);
+    if (IsKeyPressed(KEY_ESCAPE)) {
+
+        if (Player1.InventoryOpen || Player2.InventoryOpen) {
+            Player1.InventoryOpen = false;
+            Player2.InventoryOpen = false;
+        }
+        else {
+            PauseGame();
+            return;
+        }
     }
-}
 
-void GameState::ApplyAction(Player &player)
-{
+    if (!disableLostFocusPause && !IsWindowFocused()) {
+        PauseGame();
+        return;
+    }
 
-    // see if we want to attack any mobs
-    if (player.TargetMob != nullptr) {
-        // see if we can even attack.
-        if (GetGameTime() - player.LastAttack >= player.GetAttack().Cooldown) {
-            float distance = Vector2Distance(player.TargetMob->Position, player.Position);
-            if (distance < player.GetAttack().Range + 40) {
-                MOB *monsterInfo = GetMob(player.TargetMob->MobId);
-                if (monsterInfo != nullptr) {
-                    AddEffect(player.TargetMob->Position, EffectType::ScaleFade, ClickTargetSprite);
-                    if (!player.GetAttack().Melee)
-                        AddEffect(player.Position,
-                                  EffectType::ToTarget,
-                                  ProjectileSprite,
-                                  player.TargetMob->Position,
-                                  0.25f);
+    GetPlayerInput();
 
-                    int damage = ResolveAttack(player.GetAttack(), monsterInfo->Defense.Defense);
-                    if (damage == 0) {
-                        PlaySound(MissSoundId);
-                    }
-                    else {
-                        PlaySound(HitSoundId);
-                        PlaySound(CreatureDamageSoundId);
-                        AddEffect(Vector2{player.TargetMob->Position.x, player.TargetMob->Position.y - 16},
-                                  EffectType::RiseFade,
-                                  DamageSprite);
-                        player.TargetMob->Health -= damage;
+    // online the server ticks the world, its states correct our player and queue up for drawing everything else
+    if (Mode == GameMode::ONLINE)
+        PollServer();
 
-                        // if you hit them, they wake up!
-                        player.TargetMob->Triggered = true;
-                    }
-                }
-            }
+    if (Mode != GameMode::ONLINE && TickRate <= 0) {
+        // variable step, the simulation runs once per rendered frame
+        BeginSpriteTick();
+        Tick(GetFrameTime());
+        SetSpriteInterpolation(1);
+    }
+    else {
+        float step = GetTickStep();
+        TickAccumulator += GetFrameTime();
 
-            player.TargetMob = nullptr;
+        int ticks = 0;
+        while (TickAccumulator >= step && ticks < MaxTicksPerFrame) {
+            BeginSpriteTick();
+            if (Mode == GameMode::ONLINE)
+                PredictTick(step);
+            else
+                Tick(step);
+            TickAccumulator -= step;
+            ticks++;
         }
-    }
 
-    // see if the player is near the last clicked chest, if so open it
-    if (player.TargetChest != nullptr) {
-        Vector2 center = {player.TargetChest->Bounds.x + player.TargetChest->Bounds.width / 2,
-            player.TargetChest->Bounds.y + player.TargetChest->Bounds.height / 2};
-        float distance = Vector2Distance(center, player.Position);
-        if (distance <= 50) {
-            if (!player.TargetChest->Opened) {
-                PlaySound(ChestOpenSoundId);
-                player.TargetChest->Opened = true;
+        // too far behind to catch up (a hitch or a breakpoint), drop the backlog instead of spiraling
+        if (TickAccumulator >= step)
+            TickAccumulator = fmod(TickAccumulator, step);
 
-                DropLoot(player.TargetChest->Contents.c_str(), center);
-            }
-            player.TargetChest = nullptr;
-        }
+        SetSpriteInterpolation(float(TickAccumulator / step));
     }
 
+    if (Mode == GameMode::ONLINE) {
+        UpdateRemoteSprites(GetFrameTime());
 
-    // see if we are under any items to pickup
-    for (auto item = ItemDrops.begin(); item != ItemDrops.end();) {
-        float distance = Vector2Distance(item->Position, player.Position);
-        if (distance <= PickupDistance) {
-            if (player.PickupItem(*item)) {
-                RemoveSprite(item->SpriteId);
-                item = ItemDrops.erase(item);
-                continue;
-            }
-        }
-
-        item++;
+        // input, moves and acks queued this frame go out together
+        ENetClient->Flush();
     }
 
-    float time = GetGameTime();
+    // the camera follows where the players are drawn, not where the last tick left them
+    if (const SpriteInstance *sprite = GetSprite(Player1.Sprite))
+        SetVisiblePoint(GetSpriteDrawPosition(*sprite));
+    if (const SpriteInstance *sprite = GetSprite(Player2.Sprite))
+        SetVisiblePoint(GetSpriteDrawPosition(*sprite));
+}
+
+void GameState::Tick(float deltaTime)
+{
+    World.Tick(deltaTime);
+    HandleWorldEvents();
 
-    float attackTime = time - player.LastAttack;
-    float itemTime = time - player.LastConsumeable;
+    UpdateSprites();
+    UpdateEffects(deltaTime);
+}
 
-    if (attackTime >= player.GetAttack().Cooldown)
-        player.AttackCooldown = 0;
-    else
-        player.AttackCooldown = 1.0f - (attackTime / player.AttackCooldown);
+void GameState::SetTickRate(float ticksPerSecond)
+{
+    TickRate = ticksPerSecond > 0 ? ticksPerSecond : 0;
+    TickAccumulator = 0;
+}
 
-    float itemCooldown = 1;
+float GameState::GetTickStep() const
+{
+    // our moves have to line up one to one with the server's ticks
+    if (Mode == GameMode::ONLINE)
+        return 1.0f / net::SERVER_TICK_RATE;
 
-    if (itemTime >= itemCooldown)
-        player.ItemCooldown = 0;
-    else
-        player.ItemCooldown = 1.0f - (itemTime / itemCooldown);
-
-    if (player.BuffLifetimeLeft > 0) {
-        player.BuffLifetimeLeft -= GetFrameTime();
-        if (player.BuffLifetimeLeft <= 0) {
-            player.BuffDefense = 0;
-            player.BuffItem = -1;
-            player.BuffLifetimeLeft = 0;
-        }
-    }
-}
\ No newline at end of file
+    return TickRate > 0 ? 1.0f / TickRate : GetFrameTime();
+}
+
+float GameState::GetMoveUnit() const
+{
+    // keyboard movement aims this far ahead each frame, it has to cover a whole tick of movement
+    // or slow tick rates would also slow the players down
+    return std::max(MoveUnit, std::max(Player1.Speed, Player2.Speed) * GetTickStep());
+}
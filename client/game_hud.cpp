@@ -26,9 +26,18 @@
 #include "game_hud.h"
 #include "items.h"
 #include "resource_ids.h"
+#include "sprite_batch.h"
 
 #include "raylib.h"
 
+// the hud is queued in these layers, its text goes over all of them once they are flushed
+constexpr SpriteLayer HudBackgroundLayer = 0;
+constexpr SpriteLayer HudPanelLayer = 1;
+constexpr SpriteLayer HudSlotShadowLayer = 2;
+constexpr SpriteLayer HudSlotLayer = 3;
+constexpr SpriteLayer HudIconLayer = 4;
+constexpr SpriteLayer HudOverlayLayer = 5;
+
 GameHudScreen::GameHudScreen(Player &player1, Player &player2)
     : Screen(), Player1(player1), Player2(player2)
 {
@@ -43,14 +52,29 @@ void GameHudScreen::ShowItemToolTip(const Item *item, const Rectangle &rect)
     DrawText(item->Name.c_str(), int(rect.x), int(rect.y), 10, WHITE);
 }
 
+void GameHudScreen::QueueText(const char *text, int x, int y, int fontSize, Color color)
+{
+    Texts.push_back(HudText{text, x, y, fontSize, color});
+}
+
+void GameHudScreen::FlushHud()
+{
+    FlushSpriteBatch();
+
+    for (const HudText &text : Texts)
+        DrawText(text.Text.c_str(), text.X, text.Y, text.FontSize, text.Tint);
+
+    Texts.clear();
+}
+
 void GameHudScreen::DrawInventory(Player &player)
 {
     Rectangle inventoryWindowRect = {GetScreenWidth() - 475.0f, GetScreenHeight() - 500.0f, 354, 400.0f};
     Rectangle shadowRect = inventoryWindowRect;
     shadowRect.x += 10;
     shadowRect.y += 10;
-    DrawRectangleRec(shadowRect, ColorAlpha(DARKBROWN, 0.5f));
-    FillRectWithSprite(InventoryBackgroundSprite, inventoryWindowRect);
+    QueueRectangle(shadowRect, ColorAlpha(DARKBROWN, 0.5f), HudBackgroundLayer);
+    QueueFillRectWithSprite(InventoryBackgroundSprite, inventoryWindowRect, HudPanelLayer);
 
     // equipment
     Item *weaponItem = GetItem(player.EquippedWeapon);
@@ -62,13 +86,13 @@ void GameHudScreen::DrawInventory(Player &player)
                    GRAY)) {
         HoveredItem = weaponItem;
     }
-    DrawText(player.Name.c_str(), int(inventoryWindowRect.x) + 8, int(inventoryWindowRect.y) + 3, 15, DARKBROWN);
-    DrawText("Weapon",
+    QueueText(player.Name.c_str(), int(inventoryWindowRect.x) + 8, int(inventoryWindowRect.y) + 3, 15, DARKBROWN);
+    QueueText("Weapon",
              int(inventoryWindowRect.x + 20 + ButtonSize + 2),
              int(inventoryWindowRect.y + 20),
              20,
              DARKBROWN);
-    DrawText(TextFormat("%d - %d", player.GetAttack().MinDamage, player.GetAttack().MaxDamage),
+    QueueText(TextFormat("%d - %d", player.GetAttack().MinDamage, player.GetAttack().MaxDamage),
              int(inventoryWindowRect.x + 20 + ButtonSize + 2),
              int(inventoryWindowRect.y + 40),
              20,
@@ -83,12 +107,12 @@ void GameHudScreen::DrawInventory(Player &player)
                    BROWN)) {
         HoveredItem = armorItem;
     }
-    DrawText("Armor",
+    QueueText("Armor",
              int(inventoryWindowRect.x + inventoryWindowRect.width - (20 + ButtonSize + 62)),
              int(inventoryWindowRect.y + ButtonSize),
              20,
              DARKBROWN);
-    DrawText(TextFormat("%d", player.GetDefense()),
+    QueueText(TextFormat("%d", player.GetDefense()),
              int(inventoryWindowRect.x + inventoryWindowRect.width - (20 + ButtonSize + 22)),
              int(inventoryWindowRect.y + ButtonSize - 20),
              20,
@@ -98,7 +122,7 @@ void GameHudScreen::DrawInventory(Player &player)
     constexpr int inventoryItemSize = 64;
     constexpr int inventoryItemPadding = 4;
 
-    DrawText("Backpack (LMB)Use/Equip (RMB)Drop",
+    QueueText("Backpack (LMB)Use/Equip (RMB)Drop",
              int(inventoryWindowRect.x + 10),
              int(inventoryWindowRect.y + 100),
              10,
@@ -117,16 +141,19 @@ void GameHudScreen::DrawInventory(Player &player)
             shadowRect.x += 2;
             shadowRect.y += 2;
 
-            DrawRectangleRec(shadowRect, ColorAlpha(BLACK, 0.5f));
-            FillRectWithSprite(ItemBackgroundSprite, itemRect);
+            QueueRectangle(shadowRect, ColorAlpha(BLACK, 0.5f), HudSlotShadowLayer);
+            QueueFillRectWithSprite(ItemBackgroundSprite, itemRect, HudSlotLayer);
 
             if (itemIndex < player.BackpackContents.size()) {
                 Item *item = GetItem(player.BackpackContents[itemIndex].ItemId);
                 if (item != nullptr) {
-                    DrawSprite(item->Sprite, itemRect.x + itemRect.width / 2, itemRect.y + itemRect.height / 2);
+                    QueueSprite(item->Sprite,
+                                itemRect.x + itemRect.width / 2,
+                                itemRect.y + itemRect.height / 2,
+                                HudIconLayer);
 
                     if (player.BackpackContents[itemIndex].Quantity > 1)
-                        DrawText(TextFormat("%d", player.BackpackContents[itemIndex].Quantity),
+                        QueueText(TextFormat("%d", player.BackpackContents[itemIndex].Quantity),
                                  int(itemRect.x) + 2,
                                  int(itemRect.y + itemRect.height - 10),
                                  10,
@@ -136,7 +163,6 @@ void GameHudScreen::DrawInventory(Player &player)
 
                     if (hovered) {
                         HoveredItem = item;
-                        Positions positions{Player1.Position, Player2.Position};
 
                         if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
                             if (item->IsActivatable())
@@ -155,6 +181,8 @@ void GameHudScreen::DrawInventory(Player &player)
             itemIndex++;
         }
     }
+
+    FlushHud();
 }
 
 void GameHudScreen::Draw()
@@ -166,20 +194,20 @@ void GameHudScreen::Draw()
 void GameHudScreen::Draw(Player &player, float barHeight)
 {
     // background
-    DrawRectangleRec(Rectangle{0, barHeight, float(GetScreenWidth()), 80}, ColorAlpha(DARKGRAY, 0.25f));
+    QueueRectangle(Rectangle{0, barHeight, float(GetScreenWidth()), 80}, ColorAlpha(DARKGRAY, 0.25f), HudBackgroundLayer);
 
     // score
-    DrawSprite(CoinSprite, GetScreenWidth() - 200.0f, barHeight + 40.0f, 4);
-    DrawText(TextFormat("x %03d", player.Gold), GetScreenWidth() - 170, int(barHeight + 20), 40, WHITE);
+    QueueSprite(CoinSprite, GetScreenWidth() - 200.0f, barHeight + 40.0f, HudIconLayer, 4);
+    QueueText(TextFormat("x %03d", player.Gold), GetScreenWidth() - 170, int(barHeight + 20), 40, WHITE);
 
     // health bar
-    DrawText(player.Name.c_str(), 20, int(barHeight + 5), 20, RED);
+    QueueText(player.Name.c_str(), 20, int(barHeight + 5), 20, RED);
 
     float healthBarWidth = 300;
-    DrawRectangleLinesEx(Rectangle{20, barHeight + 30, healthBarWidth, 32}, 1, WHITE);
+    QueueRectangleLines(Rectangle{20, barHeight + 30, healthBarWidth, 32}, 1, WHITE, HudSlotLayer);
 
-    float healthPram = player.Health / float(MaxHealth);
-    DrawRectangleRec(Rectangle{22, barHeight + 32, healthBarWidth * healthPram - 4, 28}, RED);
+    float healthPram = player.Health / float(sim::MaxHealth);
+    QueueRectangle(Rectangle{22, barHeight + 32, healthBarWidth * healthPram - 4, 28}, RED, HudSlotLayer);
 
     // clear the hover item from last frame
     HoveredItem = nullptr;
@@ -194,8 +222,9 @@ void GameHudScreen::Draw(Player &player, float barHeight)
 
     if (player.AttackCooldown > 0) {
         float height = ButtonSize * player.AttackCooldown;
-        DrawRectangleRec(Rectangle{buttonX, buttonY + (ButtonSize - height), ButtonSize, height},
-                         ColorAlpha(RED, 0.5f));
+        QueueRectangle(Rectangle{buttonX, buttonY + (ButtonSize - height), ButtonSize, height},
+                       ColorAlpha(RED, 0.5f),
+                       HudOverlayLayer);
     }
 
     std::vector<int> activatableItems;
@@ -226,16 +255,16 @@ void GameHudScreen::Draw(Player &player, float barHeight)
                 }
             }
 
-            DrawText(TextFormat("%d", i + 1), int(buttonX), int(buttonY), 20, WHITE);
+            QueueText(TextFormat("%d", i + 1), int(buttonX), int(buttonY), 20, WHITE);
 
             if (player.ItemCooldown > 0) {
                 float height = ButtonSize * player.ItemCooldown;
-                DrawRectangleRec(Rectangle{buttonX, buttonY + (ButtonSize - height), ButtonSize, height},
-                                 ColorAlpha(BLACK, 0.5f));
+                QueueRectangle(Rectangle{buttonX, buttonY + (ButtonSize - height), ButtonSize, height},
+                               ColorAlpha(BLACK, 0.5f),
+                               HudOverlayLayer);
             }
         }
     }
-    Positions positions{Player1.Position, Player2.Position};
 
     if (activatedItem != -1) {
         player.ActivateItem(activatedItem);
@@ -254,10 +283,13 @@ void GameHudScreen::Draw(Player &player, float barHeight)
 
     // buff icon
     if (player.BuffLifetimeLeft > 0) {
-        DrawSprite(player.BuffItem, buttonX + ButtonSize / 2, buttonY + ButtonSize / 2, 0, 2);
-        DrawText(TextFormat("%0.0f", player.BuffLifetimeLeft), int(buttonX), int(buttonY + ButtonSize - 30), 30, RED);
+        QueueSprite(player.BuffItem, buttonX + ButtonSize / 2, buttonY + ButtonSize / 2, HudIconLayer, 0, 2);
+        QueueText(TextFormat("%0.0f", player.BuffLifetimeLeft), int(buttonX), int(buttonY + ButtonSize - 30), 30, RED);
     }
 
+    // the bar goes out before the inventory, which can cover it
+    FlushHud();
+
     if (player.InventoryOpen)
         DrawInventory(player);
 
@@ -275,18 +307,18 @@ void GameHudScreen::Draw(Player &player, float barHeight)
 bool GameHudScreen::DrawButton(float x, float y, int sprite, int quantity, Color border, Color center)
 {
     Rectangle buttonRect = {x, y, ButtonSize, ButtonSize};
-    DrawRectangleRec(buttonRect, border);
-    DrawRectangleRec(Rectangle{x + ButtonInset, y + ButtonInset, ButtonSize - ButtonInset * 2,
-        ButtonSize - ButtonInset * 2}, center);
+    QueueRectangle(buttonRect, border, HudSlotLayer);
+    QueueRectangle(Rectangle{x + ButtonInset, y + ButtonInset, ButtonSize - ButtonInset * 2,
+        ButtonSize - ButtonInset * 2}, center, HudSlotLayer);
 
     if (sprite != -1) {
         Vector2 center = {x + ButtonSize / 2, y + ButtonSize / 2};
-        DrawSprite(sprite, center.x + 2, center.y + 2, 0, 2, BLACK);
-        DrawSprite(sprite, center.x, center.y, 0, 2);
+        QueueSprite(sprite, center.x + 2, center.y + 2, HudIconLayer, 0, 2, BLACK);
+        QueueSprite(sprite, center.x, center.y, HudIconLayer, 0, 2);
     }
 
     if (quantity > 1) {
-        DrawText(TextFormat("X%d", quantity), int(x + ButtonSize / 2), int(y + ButtonSize - 22), 20, WHITE);
+        QueueText(TextFormat("X%d", quantity), int(x + ButtonSize / 2), int(y + ButtonSize - 22), 20, WHITE);
     }
 
     return CheckCollisionPointRec(GetMousePosition(), buttonRect);
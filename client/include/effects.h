@@ -0,0 +1,85 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <stddef.h>
+#include <array>
+#include <vector>
+
+enum class EffectType
+{
+    Fade,
+    RiseFade,
+    RotateFade,
+    ScaleFade,
+    ToTarget,
+};
+
+constexpr size_t EffectTypeCount = 5;
+
+// how many effects of one type can play at once, more than that are dropped
+constexpr size_t MaxEffectsPerType = 2048;
+
+// every effect of one type, a field per array. the first Count entries are live, an effect that ends has the last one
+// moved into its place
+struct EffectArrays
+{
+    size_t Count = 0;
+
+    std::vector<Vector2> Positions;
+    std::vector<Vector2> Targets;
+    std::vector<float> Lifetimes;
+    std::vector<float> MaxLifetimes;
+    std::vector<int> SpriteIds;
+
+    // how each one is drawn, worked out when it ages
+    std::vector<Vector2> DrawPositions;
+    std::vector<float> Rotations;
+    std::vector<float> Scales;
+    std::vector<float> Alphas;
+};
+
+// effects age with the simulation tick, drawing only reads what the tick left behind
+class EffectSystem
+{
+public:
+    explicit EffectSystem(size_t capacityPerType = MaxEffectsPerType);
+
+    // false when the type is full and the effect was dropped
+    bool Add(const Vector2 &position, EffectType effect, int spriteId, const Vector2 &target, float lifetime);
+
+    void Update(float deltaTime);
+    void Clear();
+
+    size_t Size() const;
+    const EffectArrays &Get(EffectType effect) const;
+
+private:
+    std::array<EffectArrays, EffectTypeCount> Effects;
+    size_t Capacity = 0;
+};
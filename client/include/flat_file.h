@@ -0,0 +1,53 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Helpers shared by the flat formats that are memory mapped and used in place (compiled maps, sprite tables).
+// Every section starts on a 4 byte boundary and is written at its offset from the start of the file.
+
+inline bool SectionInFile(uint32_t offset, uint32_t count, size_t itemSize, size_t fileSize)
+{
+	return offset % 4 == 0 && offset <= fileSize && uint64_t(count) * itemSize <= fileSize - offset;
+}
+
+inline uint32_t AlignSection(uint32_t offset)
+{
+	return (offset + 3) & ~3u;
+}
+
+template<typename T>
+inline bool WriteSection(FILE* file, const std::vector<T>& items, uint32_t offset)
+{
+	if (fseek(file, long(offset), SEEK_SET) != 0)
+		return false;
+
+	return items.empty() || fwrite(items.data(), sizeof(T), items.size(), file) == items.size();
+}
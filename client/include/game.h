@@ -26,7 +26,13 @@
 #pragma once
 
 
+#include "extra.h"
 #include "player.h"
+#include "world.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 // Prevent Raylib.h's collision with windows.h https://github.com/raysan5/raylib/issues/1217
 #if defined(_WIN32)           
@@ -35,63 +41,165 @@
 #endif
 
 #include "net.h"    
+#include "snapshot.h"
 
 #if defined(_WIN32)       // raylib uses these names as function parameters
 #undef near
 #undef far
 #endif
 
+constexpr float DefaultTickRate = 60;
+
+// online our own player moves as soon as a key is held and the server's states only correct it,
+// moves are kept this many ticks so the ones the server hasn't applied yet can be replayed on top of a state
+constexpr uint32_t MoveHistorySize = 128;
+
+// a correction shorter than this is faded out instead of jumping the player to where the server has it
+constexpr float MaxSmoothedCorrection = 48;
+
+// seconds for a faded correction to halve
+constexpr float CorrectionHalfLife = 0.05f;
+
+// everything else is drawn this many server ticks behind the newest state, so a state that arrives late
+// still lands between two that are already here
+constexpr double InterpolationDelayTicks = 6;
+
+// sprites for the things the world only knows by id, kept in step with it after every tick
+class EntitySprites
+{
+public:
+    // call before touching everything that still exists
+    void Begin();
+
+    // the sprite for an id, added the first time the id is seen. the pointer is good until a sprite is added or removed
+    SpriteInstance *Touch(uint32_t id, int frame, const Vector2 &position);
+
+    // removes the sprites of anything that wasn't touched since Begin
+    void End();
+
+    // moves the sprite for an id if it has one, nullptr otherwise
+    SpriteInstance *Move(uint32_t id, int frame, const Vector2 &position);
+    void Remove(uint32_t id);
+
+    // forgets every sprite without removing it, for when the map already cleared them
+    void Clear();
+
+private:
+    struct Entry
+    {
+        SpriteHandle Sprite;
+        uint32_t Stamp = 0;
+    };
+
+    std::unordered_map<uint32_t, Entry> Sprites;
+    uint32_t Stamp = 0;
+};
+
 class GameState
 {
 public:
     GameState();
-    void InitGame(GameMode mode, uint8_t playerId);
+    void InitGame(GameMode mode, sim::PlayerId playerId, net::RoomId room = net::ANY_ROOM);
     void QuitGame();
     void UpdateGame();
 
+    // the simulation runs in fixed steps, a rate of 0 steps once per rendered frame instead
+    void SetTickRate(float ticksPerSecond);
+    float GetTickRate() const { return TickRate; }
+    void Tick(float deltaTime);
+
     void LoadLevel(const char *level);
     void StartLevel();
 
     void GetPlayerInput();
-    void GetPlayerInput(Player &player);
 
-    void UpdateMobs();
-    void CullDeadMobs();
-    void UpdateMobSprites();
-    Player *GetClosestPlayer(const Vector2 &position);
+    void ActivateItem(Player &player, int slotIndex);
+    void DropItem(Player &player, int slotIndex);
+
+    Player *GetPlayer(uint32_t id);
 
-    const Player &GetPartner(Player &player);
+    // online Player2 is the first other player the server tells us about, the rest are only drawn
+    void ChoosePartner(const net::Snapshot &snapshot);
 
+    // plays the sounds and effects for what the world did, and changes level when it asks
+    void HandleWorldEvents();
+    void HandleWorldEvent(const sim::Event &event);
     void UpdateSprites();
-    void MovePlayer(Player &player);
-    void ApplyAction(Player &player);
-    void UseConsumable(Player &player, Item *item);
-    MobInstance *GetNearestMobInSight(Vector2 &position);
 
-    void ActivateItem(Player &player, int slotIndex);
-    void DropItem(Player &player, int item);
-    void PlaceItemDrop(TreasureInstance &item, Vector2 &dropPoint);
-    void DropLoot(const char *contents, Vector2 &dropPoint);
+    // online the server runs the world, this one only holds what it last sent
+    void PollServer();
+    void SendInput();
+    void ApplyWorldState(const Serialize::WorldState *state);
+    void ApplySnapshot(const net::Snapshot &snapshot);
+    void ApplyWorldEvents(const Serialize::WorldEvents *events);
+
+    // online we walk our own player every tick like the server will, and replay what it hasn't seen on each state
+    void PredictTick(float deltaTime);
+    void ApplyMove(const Serialize::MoveStep &step, float deltaTime);
+    void ReconcilePlayer(uint32_t moveAck, const Vector2 &drawnPosition);
+
+    // everyone and everything else is drawn between the two states around RenderTick
+    void UpdateRemoteSprites(float deltaTime);
+
+    // online sprites come and go as things enter and leave our view, states only move them
+    void ApplyInterest(const Serialize::Interest *interest);
+    void AddEntitySprite(const Serialize::EntityRef &entity);
+    void RemoveEntitySprite(const Serialize::EntityRef &entity);
 
     Player Player1;
     Player Player2;
 
-    double GameClock = 0;
-    std::vector<Exit> Exits;
-    std::vector<Chest> Chests;
-    std::vector<TreasureInstance> ItemDrops;
-    std::vector<MobInstance> Mobs;
+    sim::World World;
+    sim::CollisionMode CollisionMode = sim::CollisionMode::Bitmap;
+
+    EntitySprites MobSprites;
+    EntitySprites DropSprites;
+    EntitySprites OtherPlayerSprites;
 
     std::function<void()> PauseGame;
     std::function<void(bool, int)> EndGame;
 
     float GetGameTime();
+    float GetTickStep() const;
+    float GetMoveUnit() const;
     const float MoveUnit = 2.0f;
+
+    float TickRate = DefaultTickRate;
+    double TickAccumulator = 0;
+    int MaxTicksPerFrame = 8;
+
     std::shared_ptr<net::ENetClient> ENetClient;
-    GameMode Mode;
+    net::MessageDispatcher Dispatcher;
+    GameMode Mode = GameMode::LOCAL;
+
+    // what the local player asked for since the last input went to the server
+    net::InputCommand Input;
+    uint32_t InputSequence = 0;
+
+    // the direction keys held, as an offset from wherever the player is when the next tick makes a move of it
+    bool MoveHeld = false;
+    Vector2 MoveOffset = {0, 0};
+
+    // our own moves by sequence, moves from before LevelMoveSequence belong to the last level and are never replayed
+    std::vector<Serialize::MoveStep> MoveHistory = std::vector<Serialize::MoveStep>(MoveHistorySize);
+    uint32_t MoveSequence = 0;
+    uint32_t LevelMoveSequence = 0;
+
+    // how far from its position our player is drawn, what is left of the last correction
+    Vector2 CorrectionOffset = {0, 0};
+
+    // the server tick everything else is drawn at, kept InterpolationDelayTicks behind the newest state
+    double RenderTick = 0;
+
+    // the server tick the current level started on, states from before it are for the old level
+    uint32_t LevelTick = 0;
+
+    // the newest state we have and the ones before it, the server sends each state as changes against one we acked
+    uint32_t StateTick = 0;
+    net::SnapshotHistory Snapshots{net::CLIENT_SNAPSHOT_HISTORY};
 };
 
 inline float GameState::GetGameTime()
 {
-    return (float) GameClock;
-}
\ No newline at end of file
+    return World.GetGameTime();
+}
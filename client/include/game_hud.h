@@ -29,6 +29,9 @@
 #include "player.h"
 #include "items.h"
 
+#include <string>
+#include <vector>
+
 class GameHudScreen: public Screen
 {
 public:
@@ -43,6 +46,21 @@ private:
     void DrawInventory(Player &player);
     void ShowItemToolTip(const Item *item, const Rectangle &rect);
 
+    // text isn't batched, it waits until the sprites and shapes under it are flushed
+    void QueueText(const char *text, int x, int y, int fontSize, Color color);
+    void FlushHud();
+
+    struct HudText
+    {
+        std::string Text;
+        int X = 0;
+        int Y = 0;
+        int FontSize = 10;
+        Color Tint = WHITE;
+    };
+
+    std::vector<HudText> Texts;
+
     float ButtonSize = 70;
     float ButtonInset = 6;
     const Item *HoveredItem = nullptr;
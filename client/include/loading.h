@@ -29,3 +29,5 @@ void UpdateLoad(std::function<void()> onFinished, std::shared_ptr<LoadingScreen>
 void InitResources();
 void CleanupResources();
 
+const Texture& GetTexture(int id);
+
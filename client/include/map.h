@@ -27,7 +27,10 @@
 
 #include "raylib.h"
 #include "tile_map.h"
+#include "map_data.h"
+#include "effects.h"
 
+#include <stdint.h>
 #include <vector>
 
 // map basics
@@ -43,42 +46,47 @@ void SetVisiblePoint(const Vector2& point);
 std::vector<const TileObject*> GetMapObjectsOfType(const char* objType, TileObject::SubTypes requiredType = TileObject::SubTypes::None);
 const TileObject* GetFirstMapObjectOfType(const char* objType, TileObject::SubTypes requiredType = TileObject::SubTypes::None);
 
-// map collisions
-bool PointInMap(const Vector2& point);
-bool Ray2DHitsMap(const Vector2& startPoint, const Vector2& endPoint);
+// the map's objects and bounds for the simulation, collision is built from these
+sim::MapData GetMapData();
 
 // map sprites
 struct SpriteInstance
 {
-	int Id = -1;
 	bool Active = true;
 	int SpriteFrame = -1;
 	Vector2 Position = { 0,0 };
 	Color Tint = WHITE;
 	bool Bobble = false;
 	bool Shadow = true;
+
+	// where the sprite was at the start of the current simulation tick, drawing blends from here to Position
+	Vector2 PreviousPosition = { 0,0 };
 };
 
-SpriteInstance* AddSprite(int frame, const Vector2& position);
-void UpdateSprite(int spriteId, const Vector2& position);
-void RemoveSprite(SpriteInstance* sprite);
-void RemoveSprite(int id);
+// names a sprite for as long as it is on the map, once it is removed or the map cleared the handle finds nothing
+struct SpriteHandle
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+};
+
+SpriteHandle AddSprite(int frame, const Vector2& position);
+
+// nullptr for a stale handle, the pointer is only good until the next sprite is added or removed
+SpriteInstance* GetSprite(SpriteHandle handle);
+
+void UpdateSprite(SpriteHandle handle, const Vector2& position);
+void RemoveSprite(SpriteHandle handle);
 void ClearSprites();
 
+// fixed tick interpolation, sprites are drawn between their last two tick positions
+void BeginSpriteTick();
+void ResetSpriteInterpolation();
+void SetSpriteInterpolation(float alpha);
+Vector2 GetSpriteDrawPosition(const SpriteInstance& sprite);
+
 // Effects
-enum class EffectType
-{
-	Fade,
-	RiseFade,
-	RotateFade,
-	ScaleFade,
-	ToTarget,
-};
 void AddEffect(const Vector2& position, EffectType effect, int spriteId, float lifetime = 1);
 void AddEffect(const Vector2& position, EffectType effect, int spriteId, const Vector2& target, float lifetime = 1);
+void UpdateEffects(float deltaTime);
 
-// common object types
-constexpr char PlayerSpawnType[] = "player_spawn";
-constexpr char MobSpawnType[] = "mob_spawn";
-constexpr char ChestType[] = "chest";
-constexpr char ExitType[] = "exit";
\ No newline at end of file
@@ -0,0 +1,56 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// a read only view of a whole file, mapped into memory by the OS
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* filePath);
+	void Close();
+
+	inline bool IsOpen() const { return Data != nullptr; }
+	inline const uint8_t* GetData() const { return Data; }
+	inline size_t GetSize() const { return Size; }
+
+private:
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+
+#if defined(_WIN32)
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,50 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+#include "sim_math.h"
+
+// the simulation keeps its own vector types so the server doesn't need raylib, these move between the two
+inline Vector2 ToVector2(const sim::Vec2 &v)
+{
+    return Vector2{v.x, v.y};
+}
+
+inline sim::Vec2 ToVec2(const Vector2 &v)
+{
+    return sim::Vec2{v.x, v.y};
+}
+
+inline Rectangle ToRectangle(const sim::Rect &rect)
+{
+    return Rectangle{rect.x, rect.y, rect.width, rect.height};
+}
+
+inline sim::Rect ToRect(const Rectangle &rect)
+{
+    return sim::Rect{rect.x, rect.y, rect.width, rect.height};
+}
@@ -0,0 +1,69 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <string>
+#include <vector>
+
+// the sprite table rpg_atlas_builder writes next to the atlases, under the resource folder
+constexpr char SpriteTableFile[] = "sprites.atlas";
+
+// how the builder slices the art, read from the resource folder
+constexpr char SpriteListFile[] = "sprites.txt";
+
+// one sprite, where it is in which atlas and the same drawing info the game keeps per sprite
+struct AtlasSprite
+{
+	int Atlas = 0;
+	Rectangle SourceRect = { 0,0,0,0 };
+	Vector2 Origin = { 0,0 };
+	Rectangle Borders = { 0,0,0,0 };
+};
+
+// a png the sprites were cut from, its sprites are a range of the table
+struct AtlasSource
+{
+	std::string File;
+	int FirstSprite = 0;
+	int SpriteCount = 0;
+};
+
+// sprites are in id order, so the first source's first frame is sprite 0
+struct SpriteTable
+{
+	std::vector<std::string> Atlases;
+	std::vector<AtlasSource> Sources;
+	std::vector<AtlasSprite> Sprites;
+};
+
+// file paths in the table are relative to the folder the table is in
+bool ReadSpriteTable(const char* filePath, SpriteTable& table);
+bool WriteSpriteTable(const char* filePath, const SpriteTable& table);
+
+// false when any png the table was built from changed since
+bool SpriteTableIsCurrent(const char* filePath, const SpriteTable& table);
@@ -0,0 +1,76 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <stdint.h>
+
+// queued quads are drawn lowest layer first, then lowest depth first. quads with the same layer and depth are grouped
+// by texture and otherwise keep the order they were queued in, so something that has to cover a different texture
+// needs a higher layer or depth
+using SpriteLayer = uint16_t;
+using SpriteDepth = uint16_t;
+
+// the map's tile layers count up from here, in the order the map draws them
+constexpr SpriteLayer MapTileLayer = 0;
+
+constexpr SpriteLayer MapShadowLayer = 0x100;
+constexpr SpriteLayer MapSpriteLayer = 0x101;
+constexpr SpriteLayer MapEffectLayer = 0x102;
+
+// what the batch sent to rlgl since the last reset, a draw call is counted for every change of texture and every
+// time rlgl's vertex buffer filled up
+struct SpriteBatchStats
+{
+    uint32_t Quads = 0;
+    uint32_t Vertices = 0;
+    uint32_t DrawCalls = 0;
+};
+
+// like DrawTexturePro, a negative source width or height flips the texture
+void QueueTexture(const Texture2D &texture,
+                  Rectangle source,
+                  const Rectangle &destination,
+                  const Vector2 &origin,
+                  float rotation,
+                  Color tint,
+                  SpriteLayer layer,
+                  SpriteDepth depth = 0);
+
+// an axis aligned quad with the texture coordinates already worked out
+void QueueTextureQuad(unsigned int textureId, const Rectangle &destination, const Rectangle &coords, Color tint, SpriteLayer layer);
+
+// solid shapes, drawn with rlgl's default white texture
+void QueueRectangle(const Rectangle &rect, Color color, SpriteLayer layer);
+void QueueRectangleLines(const Rectangle &rect, float thickness, Color color, SpriteLayer layer);
+
+// sorts everything queued and hands it to rlgl, call it before anything drawn on top that doesn't go through the
+// batch and before leaving the camera or texture mode it was queued in
+void FlushSpriteBatch();
+
+void ResetSpriteBatchStats();
+const SpriteBatchStats &GetSpriteBatchStats();
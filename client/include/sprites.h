@@ -1,6 +1,8 @@
 #pragma once
 
 #include "raylib.h"
+#include "sprite_batch.h"
+#include "sprite_atlas.h"
 
 #include <stdint.h>
 
@@ -10,10 +12,17 @@
 #define SpriteFlipDiagonal 0x08
 
 void LoadSpriteFrames(int textureId, int colums, int rows, int spacing);
+
+// every sprite in a table from rpg_atlas_builder, its atlases loaded in order from firstTextureId
+void LoadSpriteFrames(int firstTextureId, const SpriteTable& table);
 void SetSpriteOrigin(int spriteId, int x, int y);
 void SetSpriteBorders(int spriteId, int left, int top, int right, int bottom);
 void SetSpriteBorders(int spriteId, int inset);
 void CenterSprite(int spriteId);
 
 void DrawSprite(int spriteId, float x, float y, float rotation = 0, float scale = 1, Color tint = { 255, 255, 255, 255 }, uint8_t flip = SpriteFlipNone);
-void FillRectWithSprite(int spriteId, const Rectangle& rect, Color tint = { 255, 255, 255, 255 }, uint8_t flip = SpriteFlipNone);
\ No newline at end of file
+void FillRectWithSprite(int spriteId, const Rectangle& rect, Color tint = { 255, 255, 255, 255 }, uint8_t flip = SpriteFlipNone);
+
+// the same as the draws above, but queued in the sprite batch until it is flushed
+void QueueSprite(int spriteId, float x, float y, SpriteLayer layer, float rotation = 0, float scale = 1, Color tint = { 255, 255, 255, 255 }, uint8_t flip = SpriteFlipNone, SpriteDepth depth = 0);
+void QueueFillRectWithSprite(int spriteId, const Rectangle& rect, SpriteLayer layer, Color tint = { 255, 255, 255, 255 });
\ No newline at end of file
@@ -47,6 +47,11 @@ struct Tile
 	uint8_t Flip = SpriteFlipNone;
 };
 
+// compiled maps store tiles with this exact layout so they can be used in place
+static_assert(sizeof(Tile) == 4, "Tile layout must match the compiled map format");
+
+class MappedFile;
+
 class Layer
 {
 public:
@@ -57,11 +62,50 @@ public:
 	bool IsObject = false;
 };
 
+// tile layers are split into square blocks of tiles so drawing only has to visit the blocks the camera can see
+constexpr int TileChunkSize = 16;
+
+struct TileChunk
+{
+	// first tile column and row covered by this chunk, and how many tiles it covers (edge chunks may be smaller)
+	int X = 0;
+	int Y = 0;
+	int Width = 0;
+	int Height = 0;
+
+	// true when no tile in the chunk has a sprite
+	bool Empty = true;
+
+	// the world space area the chunk's tiles are drawn into
+	Rectangle Bounds = { 0,0,0,0 };
+
+	// the chunk's tiles baked into a single texture, padded by a tile on each side for sprites that hang over the edge
+	RenderTexture2D Cache = {};
+	Rectangle CacheBounds = { 0,0,0,0 };
+
+	// the cache is out of date and must be baked again before it can be drawn
+	bool Dirty = true;
+};
+
 class TileLayer : public Layer
 {
 public:
 	Vector2 TileSize = { 0,0 };
 	std::vector<Tile> Tiles;
+
+	// tiles read in place from a memory mapped compiled map, used instead of Tiles when set
+	const Tile* MappedTiles = nullptr;
+	size_t MappedTileCount = 0;
+
+	inline const Tile* GetTiles() const { return MappedTiles != nullptr ? MappedTiles : Tiles.data(); }
+	inline size_t GetTileCount() const { return MappedTiles != nullptr ? MappedTileCount : Tiles.size(); }
+
+	int ChunksX = 0;
+	int ChunksY = 0;
+	std::vector<TileChunk> Chunks;
+
+	// set when every chunk in the layer needs to be baked again
+	bool Dirty = true;
 };
 
 class Property
@@ -177,6 +221,9 @@ public:
 
 	std::vector<Property> Properties;
 
+	// the compiled map file that tile layers point into, if the map was loaded from one
+	std::shared_ptr<MappedFile> Source;
+
 	inline const Property* GetProperty(const char* name) const
 	{
 		for (const auto& prop : Properties)
@@ -188,6 +235,26 @@ public:
 	}
 };
 
+// compiled maps live next to the .tmx they were built from
+constexpr char CompiledMapExtension[] = ".rpgmap";
+
+// reads the compiled copy of a map if it is present and up to date, otherwise parses the .tmx
 bool ReadTileMap(const char* filePath, TileMap& map);
 
-void DrawTileMap(Camera2D& camera, const TileMap& map);
\ No newline at end of file
+bool ReadTileMapXML(const char* filePath, TileMap& map);
+bool ReadCompiledTileMap(const char* filePath, TileMap& map);
+bool WriteCompiledTileMap(const char* filePath, const TileMap& map);
+std::string GetCompiledMapPath(const std::string& filePath);
+
+void BuildTileChunks(TileMap& map);
+
+// baked tile layer cache
+void SetTile(TileLayer& layer, int x, int y, const Tile& tile);
+void MarkTileLayerDirty(TileLayer& layer);
+void UpdateTileMapCache(TileMap& map);
+void UnloadTileMapCache(TileMap& map);
+
+void DrawTileMap(Camera2D& camera, const TileMap& map);
+
+// against the view DrawTileMap last drew, for culling what goes on top of the map
+bool RectInView(const Rectangle& rect);
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "items.h"
 #include "monsters.h"
 #include "audio.h"
+#include "sprite_atlas.h"
 
 #include "raylib.h"
 #include "raymath.h"
@@ -43,6 +44,10 @@ std::deque<std::string> SoundsToLoad;
 
 std::vector<Texture> LoadedTextures;
 
+// the packed art, only kept until the sprites are set up from it
+SpriteTable LoadedSpriteTable;
+bool UsingSpriteTable = false;
+
 Texture DefaultTexture = {0};
 
 size_t LoadedItems = 0;
@@ -51,9 +56,19 @@ size_t TotalToLoad = 0;
 
 void InitResources()
 {
-    // setup the assets to load
-    TexturesToLoad.emplace_back("colored_tilemap.png"); //TileSetTexture
-    TexturesToLoad.emplace_back("icons/Icon.5_46.png"); //LogoTexture
+    // setup the assets to load, the atlases from rpg_atlas_builder when they are there and no older than the art
+    UsingSpriteTable = ReadSpriteTable(SpriteTableFile, LoadedSpriteTable)
+        && SpriteTableIsCurrent(SpriteTableFile, LoadedSpriteTable);
+
+    if (UsingSpriteTable) {
+        // the tile set is packed first, so its frames keep their ids and TileSetTexture is the first atlas
+        for (const std::string &atlas : LoadedSpriteTable.Atlases)
+            TexturesToLoad.emplace_back(atlas);
+    }
+    else {
+        TexturesToLoad.emplace_back("colored_tilemap.png"); //TileSetTexture
+        TexturesToLoad.emplace_back("icons/Icon.5_46.png"); //LogoTexture
+    }
 
     // setup default texture
     Image checkered = GenImageChecked(32, 32, 8, 8, GRAY, RAYWHITE);
@@ -88,7 +103,13 @@ void CleanupResources()
 
 void FinalizeLoad()
 {
-    LoadSpriteFrames(TileSetTexture, 14, 12, 4);
+    if (UsingSpriteTable) {
+        LoadSpriteFrames(TileSetTexture, LoadedSpriteTable);
+        LoadedSpriteTable = SpriteTable();
+    }
+    else {
+        LoadSpriteFrames(TileSetTexture, 14, 12, 4);
+    }
 
     for (int i = 4; i < 14; i++) {
         CenterSprite(i);
@@ -112,6 +133,13 @@ void FinalizeLoad()
 
     SetupDefaultItems();
     SetupDefaultMobs();
+
+    // the databases are shared with the server and know nothing about drawing, center their sprites here
+    for (int i = 0; GetItem(i) != nullptr; i++)
+        CenterSprite(GetItem(i)->Sprite);
+
+    for (int i = 0; GetMob(i) != nullptr; i++)
+        CenterSprite(GetMob(i)->Sprite);
 }
 
 void UpdateLoad(std::function<void()> onFinished, std::shared_ptr<LoadingScreen> screen)
@@ -148,7 +176,7 @@ void UpdateLoad(std::function<void()> onFinished, std::shared_ptr<LoadingScreen>
 // gets a texture from an ID. The textures are loaded in ID order.
 const Texture &GetTexture(int id)
 {
-    if (id < 0 || id > int(LoadedTextures.size()))
+    if (id < 0 || id >= int(LoadedTextures.size()))
         return DefaultTexture;
 
     return LoadedTextures[id];
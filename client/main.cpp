@@ -29,6 +29,7 @@
 #include "screens.h"
 #include "game_hud.h"
 #include "audio.h"
+#include "sprite_batch.h"
 
 
 // setup the window and icon
@@ -112,12 +113,18 @@ bool SearchAndSetResourceDir(const char *folderName)
 // the main application loop
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
+    if (argc < 2 || argc > 4) {
         TraceLog(LOG_FATAL, "Invalid arg");
     }
 
     int id = std::stoi(std::string(argv[1]));
 
+    // optional simulation rate in ticks per second, 0 ticks once per rendered frame
+    float tickRate = argc >= 3 ? std::stof(std::string(argv[2])) : DefaultTickRate;
+
+    // optional room to play online in, players who pick the same one play together
+    auto room = net::RoomId(argc == 4 ? std::stoi(std::string(argv[3])) : net::ANY_ROOM);
+
     std::shared_ptr<Screen> activeScreen;
     auto mainMenuScreen = std::make_shared<MainMenuScreen>();
     auto pauseMenuScreen = std::make_shared<PauseMenuScreen>();
@@ -127,6 +134,7 @@ int main(int argc, char *argv[])
     ApplicationStates applicationStates = ApplicationStates::Startup;
 
     GameState gameState;
+    gameState.SetTickRate(tickRate);
 
     auto gameHud = std::make_shared<GameHudScreen>(gameState.Player1, gameState.Player2);
 
@@ -190,7 +198,7 @@ int main(int argc, char *argv[])
         applicationStates = ApplicationStates::Running;
         StopBGM();
         activeScreen = gameHud;
-        gameState.InitGame(mode, id);
+        gameState.InitGame(mode, id, room);
     };
 
     std::function<void()> PauseGame = [&]()
@@ -238,6 +246,9 @@ int main(int argc, char *argv[])
 
     applicationStates = ApplicationStates::Loading;
 
+    // F3 shows what the sprite batch submitted last frame
+    bool showBatchStats = false;
+
     // game loop
     while (!WindowShouldClose() && applicationStates != ApplicationStates::Quitting) {
         // call the update that goes with our current game state
@@ -255,7 +266,11 @@ int main(int argc, char *argv[])
                 break;
         }
 
+        if (IsKeyPressed(KEY_F3))
+            showBatchStats = !showBatchStats;
+
         // update the screen for this frame
+        ResetSpriteBatchStats();
         BeginDrawing();
         ClearBackground(BLACK);
 
@@ -265,6 +280,12 @@ int main(int argc, char *argv[])
         // draw whatever menu or hud screen we have
         DrawScreen(activeScreen);
 
+        if (showBatchStats) {
+            const SpriteBatchStats &stats = GetSpriteBatchStats();
+            DrawText(TextFormat("draw calls %u  vertices %u  quads %u", stats.DrawCalls, stats.Vertices, stats.Quads),
+                     10, GetScreenHeight() - 30, 20, YELLOW);
+        }
+
         UpdateAudio();
         EndDrawing();
     }
@@ -27,27 +27,20 @@
 
 #include "resource_ids.h"
 #include "sprites.h"
+#include "sprite_batch.h"
 #include "tile_map.h"
 #include "audio.h"
+#include "sim_convert.h"
 
 #include "raylib.h"
 #include "raymath.h"
 
 #include <math.h>
-#include <unordered_map>
-#include <list>
+#include <string.h>
+#include <algorithm>
+#include <vector>
 
-struct EffectInstance
-{
-    Vector2 Position = {0, 0};
-    EffectType Effect = EffectType::Fade;
-    int SpriteId = -1;
-    float Lifetime = 1;
-    float MaxLifetime = 1;
-    Vector2 Target = {0, 0};
-};
-
-std::list<EffectInstance> Effects;
+EffectSystem Effects;
 
 Rectangle VisibilityInset = {200, 200, 200, 250};
 
@@ -55,114 +48,128 @@ Camera2D MapCamera = {0};
 
 TileMap CurrentMap;
 
-std::unordered_map<int, SpriteInstance> SpriteInstances;
+// the map's sprites packed together, a handle finds its sprite through a slot that never moves. removing a sprite
+// moves the last one into its place and moves the slot's generation on, so the removed sprite's handles go stale
+struct SpriteSlot
+{
+    uint32_t Index = 0;
+    uint32_t Generation = 1;
+};
+
+std::vector<SpriteInstance> MapSprites;
+
+// indexed like MapSprites, the slot that points at each sprite
+std::vector<uint32_t> MapSpriteSlots;
+
+std::vector<SpriteSlot> SpriteSlots;
+std::vector<uint32_t> FreeSpriteSlots;
+
+// one frame's sprites that can be seen, sorted by how far down the map they stand
+struct SpriteDrawEntry
+{
+    uint32_t Key = 0;
+    const SpriteInstance *Sprite = nullptr;
+    Vector2 Position = {0, 0};
+};
+
+std::vector<SpriteDrawEntry> SpriteDrawList;
+std::vector<SpriteDrawEntry> SpriteSortScratch;
+
+// how far a sprite can reach from its position, anything further than this outside the view isn't drawn
+constexpr float SpriteCullMargin = 64;
 
-int NextSpriteId = 0;
+// how far the renderer is between the last simulation tick and the next one
+float SpriteInterpolation = 1;
 
 Rectangle MapBounds = {0, 0, 0, 0};
 
-Camera2D &GetMapCamera()
+// floats compare the same as their bits do once the sign is dealt with
+static uint32_t GetSpriteSortKey(float y)
 {
-    return MapCamera;
+    uint32_t bits = 0;
+    memcpy(&bits, &y, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
 }
 
-void SetVisiblePoint(const Vector2 &point)
+// a byte of the key at a time, each pass is stable so sprites standing level keep the order they were in
+static void SortSpriteDrawList()
 {
-    Vector2 screenPoint = GetWorldToScreen2D(point, MapCamera);
+    if (SpriteDrawList.size() < 2)
+        return;
 
-    if (screenPoint.x < VisibilityInset.x)
-        MapCamera.target.x -= VisibilityInset.x - screenPoint.x;
+    SpriteSortScratch.resize(SpriteDrawList.size());
 
-    if (screenPoint.x > GetScreenWidth() - VisibilityInset.width)
-        MapCamera.target.x += screenPoint.x - (GetScreenWidth() - VisibilityInset.width);
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t offsets[257] = {0};
+        for (const SpriteDrawEntry &entry : SpriteDrawList)
+            offsets[((entry.Key >> shift) & 0xFF) + 1]++;
 
-    if (screenPoint.y < VisibilityInset.y)
-        MapCamera.target.y -= VisibilityInset.y - screenPoint.y;
+        // sprites close together mostly share their high bytes, a pass where every key is the same moves nothing
+        if (offsets[((SpriteDrawList[0].Key >> shift) & 0xFF) + 1] == SpriteDrawList.size())
+            continue;
 
-    if (screenPoint.y > GetScreenHeight() - VisibilityInset.height)
-        MapCamera.target.y += screenPoint.y - (GetScreenHeight() - VisibilityInset.height);
+        for (int i = 0; i < 256; i++)
+            offsets[i + 1] += offsets[i];
+
+        for (const SpriteDrawEntry &entry : SpriteDrawList)
+            SpriteSortScratch[offsets[(entry.Key >> shift) & 0xFF]++] = entry;
+
+        SpriteDrawList.swap(SpriteSortScratch);
+    }
 }
 
-bool PointInMap(const Vector2 &point)
+// the sprites in view, back to front. has to come after DrawTileMap, which works out the view
+static void BuildSpriteDrawList()
 {
-    if (!CheckCollisionPointRec(point, MapBounds))
-        return false;
+    SpriteDrawList.clear();
 
-    for (const auto &layerInfo : CurrentMap.ObjectLayers) {
-        for (const auto &object : layerInfo.second->Objects) {
-            if (object->Type == "wall") {
-                if (CheckCollisionPointRec(point, object->Bounds))
-                    return false;
-            }
-        }
+    for (const SpriteInstance &sprite : MapSprites) {
+        if (!sprite.Active)
+            continue;
+
+        Vector2 position = GetSpriteDrawPosition(sprite);
+        Rectangle bounds = {position.x - SpriteCullMargin,
+                            position.y - SpriteCullMargin,
+                            SpriteCullMargin * 2,
+                            SpriteCullMargin * 2};
+        if (!RectInView(bounds))
+            continue;
+
+        SpriteDrawList.push_back(SpriteDrawEntry{GetSpriteSortKey(position.y), &sprite, position});
     }
 
-    return true;
+    SortSpriteDrawList();
 }
 
-// check to see if a line collides with a rectangle
-bool CheckCollisionLineRec(const Vector2 &startPoint, const Vector2 &endPoint, const Rectangle &rectangle)
+Camera2D &GetMapCamera()
 {
-    // ether point is in the rectangle
-    if (CheckCollisionPointRec(startPoint, rectangle) || CheckCollisionPointRec(endPoint, rectangle))
-        return true;
-
-    // top
-    if (CheckCollisionLines(startPoint,
-                            endPoint,
-                            Vector2{rectangle.x, rectangle.y},
-                            Vector2{rectangle.x + rectangle.width, rectangle.y},
-                            nullptr))
-        return true;
-
-    // right
-    if (CheckCollisionLines(startPoint,
-                            endPoint,
-                            Vector2{rectangle.x + rectangle.width, rectangle.y},
-                            Vector2{rectangle.x + rectangle.width, rectangle.y + rectangle.height},
-                            nullptr))
-        return true;
-
-    // bottom
-    if (CheckCollisionLines(startPoint,
-                            endPoint,
-                            Vector2{rectangle.x, rectangle.y + rectangle.height},
-                            Vector2{rectangle.x + rectangle.width, rectangle.y + rectangle.height},
-                            nullptr))
-        return true;
-
-    // left
-    if (CheckCollisionLines(startPoint,
-                            endPoint,
-                            Vector2{rectangle.x, rectangle.y},
-                            Vector2{rectangle.x, rectangle.y + rectangle.height},
-                            nullptr))
-        return true;
-
-    return false;
+    return MapCamera;
 }
 
-bool Ray2DHitsMap(const Vector2 &startPoint, const Vector2 &endPoint)
+void SetVisiblePoint(const Vector2 &point)
 {
-    if (!PointInMap(startPoint) || !PointInMap(endPoint))
-        return true;
+    Vector2 screenPoint = GetWorldToScreen2D(point, MapCamera);
 
-    for (const auto &layerInfo : CurrentMap.ObjectLayers) {
-        for (const auto &object : layerInfo.second->Objects) {
-            if (object->Type == "wall") {
-                if (CheckCollisionLineRec(startPoint, endPoint, object->Bounds))
-                    return true;
-            }
-        }
-    }
+    if (screenPoint.x < VisibilityInset.x)
+        MapCamera.target.x -= VisibilityInset.x - screenPoint.x;
+
+    if (screenPoint.x > GetScreenWidth() - VisibilityInset.width)
+        MapCamera.target.x += screenPoint.x - (GetScreenWidth() - VisibilityInset.width);
 
-    return false;
+    if (screenPoint.y < VisibilityInset.y)
+        MapCamera.target.y -= VisibilityInset.y - screenPoint.y;
+
+    if (screenPoint.y > GetScreenHeight() - VisibilityInset.height)
+        MapCamera.target.y += screenPoint.y - (GetScreenHeight() - VisibilityInset.height);
 }
 
 void LoadMap(const char *file)
 {
     ClearSprites();
+    UnloadTileMapCache(CurrentMap);
     ReadTileMap(file, CurrentMap);
+    BuildTileChunks(CurrentMap);
+    UpdateTileMapCache(CurrentMap);
 
     MapCamera.offset.x = GetScreenWidth() * 0.5f;
     MapCamera.offset.y = GetScreenHeight() * 0.5f;
@@ -194,10 +201,11 @@ void LoadMap(const char *file)
 
 void ClearMap()
 {
+    UnloadTileMapCache(CurrentMap);
     CurrentMap.ObjectLayers.clear();
     CurrentMap.TileLayers.clear();
     ClearSprites();
-    Effects.clear();
+    Effects.Clear();
 }
 
 void DrawMap()
@@ -205,74 +213,58 @@ void DrawMap()
     if (CurrentMap.TileLayers.empty())
         return;
 
+    // re-bake any tile chunks that changed, this has to happen outside of the camera mode
+    UpdateTileMapCache(CurrentMap);
+
     BeginMode2D(GetMapCamera());
     DrawTileMap(MapCamera, CurrentMap);
 
-    for (const auto &entry : SpriteInstances) {
-        const SpriteInstance &sprite = entry.second;
-        if (sprite.Active) {
-            float offset = 0;
-            if (sprite.Bobble)
-                offset = fabsf(sinf(float(GetTime() * 5)) * 3);
-
-            if (sprite.Shadow)
-                DrawSprite(sprite.SpriteFrame,
-                           sprite.Position.x + 2,
-                           sprite.Position.y + 2 + offset,
-                           0.0f,
-                           1.0f,
-                           ColorAlpha(BLACK, 0.5f));
-
-            DrawSprite(sprite.SpriteFrame, sprite.Position.x, sprite.Position.y + offset, 0.0f, 1.0f, sprite.Tint);
-        }
+    BuildSpriteDrawList();
+
+    // every bobbing sprite bobs together
+    float bobble = fabsf(sinf(float(GetTime() * 5)) * 3);
+
+    for (size_t i = 0; i < SpriteDrawList.size(); i++) {
+        const SpriteInstance &sprite = *SpriteDrawList[i].Sprite;
+        const Vector2 &position = SpriteDrawList[i].Position;
+        float offset = sprite.Bobble ? bobble : 0;
+
+        if (sprite.Shadow)
+            QueueSprite(sprite.SpriteFrame,
+                        position.x + 2,
+                        position.y + 2 + offset,
+                        MapShadowLayer,
+                        0.0f,
+                        1.0f,
+                        ColorAlpha(BLACK, 0.5f));
+
+        // the depth keeps the sort order even where neighbours use different textures
+        QueueSprite(sprite.SpriteFrame,
+                    position.x,
+                    position.y + offset,
+                    MapSpriteLayer,
+                    0.0f,
+                    1.0f,
+                    sprite.Tint,
+                    SpriteFlipNone,
+                    SpriteDepth(std::min<size_t>(i, UINT16_MAX)));
     }
 
-    for (auto effect = Effects.begin(); effect != Effects.end();) {
-        effect->Lifetime -= GetFrameTime();
-
-        if (effect->Lifetime < 0) {
-            effect = Effects.erase(effect);
-            continue;
-        }
-
-        float param = effect->Lifetime / effect->MaxLifetime;
-        float rotation = 0;
-        float alpha = 1;
-        float scale = 1;
-
-        Vector2 pos = effect->Position;
-
-        switch (effect->Effect) {
-            case EffectType::Fade: alpha = param;
-                break;
-
-            case EffectType::RiseFade: alpha = param;
-                pos.y -= (1.0f - param) * 30;
-                break;
-
-            case EffectType::RotateFade: rotation = (1.0f - param) * 360;
-                alpha = param;
-                break;
-
-            case EffectType::ScaleFade: alpha = param;
-                scale = 1 + (1.0f - param);
-                break;
-
-            case EffectType::ToTarget: {
-                Vector2 vec = Vector2Subtract(effect->Target, effect->Position);
-                float dist = Vector2Length(vec);
-                vec = Vector2Normalize(vec);
-
-                pos = Vector2Add(effect->Position, Vector2Scale(vec, dist * (1.0f - param)));
-                break;
-            }
-        }
-
-        DrawSprite(effect->SpriteId, pos.x, pos.y, rotation, scale, ColorAlpha(WHITE, alpha));
-
-        effect++;
+    // the tick already worked out how every effect looks
+    for (size_t type = 0; type < EffectTypeCount; type++) {
+        const EffectArrays &effects = Effects.Get(EffectType(type));
+        for (size_t i = 0; i < effects.Count; i++)
+            QueueSprite(effects.SpriteIds[i],
+                        effects.DrawPositions[i].x,
+                        effects.DrawPositions[i].y,
+                        MapEffectLayer,
+                        effects.Rotations[i],
+                        effects.Scales[i],
+                        ColorAlpha(WHITE, effects.Alphas[i]));
     }
 
+    // the whole map goes to rlgl here, grouped by texture
+    FlushSpriteBatch();
     EndMode2D();
 }
 
@@ -310,49 +302,137 @@ const TileObject *GetFirstMapObjectOfType(const char *objType, TileObject::SubTy
     return nullptr;
 }
 
-SpriteInstance *AddSprite(int frame, const Vector2 &position)
+sim::MapData GetMapData()
+{
+    sim::MapData data;
+    data.Bounds = ToRect(MapBounds);
+
+    if (!CurrentMap.TileLayers.empty())
+        data.TileSize = CurrentMap.TileLayers.rbegin()->second->TileSize.x;
+
+    for (const auto &layerInfo : CurrentMap.ObjectLayers) {
+        for (const auto &object : layerInfo.second->Objects) {
+            sim::MapObject &mapObject = data.Objects.emplace_back();
+            mapObject.Id = object->ID;
+            mapObject.Name = object->Name;
+            mapObject.Type = object->Type;
+            mapObject.Bounds = ToRect(object->Bounds);
+
+            for (const auto &prop : object->Properties)
+                mapObject.Properties.push_back(sim::MapProperty{prop.Name, prop.Value});
+        }
+    }
+
+    return data;
+}
+
+SpriteHandle AddSprite(int frame, const Vector2 &position)
+{
+    uint32_t slot = 0;
+    if (!FreeSpriteSlots.empty()) {
+        slot = FreeSpriteSlots.back();
+        FreeSpriteSlots.pop_back();
+    }
+    else {
+        slot = uint32_t(SpriteSlots.size());
+        SpriteSlots.emplace_back();
+    }
+
+    SpriteSlots[slot].Index = uint32_t(MapSprites.size());
+    MapSpriteSlots.push_back(slot);
+
+    SpriteInstance &sprite = MapSprites.emplace_back();
+    sprite.SpriteFrame = frame;
+    sprite.Position = position;
+    sprite.PreviousPosition = position;
+
+    return SpriteHandle{slot, SpriteSlots[slot].Generation};
+}
+
+SpriteInstance *GetSprite(SpriteHandle handle)
+{
+    if (handle.Index >= SpriteSlots.size() || SpriteSlots[handle.Index].Generation != handle.Generation)
+        return nullptr;
+
+    return &MapSprites[SpriteSlots[handle.Index].Index];
+}
+
+void UpdateSprite(SpriteHandle handle, const Vector2 &position)
 {
-    NextSpriteId++;
-    return &(SpriteInstances.insert_or_assign(NextSpriteId, SpriteInstance{NextSpriteId, true, frame, position}).first
-        ->second);
+    SpriteInstance *sprite = GetSprite(handle);
+    if (sprite == nullptr)
+        return;
+
+    sprite->Position = position;
 }
 
-void UpdateSprite(int spriteId, const Vector2 &position)
+void RemoveSprite(SpriteHandle handle)
 {
-    auto itr = SpriteInstances.find(spriteId);
-    if (itr == SpriteInstances.end())
+    if (GetSprite(handle) == nullptr)
         return;
 
-    itr->second.Position = position;
+    // the last sprite fills the gap so the sprites stay packed
+    SpriteSlot &slot = SpriteSlots[handle.Index];
+    uint32_t lastSlot = MapSpriteSlots.back();
+    MapSprites[slot.Index] = MapSprites.back();
+    MapSpriteSlots[slot.Index] = lastSlot;
+    SpriteSlots[lastSlot].Index = slot.Index;
+
+    MapSprites.pop_back();
+    MapSpriteSlots.pop_back();
+
+    slot.Generation++;
+    FreeSpriteSlots.push_back(handle.Index);
+}
+
+void BeginSpriteTick()
+{
+    for (SpriteInstance &sprite : MapSprites)
+        sprite.PreviousPosition = sprite.Position;
+}
+
+void ResetSpriteInterpolation()
+{
+    BeginSpriteTick();
+    SpriteInterpolation = 1;
 }
 
-void RemoveSprite(SpriteInstance *sprite)
+void SetSpriteInterpolation(float alpha)
 {
-    if (sprite != nullptr)
-        RemoveSprite(sprite->Id);
+    SpriteInterpolation = Clamp(alpha, 0.0f, 1.0f);
 }
 
-void RemoveSprite(int spriteId)
+Vector2 GetSpriteDrawPosition(const SpriteInstance &sprite)
 {
-    auto itr = SpriteInstances.find(spriteId);
-    if (itr != SpriteInstances.end())
-        SpriteInstances.erase(itr);
+    return Vector2Lerp(sprite.PreviousPosition, sprite.Position, SpriteInterpolation);
 }
 
 void ClearSprites()
 {
-    SpriteInstances.clear();
-    NextSpriteId = 0;
+    // the slots stay for the next map, every handle given out so far goes stale
+    for (uint32_t slot : MapSpriteSlots) {
+        SpriteSlots[slot].Generation++;
+        FreeSpriteSlots.push_back(slot);
+    }
+
+    MapSprites.clear();
+    MapSpriteSlots.clear();
+    SpriteDrawList.clear();
 }
 
 void AddEffect(const Vector2 &position, EffectType effect, int spriteId, float lifetime)
 {
-    CenterSprite(spriteId);
-    Effects.emplace_back(EffectInstance{position, effect, spriteId, lifetime, lifetime});
+    AddEffect(position, effect, spriteId, position, lifetime);
 }
 
 void AddEffect(const Vector2 &position, EffectType effect, int spriteId, const Vector2 &target, float lifetime)
 {
     CenterSprite(spriteId);
-    Effects.emplace_back(EffectInstance{position, effect, spriteId, lifetime, lifetime, target});
-}
\ No newline at end of file
+    Effects.Add(position, effect, spriteId, target, lifetime);
+}
+
+// effects age with the simulation, so they pause with the game and run at the tick rate
+void UpdateEffects(float deltaTime)
+{
+    Effects.Update(deltaTime);
+}
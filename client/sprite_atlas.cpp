@@ -0,0 +1,240 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "sprite_atlas.h"
+#include "mapped_file.h"
+#include "flat_file.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <memory>
+
+// Sprite table format
+// A flat, little endian file laid out like a compiled map.
+// header | atlases | sources | sprites | string table
+// Every section starts on a 4 byte boundary, strings are offsets into a table of null terminated strings
+// and offset 0 is always the empty string.
+
+constexpr char SpriteTableMagic[4] = { 'R', 'P', 'G', 'S' };
+constexpr uint32_t SpriteTableVersion = 1;
+
+struct SpriteTableHeader
+{
+	char Magic[4];
+	uint32_t Version;
+
+	uint32_t AtlasCount;
+	uint32_t AtlasOffset;
+
+	uint32_t SourceCount;
+	uint32_t SourceOffset;
+
+	uint32_t SpriteCount;
+	uint32_t SpriteOffset;
+
+	uint32_t StringTableSize;
+	uint32_t StringTableOffset;
+};
+
+struct CompiledAtlas
+{
+	uint32_t File;
+};
+
+struct CompiledSource
+{
+	uint32_t File;
+	uint32_t FirstSprite;
+	uint32_t SpriteCount;
+};
+
+struct CompiledSprite
+{
+	uint32_t Atlas;
+
+	float X;
+	float Y;
+	float Width;
+	float Height;
+
+	float OriginX;
+	float OriginY;
+
+	float BorderLeft;
+	float BorderTop;
+	float BorderRight;
+	float BorderBottom;
+};
+
+bool ReadSpriteTable(const char* filePath, SpriteTable& table)
+{
+	table = SpriteTable();
+
+	auto file = std::make_unique<MappedFile>();
+	if (!file->Open(filePath) || file->GetSize() < sizeof(SpriteTableHeader))
+		return false;
+
+	const uint8_t* data = file->GetData();
+	size_t size = file->GetSize();
+
+	const SpriteTableHeader& header = *reinterpret_cast<const SpriteTableHeader*>(data);
+	if (memcmp(header.Magic, SpriteTableMagic, sizeof(SpriteTableMagic)) != 0 || header.Version != SpriteTableVersion)
+		return false;
+
+	if (!SectionInFile(header.AtlasOffset, header.AtlasCount, sizeof(CompiledAtlas), size)
+		|| !SectionInFile(header.SourceOffset, header.SourceCount, sizeof(CompiledSource), size)
+		|| !SectionInFile(header.SpriteOffset, header.SpriteCount, sizeof(CompiledSprite), size)
+		|| !SectionInFile(header.StringTableOffset, header.StringTableSize, 1, size)
+		|| header.StringTableSize == 0)
+		return false;
+
+	const auto* atlases = reinterpret_cast<const CompiledAtlas*>(data + header.AtlasOffset);
+	const auto* sources = reinterpret_cast<const CompiledSource*>(data + header.SourceOffset);
+	const auto* sprites = reinterpret_cast<const CompiledSprite*>(data + header.SpriteOffset);
+	const char* strings = reinterpret_cast<const char*>(data + header.StringTableOffset);
+
+	// the table must end in a terminator so every offset into it is a valid C string
+	if (strings[header.StringTableSize - 1] != 0)
+		return false;
+
+	auto getString = [&](uint32_t offset) -> const char*
+	{
+		return offset < header.StringTableSize ? strings + offset : "";
+	};
+
+	table.Atlases.reserve(header.AtlasCount);
+	for (uint32_t i = 0; i < header.AtlasCount; i++)
+		table.Atlases.emplace_back(getString(atlases[i].File));
+
+	table.Sources.reserve(header.SourceCount);
+	for (uint32_t i = 0; i < header.SourceCount; i++)
+	{
+		const CompiledSource& source = sources[i];
+		if (uint64_t(source.FirstSprite) + source.SpriteCount > header.SpriteCount)
+			return false;
+
+		table.Sources.emplace_back(AtlasSource{ getString(source.File), int(source.FirstSprite), int(source.SpriteCount) });
+	}
+
+	table.Sprites.reserve(header.SpriteCount);
+	for (uint32_t i = 0; i < header.SpriteCount; i++)
+	{
+		const CompiledSprite& sprite = sprites[i];
+		if (sprite.Atlas >= header.AtlasCount)
+			return false;
+
+		AtlasSprite& info = table.Sprites.emplace_back();
+		info.Atlas = int(sprite.Atlas);
+		info.SourceRect = Rectangle{ sprite.X, sprite.Y, sprite.Width, sprite.Height };
+		info.Origin = Vector2{ sprite.OriginX, sprite.OriginY };
+		info.Borders = Rectangle{ sprite.BorderLeft, sprite.BorderTop, sprite.BorderRight, sprite.BorderBottom };
+	}
+
+	return true;
+}
+
+bool WriteSpriteTable(const char* filePath, const SpriteTable& table)
+{
+	// paths are the only strings and are rarely shared, so there is no need to look for repeats
+	std::vector<char> strings(1, '\0');
+	auto addString = [&](const std::string& text) -> uint32_t
+	{
+		if (text.empty())
+			return 0;
+
+		uint32_t offset = uint32_t(strings.size());
+		strings.insert(strings.end(), text.begin(), text.end());
+		strings.push_back('\0');
+		return offset;
+	};
+
+	std::vector<CompiledAtlas> atlases;
+	for (const std::string& atlas : table.Atlases)
+		atlases.emplace_back(CompiledAtlas{ addString(atlas) });
+
+	std::vector<CompiledSource> sources;
+	for (const AtlasSource& source : table.Sources)
+		sources.emplace_back(CompiledSource{ addString(source.File), uint32_t(source.FirstSprite), uint32_t(source.SpriteCount) });
+
+	std::vector<CompiledSprite> sprites;
+	for (const AtlasSprite& sprite : table.Sprites)
+	{
+		sprites.emplace_back(CompiledSprite{ uint32_t(sprite.Atlas),
+			sprite.SourceRect.x, sprite.SourceRect.y, sprite.SourceRect.width, sprite.SourceRect.height,
+			sprite.Origin.x, sprite.Origin.y,
+			sprite.Borders.x, sprite.Borders.y, sprite.Borders.width, sprite.Borders.height });
+	}
+
+	SpriteTableHeader header = {};
+	memcpy(header.Magic, SpriteTableMagic, sizeof(SpriteTableMagic));
+	header.Version = SpriteTableVersion;
+
+	header.AtlasCount = uint32_t(atlases.size());
+	header.AtlasOffset = AlignSection(uint32_t(sizeof(SpriteTableHeader)));
+
+	header.SourceCount = uint32_t(sources.size());
+	header.SourceOffset = AlignSection(header.AtlasOffset + header.AtlasCount * uint32_t(sizeof(CompiledAtlas)));
+
+	header.SpriteCount = uint32_t(sprites.size());
+	header.SpriteOffset = AlignSection(header.SourceOffset + header.SourceCount * uint32_t(sizeof(CompiledSource)));
+
+	header.StringTableSize = uint32_t(strings.size());
+	header.StringTableOffset = AlignSection(header.SpriteOffset + header.SpriteCount * uint32_t(sizeof(CompiledSprite)));
+
+	FILE* file = fopen(filePath, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& WriteSection(file, atlases, header.AtlasOffset)
+		&& WriteSection(file, sources, header.SourceOffset)
+		&& WriteSection(file, sprites, header.SpriteOffset)
+		&& WriteSection(file, strings, header.StringTableOffset);
+
+	fclose(file);
+	return ok;
+}
+
+bool SpriteTableIsCurrent(const char* filePath, const SpriteTable& table)
+{
+	std::error_code error;
+	auto tableTime = std::filesystem::last_write_time(filePath, error);
+	if (error)
+		return false;
+
+	std::filesystem::path folder = std::filesystem::path(filePath).parent_path();
+	for (const AtlasSource& source : table.Sources)
+	{
+		auto sourceTime = std::filesystem::last_write_time(folder / source.File, error);
+		if (error)
+			continue; // only the atlases shipped
+
+		if (sourceTime > tableTime)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,244 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "sprite_batch.h"
+
+#include "rlgl.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// one quad, corners and texture coordinates in the order rlgl wants them for RL_QUADS
+struct SpriteQuad
+{
+    unsigned int TextureId = 0;
+    Vector2 Corners[4];
+    Vector2 Coords[4];
+    Color Tint = WHITE;
+};
+
+// rlgl's vertex buffer holds 2048 quads on GLES2 and more on desktop, a run is handed over in pieces that always fit
+constexpr size_t MaxQuadsPerSubmit = 1024;
+
+std::vector<SpriteQuad> Quads;
+
+// layer, depth and texture packed so a plain sort groups them, queue order breaks ties
+struct QuadKey
+{
+    uint64_t Order = 0;
+    uint32_t Index = 0;
+
+    bool operator<(const QuadKey &other) const
+    {
+        return Order < other.Order || (Order == other.Order && Index < other.Index);
+    }
+};
+
+std::vector<QuadKey> QuadKeys;
+
+SpriteBatchStats BatchStats;
+
+static SpriteQuad &AddQuad(unsigned int textureId, SpriteLayer layer, SpriteDepth depth)
+{
+    QuadKeys.push_back(QuadKey{uint64_t(layer) << 48 | uint64_t(depth) << 32 | textureId, uint32_t(Quads.size())});
+
+    SpriteQuad &quad = Quads.emplace_back();
+    quad.TextureId = textureId;
+    return quad;
+}
+
+void QueueTexture(const Texture2D &texture,
+                  Rectangle source,
+                  const Rectangle &destination,
+                  const Vector2 &origin,
+                  float rotation,
+                  Color tint,
+                  SpriteLayer layer,
+                  SpriteDepth depth)
+{
+    if (texture.id == 0 || texture.width == 0 || texture.height == 0)
+        return;
+
+    // the same flips DrawTexturePro does
+    bool flipX = false;
+    if (source.width < 0) {
+        flipX = true;
+        source.width *= -1;
+    }
+
+    if (source.height < 0)
+        source.y -= source.height;
+
+    SpriteQuad &quad = AddQuad(texture.id, layer, depth);
+    quad.Tint = tint;
+
+    Vector2 &topLeft = quad.Corners[0];
+    Vector2 &bottomLeft = quad.Corners[1];
+    Vector2 &bottomRight = quad.Corners[2];
+    Vector2 &topRight = quad.Corners[3];
+
+    if (rotation == 0) {
+        float x = destination.x - origin.x;
+        float y = destination.y - origin.y;
+        topLeft = Vector2{x, y};
+        topRight = Vector2{x + destination.width, y};
+        bottomLeft = Vector2{x, y + destination.height};
+        bottomRight = Vector2{x + destination.width, y + destination.height};
+    }
+    else {
+        float sinRotation = sinf(rotation * DEG2RAD);
+        float cosRotation = cosf(rotation * DEG2RAD);
+        float x = destination.x;
+        float y = destination.y;
+        float dx = -origin.x;
+        float dy = -origin.y;
+
+        topLeft.x = x + dx * cosRotation - dy * sinRotation;
+        topLeft.y = y + dx * sinRotation + dy * cosRotation;
+
+        topRight.x = x + (dx + destination.width) * cosRotation - dy * sinRotation;
+        topRight.y = y + (dx + destination.width) * sinRotation + dy * cosRotation;
+
+        bottomLeft.x = x + dx * cosRotation - (dy + destination.height) * sinRotation;
+        bottomLeft.y = y + dx * sinRotation + (dy + destination.height) * cosRotation;
+
+        bottomRight.x = x + (dx + destination.width) * cosRotation - (dy + destination.height) * sinRotation;
+        bottomRight.y = y + (dx + destination.width) * sinRotation + (dy + destination.height) * cosRotation;
+    }
+
+    float left = source.x / texture.width;
+    float right = (source.x + source.width) / texture.width;
+    float top = source.y / texture.height;
+    float bottom = (source.y + source.height) / texture.height;
+
+    if (flipX)
+        std::swap(left, right);
+
+    quad.Coords[0] = Vector2{left, top};
+    quad.Coords[1] = Vector2{left, bottom};
+    quad.Coords[2] = Vector2{right, bottom};
+    quad.Coords[3] = Vector2{right, top};
+}
+
+void QueueTextureQuad(unsigned int textureId, const Rectangle &destination, const Rectangle &coords, Color tint, SpriteLayer layer)
+{
+    SpriteQuad &quad = AddQuad(textureId, layer, 0);
+    quad.Tint = tint;
+
+    float right = destination.x + destination.width;
+    float bottom = destination.y + destination.height;
+    quad.Corners[0] = Vector2{destination.x, destination.y};
+    quad.Corners[1] = Vector2{destination.x, bottom};
+    quad.Corners[2] = Vector2{right, bottom};
+    quad.Corners[3] = Vector2{right, destination.y};
+
+    float coordRight = coords.x + coords.width;
+    float coordBottom = coords.y + coords.height;
+    quad.Coords[0] = Vector2{coords.x, coords.y};
+    quad.Coords[1] = Vector2{coords.x, coordBottom};
+    quad.Coords[2] = Vector2{coordRight, coordBottom};
+    quad.Coords[3] = Vector2{coordRight, coords.y};
+}
+
+void QueueRectangle(const Rectangle &rect, Color color, SpriteLayer layer)
+{
+    QueueTextureQuad(rlGetTextureIdDefault(), rect, Rectangle{0, 0, 1, 1}, color, layer);
+}
+
+void QueueRectangleLines(const Rectangle &rect, float thickness, Color color, SpriteLayer layer)
+{
+    // the same four strips DrawRectangleLinesEx draws
+    if (thickness > rect.width || thickness > rect.height)
+        thickness = fminf(rect.width, rect.height) / 2;
+
+    QueueRectangle(Rectangle{rect.x, rect.y, rect.width, thickness}, color, layer);
+    QueueRectangle(Rectangle{rect.x, rect.y + rect.height - thickness, rect.width, thickness}, color, layer);
+    QueueRectangle(Rectangle{rect.x, rect.y + thickness, thickness, rect.height - thickness * 2}, color, layer);
+    QueueRectangle(Rectangle{rect.x + rect.width - thickness, rect.y + thickness, thickness, rect.height - thickness * 2},
+                   color,
+                   layer);
+}
+
+void FlushSpriteBatch()
+{
+    if (QuadKeys.empty())
+        return;
+
+    std::sort(QuadKeys.begin(), QuadKeys.end());
+
+    unsigned int texture = 0;
+    size_t start = 0;
+    while (start < QuadKeys.size()) {
+        // the run of quads sharing the first one's texture, at most what rlgl can take at once
+        unsigned int runTexture = Quads[QuadKeys[start].Index].TextureId;
+        size_t end = start + 1;
+        while (end < QuadKeys.size() && end - start < MaxQuadsPerSubmit
+            && Quads[QuadKeys[end].Index].TextureId == runTexture)
+            end++;
+
+        // rlgl draws what it has if the run doesn't fit, which is a draw call of its own
+        bool flushed = rlCheckRenderBatchLimit(int(end - start) * 4);
+        if (flushed || start == 0 || runTexture != texture)
+            BatchStats.DrawCalls++;
+        texture = runTexture;
+
+        rlSetTexture(texture);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+
+        for (size_t i = start; i < end; i++) {
+            const SpriteQuad &quad = Quads[QuadKeys[i].Index];
+            rlColor4ub(quad.Tint.r, quad.Tint.g, quad.Tint.b, quad.Tint.a);
+
+            for (int corner = 0; corner < 4; corner++) {
+                rlTexCoord2f(quad.Coords[corner].x, quad.Coords[corner].y);
+                rlVertex2f(quad.Corners[corner].x, quad.Corners[corner].y);
+            }
+        }
+
+        rlEnd();
+
+        BatchStats.Quads += uint32_t(end - start);
+        BatchStats.Vertices += uint32_t(end - start) * 4;
+        start = end;
+    }
+
+    rlSetTexture(0);
+
+    // the storage stays for the next flush
+    Quads.clear();
+    QuadKeys.clear();
+}
+
+void ResetSpriteBatchStats()
+{
+    BatchStats = SpriteBatchStats();
+}
+
+const SpriteBatchStats &GetSpriteBatchStats()
+{
+    return BatchStats;
+}
@@ -25,6 +25,8 @@
 
 #include "sprites.h"
 #include "resource_ids.h"
+#include "loading.h"
+#include "sprite_batch.h"
 
 #include "raylib.h"
 #include "raymath.h"
@@ -71,6 +73,21 @@ void LoadSpriteFrames(int textureId, int columns, int rows, int spacing)
 	}
 }
 
+void LoadSpriteFrames(int firstTextureId, const SpriteTable& table)
+{
+	Sprites.reserve(Sprites.size() + table.Sprites.size());
+
+	for (const AtlasSprite& sprite : table.Sprites)
+	{
+		SpriteInfo info;
+		info.TextureId = firstTextureId + sprite.Atlas;
+		info.SourceRect = sprite.SourceRect;
+		info.Origin = sprite.Origin;
+		info.Borders = sprite.Borders;
+		Sprites.push_back(info);
+	}
+}
+
 void SetSpriteOrigin(int spriteId, int x, int y)
 {
 	if (spriteId < 0 || spriteId >= int(Sprites.size()))
@@ -228,4 +245,111 @@ void FillRectWithSprite(int spriteId, const Rectangle& rect, Color tint, uint8_t
 				DrawTexturePro(GetTexture(sprite.TextureId), source, destRect, Vector2Zero(), 0, tint);
 		}
 	}
-}
\ No newline at end of file
+}
+
+void QueueSprite(int spriteId, float x, float y, SpriteLayer layer, float rotation, float scale, Color tint, uint8_t flip, SpriteDepth depth)
+{
+	if (spriteId < 0 || spriteId >= int(Sprites.size()))
+		return;
+
+	const SpriteInfo& sprite = Sprites[spriteId];
+
+	Rectangle source = sprite.SourceRect;
+
+	if (flip & SpriteFlipDiagonal)
+		rotation -= 90;
+	if (flip & SpriteFlipX)
+		source.width *= -1;
+	if (flip & SpriteFlipY)
+		source.height *= -1;
+
+	Rectangle destination = { x, y, sprite.SourceRect.width * scale, sprite.SourceRect.height * scale };
+
+	if (flip & SpriteFlipDiagonal)
+		destination.y += destination.height;
+
+	QueueTexture(GetTexture(sprite.TextureId), source, destination, Vector2Scale(sprite.Origin, scale), rotation, tint, layer, depth);
+}
+
+// the nine quads DrawTextureNPatch draws for a nine patch, borders shrink to fit when the rect is smaller than they are
+static void QueueNinePatch(const Texture2D& texture, const SpriteInfo& sprite, const Rectangle& rect, SpriteLayer layer, Color tint)
+{
+	float width = float(texture.width);
+	float height = float(texture.height);
+	const Rectangle& source = sprite.SourceRect;
+
+	float leftBorder = sprite.Borders.x;
+	float topBorder = sprite.Borders.y;
+	float rightBorder = sprite.Borders.width;
+	float bottomBorder = sprite.Borders.height;
+
+	float patchWidth = rect.width > 0 ? rect.width : 0;
+	float patchHeight = rect.height > 0 ? rect.height : 0;
+
+	bool drawCenter = true;
+	bool drawMiddle = true;
+
+	if (patchWidth <= leftBorder + rightBorder)
+	{
+		drawCenter = false;
+		leftBorder = (leftBorder / (leftBorder + rightBorder)) * patchWidth;
+		rightBorder = patchWidth - leftBorder;
+	}
+
+	if (patchHeight <= topBorder + bottomBorder)
+	{
+		drawMiddle = false;
+		topBorder = (topBorder / (topBorder + bottomBorder)) * patchHeight;
+		bottomBorder = patchHeight - topBorder;
+	}
+
+	// column and row edges on screen and in the texture
+	float x[4] = { rect.x, rect.x + leftBorder, rect.x + patchWidth - rightBorder, rect.x + patchWidth };
+	float y[4] = { rect.y, rect.y + topBorder, rect.y + patchHeight - bottomBorder, rect.y + patchHeight };
+	float u[4] = { source.x / width, (source.x + sprite.Borders.x) / width, (source.x + source.width - sprite.Borders.width) / width, (source.x + source.width) / width };
+	float v[4] = { source.y / height, (source.y + sprite.Borders.y) / height, (source.y + source.height - sprite.Borders.height) / height, (source.y + source.height) / height };
+
+	for (int row = 0; row < 3; row++)
+	{
+		if (row == 1 && !drawMiddle)
+			continue;
+
+		for (int column = 0; column < 3; column++)
+		{
+			if (column == 1 && !drawCenter)
+				continue;
+
+			Rectangle destination = { x[column], y[row], x[column + 1] - x[column], y[row + 1] - y[row] };
+			Rectangle coords = { u[column], v[row], u[column + 1] - u[column], v[row + 1] - v[row] };
+			QueueTextureQuad(texture.id, destination, coords, tint, layer);
+		}
+	}
+}
+
+void QueueFillRectWithSprite(int spriteId, const Rectangle& rect, SpriteLayer layer, Color tint)
+{
+	if (spriteId < 0 || spriteId >= int(Sprites.size()))
+		return;
+
+	const SpriteInfo& sprite = Sprites[spriteId];
+	const Texture2D& texture = GetTexture(sprite.TextureId);
+
+	if (sprite.Borders.width != 0 || sprite.Borders.height != 0)
+	{
+		QueueNinePatch(texture, sprite, rect, layer, tint);
+		return;
+	}
+
+	if (sprite.SourceRect.width <= 0 || sprite.SourceRect.height <= 0)
+		return;
+
+	// tiled, the last row and column are squeezed into what is left like FillRectWithSprite does
+	for (float y = rect.y; y < rect.y + rect.height; y += sprite.SourceRect.height)
+	{
+		for (float x = rect.x; x < rect.x + rect.width; x += sprite.SourceRect.width)
+		{
+			Rectangle destination = { x, y, fminf(sprite.SourceRect.width, rect.x + rect.width - x), fminf(sprite.SourceRect.height, rect.y + rect.height - y) };
+			QueueTexture(texture, sprite.SourceRect, destination, Vector2Zero(), 0, tint, layer);
+		}
+	}
+}
@@ -0,0 +1,425 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "tile_map.h"
+#include "mapped_file.h"
+#include "flat_file.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+
+// Compiled map format
+// A flat, little endian file that can be memory mapped and used in place.
+// header | layers | properties | objects | points | tiles | string table
+// Every section starts on a 4 byte boundary, strings are offsets into a table of null terminated strings
+// and offset 0 is always the empty string.
+
+constexpr char CompiledMapMagic[4] = { 'R', 'P', 'G', 'M' };
+constexpr uint32_t CompiledMapVersion = 2;
+
+struct CompiledMapHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t MapType;
+
+	uint32_t LayerCount;
+	uint32_t LayerOffset;
+
+	uint32_t PropertyCount;
+	uint32_t PropertyOffset;
+
+	uint32_t ObjectCount;
+	uint32_t ObjectOffset;
+
+	uint32_t PointCount;
+	uint32_t PointOffset;
+
+	uint32_t TileCount;
+	uint32_t TileOffset;
+
+	uint32_t StringTableSize;
+	uint32_t StringTableOffset;
+
+	// the map's own properties, as a range of the property section
+	uint32_t FirstMapProperty;
+	uint32_t MapPropertyCount;
+};
+
+struct CompiledLayer
+{
+	int32_t Id;
+	uint32_t Name;
+	uint32_t IsObject;
+
+	float Width;
+	float Height;
+	float TileWidth;
+	float TileHeight;
+
+	// range of the tile section for tile layers, or of the object section for object layers
+	uint32_t First;
+	uint32_t Count;
+};
+
+struct CompiledProperty
+{
+	uint32_t Name;
+	uint32_t Type;
+	uint32_t Value;
+};
+
+struct CompiledObject
+{
+	int32_t Id;
+	uint32_t Name;
+	uint32_t Type;
+	uint32_t Template;
+
+	float X;
+	float Y;
+	float Width;
+	float Height;
+	float Rotation;
+
+	int32_t GridTile;
+	uint32_t SubType;
+	uint32_t Visible;
+
+	uint32_t FirstProperty;
+	uint32_t PropertyCount;
+
+	uint32_t FirstPoint;
+	uint32_t PointCount;
+
+	uint32_t Text;
+	int32_t FontSize;
+};
+
+struct CompiledPoint
+{
+	float X;
+	float Y;
+};
+
+bool ReadCompiledTileMap(const char* filePath, TileMap& map)
+{
+	auto file = std::make_shared<MappedFile>();
+	if (!file->Open(filePath) || file->GetSize() < sizeof(CompiledMapHeader))
+		return false;
+
+	const uint8_t* data = file->GetData();
+	size_t size = file->GetSize();
+
+	const CompiledMapHeader& header = *reinterpret_cast<const CompiledMapHeader*>(data);
+	if (memcmp(header.Magic, CompiledMapMagic, sizeof(CompiledMapMagic)) != 0 || header.Version != CompiledMapVersion)
+		return false;
+
+	if (!SectionInFile(header.LayerOffset, header.LayerCount, sizeof(CompiledLayer), size)
+		|| !SectionInFile(header.PropertyOffset, header.PropertyCount, sizeof(CompiledProperty), size)
+		|| !SectionInFile(header.ObjectOffset, header.ObjectCount, sizeof(CompiledObject), size)
+		|| !SectionInFile(header.PointOffset, header.PointCount, sizeof(CompiledPoint), size)
+		|| !SectionInFile(header.TileOffset, header.TileCount, sizeof(Tile), size)
+		|| !SectionInFile(header.StringTableOffset, header.StringTableSize, 1, size)
+		|| header.StringTableSize == 0)
+		return false;
+
+	const auto* layers = reinterpret_cast<const CompiledLayer*>(data + header.LayerOffset);
+	const auto* properties = reinterpret_cast<const CompiledProperty*>(data + header.PropertyOffset);
+	const auto* objects = reinterpret_cast<const CompiledObject*>(data + header.ObjectOffset);
+	const auto* points = reinterpret_cast<const CompiledPoint*>(data + header.PointOffset);
+	const auto* tiles = reinterpret_cast<const Tile*>(data + header.TileOffset);
+	const char* strings = reinterpret_cast<const char*>(data + header.StringTableOffset);
+
+	// the table must end in a terminator so every offset into it is a valid C string
+	if (strings[header.StringTableSize - 1] != 0)
+		return false;
+
+	auto getString = [&](uint32_t offset) -> const char*
+	{
+		return offset < header.StringTableSize ? strings + offset : "";
+	};
+
+	auto readProperties = [&](uint32_t first, uint32_t count, std::vector<Property>& dest) -> bool
+	{
+		if (uint64_t(first) + count > header.PropertyCount)
+			return false;
+
+		dest.reserve(count);
+		for (uint32_t i = first; i < first + count; ++i)
+			dest.emplace_back(Property{ getString(properties[i].Name), getString(properties[i].Type), getString(properties[i].Value) });
+
+		return true;
+	};
+
+	map.MapType = TileMapTypes(header.MapType);
+	if (!readProperties(header.FirstMapProperty, header.MapPropertyCount, map.Properties))
+		return false;
+
+	for (uint32_t layerIndex = 0; layerIndex < header.LayerCount; ++layerIndex)
+	{
+		const CompiledLayer& record = layers[layerIndex];
+		int index = int(map.Layers.size());
+
+		if (record.IsObject == 0)
+		{
+			auto layer = std::make_shared<TileLayer>();
+			layer->Id = record.Id;
+			layer->Name = getString(record.Name);
+			layer->Size = Vector2{ record.Width, record.Height };
+			layer->TileSize = Vector2{ record.TileWidth, record.TileHeight };
+
+			if (uint64_t(record.First) + record.Count > header.TileCount)
+				return false;
+
+			// point straight into the mapped file, nothing is copied per tile
+			layer->MappedTiles = tiles + record.First;
+			layer->MappedTileCount = record.Count;
+
+			map.Layers[index] = layer;
+			map.TileLayers[index] = layer.get();
+			continue;
+		}
+
+		auto layer = std::make_shared<ObjectLayer>();
+		layer->Id = record.Id;
+		layer->Name = getString(record.Name);
+
+		if (uint64_t(record.First) + record.Count > header.ObjectCount)
+			return false;
+
+		layer->Objects.reserve(record.Count);
+		for (uint32_t objectIndex = record.First; objectIndex < record.First + record.Count; ++objectIndex)
+		{
+			const CompiledObject& source = objects[objectIndex];
+			auto subType = TileObject::SubTypes(source.SubType);
+
+			std::shared_ptr<TileObject> object;
+			if (subType == TileObject::SubTypes::Polygon || subType == TileObject::SubTypes::Polyline)
+			{
+				if (uint64_t(source.FirstPoint) + source.PointCount > header.PointCount)
+					return false;
+
+				auto poly = std::make_shared<TilePolygonObject>();
+				poly->Points.reserve(source.PointCount);
+				for (uint32_t i = source.FirstPoint; i < source.FirstPoint + source.PointCount; ++i)
+					poly->Points.emplace_back(Vector2{ points[i].X, points[i].Y });
+
+				object = poly;
+			}
+			else if (subType == TileObject::SubTypes::Text)
+			{
+				auto text = std::make_shared<TileTextObject>();
+				text->Text = getString(source.Text);
+				text->FontSize = source.FontSize;
+				object = text;
+			}
+			else
+			{
+				object = std::make_shared<TileObject>();
+			}
+
+			object->ID = source.Id;
+			object->Name = getString(source.Name);
+			object->Type = getString(source.Type);
+			object->Template = getString(source.Template);
+			object->Bounds = Rectangle{ source.X, source.Y, source.Width, source.Height };
+			object->Rotation = source.Rotation;
+			object->GridTile = source.GridTile;
+			object->SubType = subType;
+			object->Visible = source.Visible != 0;
+
+			if (!readProperties(source.FirstProperty, source.PropertyCount, object->Properties))
+				return false;
+
+			layer->Objects.emplace_back(object);
+		}
+
+		map.Layers[index] = layer;
+		map.ObjectLayers[index] = layer.get();
+	}
+
+	// tile layers point into the mapping, so it has to live as long as the map does
+	map.Source = file;
+	return true;
+}
+
+// collects the sections of a compiled map before they are written out
+class CompiledMapWriter
+{
+public:
+	std::vector<CompiledLayer> Layers;
+	std::vector<CompiledProperty> Properties;
+	std::vector<CompiledObject> Objects;
+	std::vector<CompiledPoint> Points;
+	std::vector<Tile> Tiles;
+	std::string Strings = std::string(1, '\0');
+
+	uint32_t AddString(const std::string& text)
+	{
+		if (text.empty())
+			return 0;
+
+		auto itr = StringOffsets.find(text);
+		if (itr != StringOffsets.end())
+			return itr->second;
+
+		uint32_t offset = uint32_t(Strings.size());
+		Strings.append(text);
+		Strings.push_back('\0');
+
+		StringOffsets[text] = offset;
+		return offset;
+	}
+
+	void AddProperties(const std::vector<Property>& properties, uint32_t& first, uint32_t& count)
+	{
+		first = uint32_t(Properties.size());
+		count = uint32_t(properties.size());
+
+		for (const auto& prop : properties)
+			Properties.emplace_back(CompiledProperty{ AddString(prop.Name), AddString(prop.Type), AddString(prop.Value) });
+	}
+
+private:
+	std::unordered_map<std::string, uint32_t> StringOffsets;
+};
+
+bool WriteCompiledTileMap(const char* filePath, const TileMap& map)
+{
+	CompiledMapWriter writer;
+
+	CompiledMapHeader header = {};
+	memcpy(header.Magic, CompiledMapMagic, sizeof(CompiledMapMagic));
+	header.Version = CompiledMapVersion;
+	header.MapType = uint32_t(map.MapType);
+
+	writer.AddProperties(map.Properties, header.FirstMapProperty, header.MapPropertyCount);
+
+	for (const auto& layerInfo : map.Layers)
+	{
+		const Layer& layer = *layerInfo.second;
+
+		CompiledLayer record = {};
+		record.Id = layer.Id;
+		record.Name = writer.AddString(layer.Name);
+		record.IsObject = layer.IsObject ? 1 : 0;
+		record.Width = layer.Size.x;
+		record.Height = layer.Size.y;
+
+		if (!layer.IsObject)
+		{
+			const TileLayer& tileLayer = static_cast<const TileLayer&>(layer);
+			record.TileWidth = tileLayer.TileSize.x;
+			record.TileHeight = tileLayer.TileSize.y;
+			record.First = uint32_t(writer.Tiles.size());
+			record.Count = uint32_t(tileLayer.GetTileCount());
+
+			writer.Tiles.insert(writer.Tiles.end(), tileLayer.GetTiles(), tileLayer.GetTiles() + tileLayer.GetTileCount());
+		}
+		else
+		{
+			const ObjectLayer& objectLayer = static_cast<const ObjectLayer&>(layer);
+			record.First = uint32_t(writer.Objects.size());
+			record.Count = uint32_t(objectLayer.Objects.size());
+
+			for (const auto& object : objectLayer.Objects)
+			{
+				CompiledObject compiled = {};
+				compiled.Id = object->ID;
+				compiled.Name = writer.AddString(object->Name);
+				compiled.Type = writer.AddString(object->Type);
+				compiled.Template = writer.AddString(object->Template);
+				compiled.X = object->Bounds.x;
+				compiled.Y = object->Bounds.y;
+				compiled.Width = object->Bounds.width;
+				compiled.Height = object->Bounds.height;
+				compiled.Rotation = object->Rotation;
+				compiled.GridTile = object->GridTile;
+				compiled.SubType = uint32_t(object->SubType);
+				compiled.Visible = object->Visible ? 1 : 0;
+
+				writer.AddProperties(object->Properties, compiled.FirstProperty, compiled.PropertyCount);
+
+				if (object->SubType == TileObject::SubTypes::Polygon || object->SubType == TileObject::SubTypes::Polyline)
+				{
+					const auto* poly = static_cast<const TilePolygonObject*>(object.get());
+					compiled.FirstPoint = uint32_t(writer.Points.size());
+					compiled.PointCount = uint32_t(poly->Points.size());
+
+					for (const Vector2& point : poly->Points)
+						writer.Points.emplace_back(CompiledPoint{ point.x, point.y });
+				}
+				else if (object->SubType == TileObject::SubTypes::Text)
+				{
+					const auto* text = static_cast<const TileTextObject*>(object.get());
+					compiled.Text = writer.AddString(text->Text);
+					compiled.FontSize = text->FontSize;
+				}
+
+				writer.Objects.push_back(compiled);
+			}
+		}
+
+		writer.Layers.push_back(record);
+	}
+
+	// lay the sections out one after the other
+	header.LayerCount = uint32_t(writer.Layers.size());
+	header.LayerOffset = AlignSection(sizeof(CompiledMapHeader));
+
+	header.PropertyCount = uint32_t(writer.Properties.size());
+	header.PropertyOffset = AlignSection(header.LayerOffset + header.LayerCount * uint32_t(sizeof(CompiledLayer)));
+
+	header.ObjectCount = uint32_t(writer.Objects.size());
+	header.ObjectOffset = AlignSection(header.PropertyOffset + header.PropertyCount * uint32_t(sizeof(CompiledProperty)));
+
+	header.PointCount = uint32_t(writer.Points.size());
+	header.PointOffset = AlignSection(header.ObjectOffset + header.ObjectCount * uint32_t(sizeof(CompiledObject)));
+
+	header.TileCount = uint32_t(writer.Tiles.size());
+	header.TileOffset = AlignSection(header.PointOffset + header.PointCount * uint32_t(sizeof(CompiledPoint)));
+
+	header.StringTableSize = uint32_t(writer.Strings.size());
+	header.StringTableOffset = AlignSection(header.TileOffset + header.TileCount * uint32_t(sizeof(Tile)));
+
+	FILE* file = fopen(filePath, "wb");
+	if (file == nullptr)
+		return false;
+
+	std::vector<char> strings(writer.Strings.begin(), writer.Strings.end());
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& WriteSection(file, writer.Layers, header.LayerOffset)
+		&& WriteSection(file, writer.Properties, header.PropertyOffset)
+		&& WriteSection(file, writer.Objects, header.ObjectOffset)
+		&& WriteSection(file, writer.Points, header.PointOffset)
+		&& WriteSection(file, writer.Tiles, header.TileOffset)
+		&& WriteSection(file, strings, header.StringTableOffset);
+
+	fclose(file);
+	return ok;
+}
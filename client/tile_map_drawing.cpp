@@ -25,6 +25,10 @@
 
 #include "tile_map.h"
 #include "sprites.h"
+#include "sprite_batch.h"
+
+#include <math.h>
+#include <algorithm>
 
 Rectangle CurrentViewRect = { 0 };
 
@@ -46,7 +50,11 @@ const Tile* GetTile(int x, int y, const TileLayer& layer)
 	if (x < 0 || y < 0 || x >= layer.Size.x || y >= layer.Size.y)
 		return nullptr;
 
-	return &layer.Tiles[y * int(layer.Size.x) + x];
+	size_t index = size_t(y) * int(layer.Size.x) + x;
+	if (index >= layer.GetTileCount())
+		return nullptr;
+
+	return &layer.GetTiles()[index];
 }
 
 bool RectInView(const Rectangle& rect)
@@ -66,6 +74,328 @@ bool RectInView(const Rectangle& rect)
 	return true;
 }
 
+static Rectangle MergeRects(const Rectangle& a, const Rectangle& b)
+{
+	float minX = fminf(a.x, b.x);
+	float minY = fminf(a.y, b.y);
+	float maxX = fmaxf(a.x + a.width, b.x + b.width);
+	float maxY = fmaxf(a.y + a.height, b.y + b.height);
+
+	return Rectangle{ minX, minY, maxX - minX, maxY - minY };
+}
+
+static void BuildLayerChunks(TileLayer& layer, bool orthographic)
+{
+	int width = int(layer.Size.x);
+	int height = int(layer.Size.y);
+
+	layer.ChunksX = (width + TileChunkSize - 1) / TileChunkSize;
+	layer.ChunksY = (height + TileChunkSize - 1) / TileChunkSize;
+
+	layer.Dirty = true;
+	layer.Chunks.clear();
+	layer.Chunks.resize(size_t(layer.ChunksX) * layer.ChunksY);
+
+	for (int chunkY = 0; chunkY < layer.ChunksY; ++chunkY)
+	{
+		for (int chunkX = 0; chunkX < layer.ChunksX; ++chunkX)
+		{
+			TileChunk& chunk = layer.Chunks[chunkY * layer.ChunksX + chunkX];
+			chunk.X = chunkX * TileChunkSize;
+			chunk.Y = chunkY * TileChunkSize;
+			chunk.Width = std::min(TileChunkSize, width - chunk.X);
+			chunk.Height = std::min(TileChunkSize, height - chunk.Y);
+
+			int lastX = chunk.X + chunk.Width - 1;
+			int lastY = chunk.Y + chunk.Height - 1;
+
+			// the display position is linear in x and y, so the corner tiles bound the whole chunk in both projections
+			chunk.Bounds = GetTileDisplayRect(chunk.X, chunk.Y, orthographic, layer.TileSize);
+			chunk.Bounds = MergeRects(chunk.Bounds, GetTileDisplayRect(lastX, chunk.Y, orthographic, layer.TileSize));
+			chunk.Bounds = MergeRects(chunk.Bounds, GetTileDisplayRect(chunk.X, lastY, orthographic, layer.TileSize));
+			chunk.Bounds = MergeRects(chunk.Bounds, GetTileDisplayRect(lastX, lastY, orthographic, layer.TileSize));
+
+			chunk.Empty = true;
+			for (int y = chunk.Y; y <= lastY && chunk.Empty; ++y)
+			{
+				for (int x = chunk.X; x <= lastX; ++x)
+				{
+					const Tile* tile = GetTile(x, y, layer);
+					if (tile != nullptr && tile->Sprite >= 0)
+					{
+						chunk.Empty = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void UnloadChunkCache(TileChunk& chunk)
+{
+	if (chunk.Cache.id != 0)
+		UnloadRenderTexture(chunk.Cache);
+
+	chunk.Cache = RenderTexture2D{};
+	chunk.Dirty = true;
+}
+
+// render every tile in the chunk into its cache texture, relative to the cache's top left corner
+static void BakeChunk(const TileLayer& layer, bool orthographic, TileChunk& chunk)
+{
+	chunk.Dirty = false;
+
+	if (chunk.Empty)
+	{
+		UnloadChunkCache(chunk);
+		chunk.Dirty = false;
+		return;
+	}
+
+	chunk.CacheBounds.x = chunk.Bounds.x - layer.TileSize.x;
+	chunk.CacheBounds.y = chunk.Bounds.y - layer.TileSize.y;
+	chunk.CacheBounds.width = chunk.Bounds.width + layer.TileSize.x * 2;
+	chunk.CacheBounds.height = chunk.Bounds.height + layer.TileSize.y * 2;
+
+	int width = int(ceilf(chunk.CacheBounds.width));
+	int height = int(ceilf(chunk.CacheBounds.height));
+
+	if (chunk.Cache.id == 0 || chunk.Cache.texture.width != width || chunk.Cache.texture.height != height)
+	{
+		if (chunk.Cache.id != 0)
+			UnloadRenderTexture(chunk.Cache);
+
+		chunk.Cache = LoadRenderTexture(width, height);
+	}
+
+	if (chunk.Cache.id == 0)
+	{
+		// no render texture available, the chunk will be drawn tile by tile
+		chunk.Dirty = true;
+		return;
+	}
+
+	BeginTextureMode(chunk.Cache);
+	ClearBackground(BLANK);
+
+	for (int y = chunk.Y; y < chunk.Y + chunk.Height; ++y)
+	{
+		for (int x = chunk.X; x < chunk.X + chunk.Width; ++x)
+		{
+			const Tile* tile = GetTile(x, y, layer);
+			if (tile == nullptr || tile->Sprite < 0)
+				continue;
+
+			Rectangle destinationRect = GetTileDisplayRect(x, y, orthographic, layer.TileSize);
+			QueueSprite(tile->Sprite, destinationRect.x - chunk.CacheBounds.x, destinationRect.y - chunk.CacheBounds.y, MapTileLayer, 0, 1, WHITE, tile->Flip);
+		}
+	}
+
+	FlushSpriteBatch();
+	EndTextureMode();
+}
+
+void SetTile(TileLayer& layer, int x, int y, const Tile& tile)
+{
+	if (x < 0 || y < 0 || x >= layer.Size.x || y >= layer.Size.y)
+		return;
+
+	// mapped tiles are read only, take a copy of the layer the first time it is edited
+	if (layer.MappedTiles != nullptr)
+	{
+		layer.Tiles.assign(layer.MappedTiles, layer.MappedTiles + layer.MappedTileCount);
+		layer.MappedTiles = nullptr;
+		layer.MappedTileCount = 0;
+	}
+
+	size_t index = size_t(y) * int(layer.Size.x) + x;
+	if (index >= layer.Tiles.size())
+		return;
+
+	layer.Tiles[index] = tile;
+
+	if (layer.Chunks.empty())
+		return;
+
+	TileChunk& chunk = layer.Chunks[(y / TileChunkSize) * layer.ChunksX + (x / TileChunkSize)];
+	chunk.Dirty = true;
+	if (tile.Sprite >= 0)
+		chunk.Empty = false;
+}
+
+void MarkTileLayerDirty(TileLayer& layer)
+{
+	layer.Dirty = true;
+}
+
+void UpdateTileMapCache(TileMap& map)
+{
+	bool orthographic = map.MapType == TileMapTypes::Orthographic;
+
+	for (auto& layerInfo : map.TileLayers)
+	{
+		TileLayer& layer = *layerInfo.second;
+
+		if (layer.Dirty)
+		{
+			for (TileChunk& chunk : layer.Chunks)
+				chunk.Dirty = true;
+
+			layer.Dirty = false;
+		}
+
+		for (TileChunk& chunk : layer.Chunks)
+		{
+			if (chunk.Dirty)
+				BakeChunk(layer, orthographic, chunk);
+		}
+	}
+}
+
+void UnloadTileMapCache(TileMap& map)
+{
+	for (auto& layerInfo : map.TileLayers)
+	{
+		for (TileChunk& chunk : layerInfo.second->Chunks)
+			UnloadChunkCache(chunk);
+
+		layerInfo.second->Dirty = true;
+	}
+}
+
+void BuildTileChunks(TileMap& map)
+{
+	UnloadTileMapCache(map);
+
+	bool orthographic = map.MapType == TileMapTypes::Orthographic;
+
+	for (auto& layer : map.TileLayers)
+		BuildLayerChunks(*layer.second, orthographic);
+}
+
+// work out the range of tiles that can touch the current view, clamped to the layer
+static bool GetVisibleTileRange(const TileLayer& layer, bool orthographic, int& minX, int& minY, int& maxX, int& maxY)
+{
+	if (layer.TileSize.x <= 0 || layer.TileSize.y <= 0)
+		return false;
+
+	if (orthographic)
+	{
+		minX = int(floorf(CurrentViewRect.x / layer.TileSize.x));
+		minY = int(floorf(CurrentViewRect.y / layer.TileSize.y));
+		maxX = int(floorf((CurrentViewRect.x + CurrentViewRect.width) / layer.TileSize.x));
+		maxY = int(floorf((CurrentViewRect.y + CurrentViewRect.height) / layer.TileSize.y));
+	}
+	else
+	{
+		// invert the isometric projection for each corner of the view and take the tile space bounds
+		float halfWidth = layer.TileSize.x * 0.5f;
+		float halfHeight = layer.TileSize.y * 0.5f;
+
+		Vector2 corners[4] = {
+			{ CurrentViewRect.x, CurrentViewRect.y },
+			{ CurrentViewRect.x + CurrentViewRect.width, CurrentViewRect.y },
+			{ CurrentViewRect.x, CurrentViewRect.y + CurrentViewRect.height },
+			{ CurrentViewRect.x + CurrentViewRect.width, CurrentViewRect.y + CurrentViewRect.height },
+		};
+
+		float minTileX = 0, minTileY = 0, maxTileX = 0, maxTileY = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			float xMinusY = (corners[i].x + halfWidth) / halfWidth;
+			float xPlusY = corners[i].y / halfHeight;
+
+			float tileX = (xPlusY + xMinusY) * 0.5f;
+			float tileY = (xPlusY - xMinusY) * 0.5f;
+
+			if (i == 0 || tileX < minTileX)
+				minTileX = tileX;
+			if (i == 0 || tileX > maxTileX)
+				maxTileX = tileX;
+			if (i == 0 || tileY < minTileY)
+				minTileY = tileY;
+			if (i == 0 || tileY > maxTileY)
+				maxTileY = tileY;
+		}
+
+		minX = int(floorf(minTileX));
+		minY = int(floorf(minTileY));
+		maxX = int(floorf(maxTileX));
+		maxY = int(floorf(maxTileY));
+	}
+
+	// pad by a tile, sprites with an origin can hang over the edge of their cell
+	minX = std::max(minX - 1, 0);
+	minY = std::max(minY - 1, 0);
+	maxX = std::min(maxX + 1, int(layer.Size.x) - 1);
+	maxY = std::min(maxY + 1, int(layer.Size.y) - 1);
+
+	return minX <= maxX && minY <= maxY;
+}
+
+static void DrawTileRange(const TileLayer& layer, bool orthographic, int minX, int minY, int maxX, int maxY, SpriteLayer spriteLayer)
+{
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const Tile* tile = GetTile(x, y, layer);
+			if (tile == nullptr || tile->Sprite < 0)
+				continue;
+
+			Rectangle destinationRect = GetTileDisplayRect(x, y, orthographic, layer.TileSize);
+
+			// the orthographic range is exact, the isometric one is the tile space box around a diamond
+			if (!orthographic && !RectInView(destinationRect))
+				continue;
+
+			QueueSprite(tile->Sprite, destinationRect.x, destinationRect.y, spriteLayer, 0, 1, WHITE, tile->Flip);
+		}
+	}
+}
+
+static void DrawTileLayer(const TileLayer& layer, bool orthographic, SpriteLayer spriteLayer)
+{
+	int minX, minY, maxX, maxY;
+	if (!GetVisibleTileRange(layer, orthographic, minX, minY, maxX, maxY))
+		return;
+
+	// layers that were not chunked can still be drawn directly from the visible range
+	if (layer.Chunks.empty())
+	{
+		DrawTileRange(layer, orthographic, minX, minY, maxX, maxY, spriteLayer);
+		return;
+	}
+
+	for (int chunkY = minY / TileChunkSize; chunkY <= maxY / TileChunkSize; ++chunkY)
+	{
+		for (int chunkX = minX / TileChunkSize; chunkX <= maxX / TileChunkSize; ++chunkX)
+		{
+			const TileChunk& chunk = layer.Chunks[chunkY * layer.ChunksX + chunkX];
+			if (chunk.Empty || !RectInView(chunk.Bounds))
+				continue;
+
+			if (!chunk.Dirty && chunk.Cache.id != 0)
+			{
+				// render textures are stored upside down, so flip the source
+				Rectangle source = { 0, 0, float(chunk.Cache.texture.width), -float(chunk.Cache.texture.height) };
+				Rectangle destination = { chunk.CacheBounds.x, chunk.CacheBounds.y, float(chunk.Cache.texture.width), float(chunk.Cache.texture.height) };
+				QueueTexture(chunk.Cache.texture, source, destination, Vector2{ 0, 0 }, 0, WHITE, spriteLayer);
+				continue;
+			}
+
+			DrawTileRange(layer,
+				orthographic,
+				std::max(minX, chunk.X),
+				std::max(minY, chunk.Y),
+				std::min(maxX, chunk.X + chunk.Width - 1),
+				std::min(maxY, chunk.Y + chunk.Height - 1),
+				spriteLayer);
+		}
+	}
+}
+
 void DrawTileMap(Camera2D& camera, const TileMap& map)
 {
 	CurrentViewRect.x = camera.target.x - (camera.offset.x / camera.zoom);
@@ -74,6 +404,11 @@ void DrawTileMap(Camera2D& camera, const TileMap& map)
 	CurrentViewRect.width = GetScreenWidth() / camera.zoom;
 	CurrentViewRect.height = GetScreenHeight() / camera.zoom;
 
+	bool orthographic = map.MapType == TileMapTypes::Orthographic;
+
+	// every tile layer gets its own sprite layer, so layers sharing a tileset still draw back to front
+	SpriteLayer spriteLayer = MapTileLayer;
+
 	// iterate the layers, back to front
 	for (const auto& layer : map.Layers)
 	{
@@ -85,6 +420,9 @@ void DrawTileMap(Camera2D& camera, const TileMap& map)
 			{
 				if (object->SubType == TileObject::SubTypes::Text)
 				{
+					// text isn't batched, the tiles under it have to be drawn first
+					FlushSpriteBatch();
+
 					const TileTextObject* textObject = static_cast<TileTextObject*>(object.get());
 					DrawText(textObject->Text.c_str(), int(textObject->Bounds.x), int(textObject->Bounds.y), textObject->FontSize, textObject->TextColor);
 				}
@@ -92,22 +430,7 @@ void DrawTileMap(Camera2D& camera, const TileMap& map)
 		}
 		else
 		{
-			const TileLayer& tileLayer = *(static_cast<TileLayer*>(layer.second.get()));
-
-			for (int y = 0; y < int(tileLayer.Size.y); ++y)
-			{
-				for (int x = 0; x < int(tileLayer.Size.x); ++x)
-				{
-					Rectangle destinationRect = GetTileDisplayRect(x, y, map.MapType == TileMapTypes::Orthographic, tileLayer.TileSize);
-					if (!RectInView(destinationRect))
-						continue;
-
-					const Tile* tile = GetTile(x, y, tileLayer);
-					if (tile == nullptr)
-						continue;
-					DrawSprite(tile->Sprite, destinationRect.x, destinationRect.y, 0, 1, WHITE, tile->Flip);
-				}
-			}
+			DrawTileLayer(*(static_cast<TileLayer*>(layer.second.get())), orthographic, spriteLayer++);
 		}
 	}
 }
\ No newline at end of file
@@ -26,8 +26,18 @@
 #include "tile_map.h"
 #include "sprites.h"
 
+#include "raylib.h"
 #include "pugixml.hpp"
 
+#if defined(RPG_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+
 const unsigned FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
 const unsigned FLIPPED_VERTICALLY_FLAG = 0x40000000;
 const unsigned FLIPPED_DIAGONALLY_FLAG = 0x20000000;
@@ -116,21 +126,36 @@ bool ReadTileSetFile(const std::string& tilesetFileName, int idOffset, TileMap&
 	return ReadTileSetNode(root, idOffset, map);
 }
 
-std::vector<std::string> split(const char* str, char c = ' ')
+// reads Tiled's "x,y x,y ..." point lists straight from the attribute text
+static void ReadPolygonPoints(const char* text, std::vector<Vector2>& points)
 {
-	std::vector<std::string> result;
+	size_t count = 1;
+	for (const char* c = text; *c; ++c)
+	{
+		if (*c == ' ')
+			count++;
+	}
+	points.reserve(count);
 
-	do
+	const char* pos = text;
+	char* end = nullptr;
+	while (*pos)
 	{
-		const char* begin = str;
+		float x = strtof(pos, &end);
+		if (end == pos || *end != ',')
+			break;
 
-		while (*str != c && *str)
-			str++;
+		pos = end + 1;
+		float y = strtof(pos, &end);
+		if (end == pos)
+			break;
 
-		result.push_back(std::string(begin, str));
-	} while (0 != *str++);
+		points.emplace_back(Vector2{ x, y });
 
-	return result;
+		pos = end;
+		while (*pos == ' ')
+			pos++;
+	}
 }
 
 bool ReadObjectsLayer(pugi::xml_node& root, TileMap& map)
@@ -152,22 +177,15 @@ bool ReadObjectsLayer(pugi::xml_node& root, TileMap& map)
 
 			std::shared_ptr<TileObject> object = nullptr;
 
-			if (!child.child("polygon").empty() || !child.child("polyline").empty())
+			pugi::xml_node polyNode = child.child("polygon");
+			if (polyNode.empty())
+				polyNode = child.child("polyline");
+
+			if (!polyNode.empty())
 			{
 				auto poly = std::make_shared<TilePolygonObject>();
-
-				auto points = split(child.child("polygon").attribute("points").as_string(), ' ');
-				for (auto point : points)
-				{
-					auto coords = split(point.c_str(), ',');
-					if (coords.size() == 2)
-					{
-						Vector2 p = { (float)atof(coords[0].c_str()), (float)atof(coords[1].c_str()) };
-						poly->Points.emplace_back(p);
-					}
-				}
+				ReadPolygonPoints(polyNode.attribute("points").as_string(), poly->Points);
 				object = poly;
-
 			}
 			else if (!child.child("text").empty())
 			{
@@ -200,8 +218,14 @@ bool ReadObjectsLayer(pugi::xml_node& root, TileMap& map)
 			else
 				object->SubType = TileObject::SubTypes::None;
 
+			object->ID = id;
 			object->Name = child.attribute("name").as_string();
+
+			// newer versions of tiled call the type a class, the server reads it the same way
 			object->Type = child.attribute("type").as_string();
+			if (object->Type.empty())
+				object->Type = child.attribute("class").as_string();
+
 			object->Template = child.attribute("template").as_string();
 
 			object->Bounds.x = child.attribute("x").as_float();
@@ -237,6 +261,245 @@ bool ReadObjectsLayer(pugi::xml_node& root, TileMap& map)
 	return true;
 }
 
+static void DecodeTileGid(uint32_t gid, Tile& tile)
+{
+	tile.Flip = SpriteFlipNone;
+
+	if (gid & FLIPPED_HORIZONTALLY_FLAG)
+		tile.Flip |= SpriteFlipX;
+
+	if (gid & FLIPPED_VERTICALLY_FLAG)
+		tile.Flip |= SpriteFlipY;
+
+	if (gid & FLIPPED_DIAGONALLY_FLAG)
+		tile.Flip |= SpriteFlipDiagonal;
+
+	gid &= ~(FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG);
+
+	// subtract 1 from the index, since our sprites start at 0 not 1
+	tile.Sprite = static_cast<int16_t>(gid - 1);
+}
+
+// walks the csv text once, decoding each gid straight into the pre-sized tile array
+static void ReadCSVTiles(const char* text, Tile* tiles, size_t tileCount)
+{
+	const char* pos = text;
+	size_t count = 0;
+
+	while (*pos && count < tileCount)
+	{
+		if (*pos < '0' || *pos > '9')
+		{
+			pos++;
+			continue;
+		}
+
+		uint32_t gid = 0;
+		while (*pos >= '0' && *pos <= '9')
+		{
+			gid = gid * 10 + uint32_t(*pos - '0');
+			pos++;
+		}
+
+		DecodeTileGid(gid, tiles[count++]);
+	}
+}
+
+static int Base64Value(char c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A';
+	if (c >= 'a' && c <= 'z')
+		return c - 'a' + 26;
+	if (c >= '0' && c <= '9')
+		return c - '0' + 52;
+	if (c == '+')
+		return 62;
+	if (c == '/')
+		return 63;
+
+	return -1;
+}
+
+// decodes base64 text, skipping the whitespace Tiled wraps it in
+static void DecodeBase64(const char* text, std::vector<uint8_t>& output)
+{
+	size_t length = strlen(text);
+	output.clear();
+	output.reserve(length / 4 * 3);
+
+	uint32_t bits = 0;
+	int bitCount = 0;
+
+	for (const char* pos = text; *pos && *pos != '='; ++pos)
+	{
+		int value = Base64Value(*pos);
+		if (value < 0)
+			continue;
+
+		bits = (bits << 6) | uint32_t(value);
+		bitCount += 6;
+
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			output.push_back(uint8_t(bits >> bitCount));
+		}
+	}
+}
+
+// raylib's decompressor works on raw deflate streams, so the zlib and gzip wrappers are skipped here
+static bool InflateDeflateStream(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+{
+	int outputSize = 0;
+	unsigned char* inflated = DecompressData(data, int(size), &outputSize);
+	if (inflated == nullptr)
+		return false;
+
+	output.assign(inflated, inflated + outputSize);
+	MemFree(inflated);
+	return true;
+}
+
+static bool InflateZlib(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+{
+	// CMF and FLG, deflate only and no preset dictionary
+	if (input.size() < 6 || (input[0] & 0x0F) != 8 || ((input[0] << 8) | input[1]) % 31 != 0 || (input[1] & 0x20) != 0)
+		return false;
+
+	// the trailing adler32 is not checked
+	return InflateDeflateStream(input.data() + 2, input.size() - 6, output);
+}
+
+static bool InflateGzip(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+{
+	if (input.size() < 18 || input[0] != 0x1F || input[1] != 0x8B || input[2] != 8)
+		return false;
+
+	uint8_t flags = input[3];
+	size_t pos = 10;
+
+	if (flags & 0x04) // extra field
+	{
+		if (pos + 2 > input.size())
+			return false;
+		pos += 2 + (input[pos] | (input[pos + 1] << 8));
+	}
+
+	if (flags & 0x08) // file name
+	{
+		while (pos < input.size() && input[pos] != 0)
+			pos++;
+		pos++;
+	}
+
+	if (flags & 0x10) // comment
+	{
+		while (pos < input.size() && input[pos] != 0)
+			pos++;
+		pos++;
+	}
+
+	if (flags & 0x02) // header crc
+		pos += 2;
+
+	// the trailing crc32 and size are not checked
+	if (pos + 8 > input.size())
+		return false;
+
+	return InflateDeflateStream(input.data() + pos, input.size() - pos - 8, output);
+}
+
+static bool InflateZstd(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+{
+#if defined(RPG_WITH_ZSTD)
+	unsigned long long size = ZSTD_getFrameContentSize(input.data(), input.size());
+	if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN)
+		return false;
+
+	output.resize(size_t(size));
+	size_t result = ZSTD_decompress(output.data(), output.size(), input.data(), input.size());
+	return !ZSTD_isError(result) && result == output.size();
+#else
+	(void)input;
+	(void)output;
+	TraceLog(LOG_WARNING, "MAP: zstd compressed layers need a build with RPG_WITH_ZSTD");
+	return false;
+#endif
+}
+
+static bool ReadBase64Tiles(const char* text, const std::string& compression, Tile* tiles, size_t tileCount)
+{
+	// the buffers are kept between layers so large maps do not reallocate for every layer
+	static std::vector<uint8_t> decoded;
+	static std::vector<uint8_t> inflated;
+
+	DecodeBase64(text, decoded);
+
+	const std::vector<uint8_t>* gidData = &decoded;
+	if (!compression.empty())
+	{
+		bool ok = false;
+		if (compression == "zlib")
+			ok = InflateZlib(decoded, inflated);
+		else if (compression == "gzip")
+			ok = InflateGzip(decoded, inflated);
+		else if (compression == "zstd")
+			ok = InflateZstd(decoded, inflated);
+		else
+			TraceLog(LOG_WARNING, "MAP: Unknown layer compression %s", compression.c_str());
+
+		if (!ok)
+			return false;
+
+		gidData = &inflated;
+	}
+
+	// little endian 32 bit gids, one per tile
+	size_t count = std::min(tileCount, gidData->size() / 4);
+	const uint8_t* bytes = gidData->data();
+	for (size_t i = 0; i < count; ++i, bytes += 4)
+	{
+		uint32_t gid = uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+		DecodeTileGid(gid, tiles[i]);
+	}
+
+	return true;
+}
+
+static void ReadTileLayerData(pugi::xml_node data, TileLayer& layer, size_t tileCount)
+{
+	// the map size is known up front, so every layer is sized once and filled in place
+	layer.Tiles.assign(tileCount, Tile());
+
+	std::string encoding = data.attribute("encoding").as_string();
+	if (encoding == "csv")
+	{
+		ReadCSVTiles(data.child_value(), layer.Tiles.data(), tileCount);
+	}
+	else if (encoding == "base64")
+	{
+		if (!ReadBase64Tiles(data.child_value(), data.attribute("compression").as_string(), layer.Tiles.data(), tileCount))
+			TraceLog(LOG_WARNING, "MAP: Failed to decode layer %s", layer.Name.c_str());
+	}
+	else if (encoding.empty())
+	{
+		// the old uncompressed xml format, one tile element per cell
+		size_t count = 0;
+		for (pugi::xml_node tile : data.children("tile"))
+		{
+			if (count >= tileCount)
+				break;
+
+			DecodeTileGid(tile.attribute("gid").as_uint(), layer.Tiles[count++]);
+		}
+	}
+	else
+	{
+		TraceLog(LOG_WARNING, "MAP: Unknown layer encoding %s in layer %s", encoding.c_str(), layer.Name.c_str());
+	}
+}
+
 bool ReadTiledXML(pugi::xml_document& doc, TileMap& map, const std::string& filePath = std::string())
 {
 	auto root = doc.child("map");
@@ -313,74 +576,59 @@ bool ReadTiledXML(pugi::xml_document& doc, TileMap& map, const std::string& file
 			layer.TileSize.x = float(tilewidth);
 			layer.TileSize.y = float(tileheight);
 
-			auto data = child.child("data");
-			std::string encoding = data.attribute("encoding").as_string();
-			if (encoding == "csv")
-			{
-				std::string contents = data.first_child().value();
-
-				std::vector<std::vector<int>> rawData;
-
-				int posX = 0;
-				int posY = 0;
-
-				size_t linePos = 0;
-				do
-				{
-					size_t nextLine = contents.find_first_of('\n', linePos);
-					if (nextLine == std::string::npos)
-						nextLine = contents.size();
-
-					std::string colText = contents.substr(linePos, nextLine - linePos);
-					linePos = nextLine + 1;
+			ReadTileLayerData(child.child("data"), layer, size_t(width) * size_t(height));
+		}
+	}
 
-					if (colText.size() == 0)
-						continue;
-					size_t charPos = 0;
-					posX = 0;
-					do
-					{
-						size_t nextDelim = colText.find_first_of(',', charPos);
-						if (nextDelim == std::string::npos || nextDelim == colText.size() - 1)
-							nextDelim = colText.size();
+	return true;
+}
 
-						std::string valStr = colText.substr(charPos, nextDelim - charPos);
-						uint32_t val = static_cast<uint32_t>(std::atoll(valStr.c_str()));
-						charPos = nextDelim + 1;
+static void ResetTileMap(TileMap& map)
+{
+	map.TileLayers.clear();
+	map.ObjectLayers.clear();
+	map.Layers.clear();
+	map.Properties.clear();
+	map.Source.reset();
+}
 
-						Tile tile;
-						if (val & FLIPPED_HORIZONTALLY_FLAG)
-							tile.Flip |= SpriteFlipX;
+// a compiled map is only used if it is at least as new as the .tmx it was built from
+static bool CompiledMapIsCurrent(const std::string& sourcePath, const std::string& compiledPath)
+{
+	std::error_code error;
+	auto compiledTime = std::filesystem::last_write_time(compiledPath, error);
+	if (error)
+		return false;
 
-						if (val & FLIPPED_VERTICALLY_FLAG)
-							tile.Flip |= SpriteFlipY;
+	auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+		return true; // only the compiled map shipped
 
-						if (val & FLIPPED_DIAGONALLY_FLAG)
-							tile.Flip |= SpriteFlipDiagonal;
+	return compiledTime >= sourceTime;
+}
 
-						val &= ~(FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG);
+bool ReadTileMap(const char* filename, TileMap& map)
+{
+	ResetTileMap(map);
 
-						// subtract 1 from the index, since our sprites start at 0 not 1
-						tile.Sprite = static_cast<int16_t>(val-1);
+	if (filename == nullptr)
+		return false;
 
-						layer.Tiles.emplace_back(std::move(tile));
-						posX++;
+	std::string compiledPath = GetCompiledMapPath(filename);
+	if (compiledPath == filename || CompiledMapIsCurrent(filename, compiledPath))
+	{
+		if (ReadCompiledTileMap(compiledPath.c_str(), map))
+			return true;
 
-					} while (charPos <= colText.size());
-					posY++;
-				} while (linePos < contents.size() && linePos != std::string::npos);
-			}
-		}
+		ResetTileMap(map);
 	}
 
-	return true;
+	return ReadTileMapXML(filename, map);
 }
 
-bool ReadTileMap(const char* filename, TileMap& map)
+bool ReadTileMapXML(const char* filename, TileMap& map)
 {
-	map.TileLayers.clear();
-	map.ObjectLayers.clear();
-	map.Layers.clear();
+	ResetTileMap(map);
 
 	if (filename == nullptr)
 		return false;
@@ -389,3 +637,13 @@ bool ReadTileMap(const char* filename, TileMap& map)
 	pugi::xml_parse_result result = doc.load_file(filename);
 	return result.status == pugi::xml_parse_status::status_ok && ReadTiledXML(doc, map, filename);
 }
+
+std::string GetCompiledMapPath(const std::string& filePath)
+{
+	auto extension = filePath.find_last_of('.');
+	auto term = filePath.find_last_of('/');
+	if (extension == std::string::npos || (term != std::string::npos && extension < term))
+		return filePath + CompiledMapExtension;
+
+	return filePath.substr(0, extension) + CompiledMapExtension;
+}
@@ -19,13 +19,13 @@ typedef enum
     LOG_NONE            // Disable logging
 } TraceLogLevel;
 
-std::shared_ptr<ENetClient> ENetClient::Create(uint8_t id)
+std::shared_ptr<ENetClient> ENetClient::Create(PlayerId id)
 {
     return std::make_shared<ENetClient>(id);
 }
 
-ENetClient::ENetClient(uint8_t id)
-    : Client(nullptr), Server(nullptr), Id(id)
+ENetClient::ENetClient(PlayerId id)
+    : Id(id), Client(nullptr), Server(nullptr)
 {
 
     if (enet_initialize() != 0) {
@@ -51,7 +51,7 @@ bool ENetClient::IsConnected()
     return Server != nullptr && Server->state == ENET_PEER_STATE_CONNECTED;
 }
 
-int ENetClient::Connect(const std::string &host, uint32_t port)
+int ENetClient::Connect(const std::string &host, uint32_t port, RoomId room)
 {
     if (IsConnected()) {
         TraceLog(LOG_DEBUG, "ENetClient is already connected to the server");
@@ -63,7 +63,8 @@ int ENetClient::Connect(const std::string &host, uint32_t port)
     address.port = port;
 
 
-    Server = enet_host_connect(Client, &address, NUM_CHANNELS, Id);
+    // the id we would like in the low half, the room in the high half
+    Server = enet_host_connect(Client, &address, NUM_CHANNELS, uint32_t(Id) | uint32_t(room) << 16);
     if (Server == nullptr) {
         TraceLog(LOG_ERROR, "No available peers for initiating an ENet connection");
         return 1;
@@ -81,31 +82,103 @@ int ENetClient::Connect(const std::string &host, uint32_t port)
     return 1;
 }
 
-const Position *ENetClient::GetPosition(uint8_t playerId)
+void ENetClient::Poll(const MessageDispatcher &dispatcher)
 {
+    if (Client == nullptr)
+        return;
+
     ENetEvent event;
-    if (enet_host_service(Client, &event, 0)) {
+    while (enet_host_service(Client, &event, 0) > 0) {
         if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-            const auto *message = GetMessage(event.packet->data);
-            if (message->player_id() == playerId && message->content_type() == Content_Position) {
-                auto pos = static_cast<const Position *> (message->content());
-                return pos;
+            // the handlers read each message where it lies, the packet goes once they are done with all of them
+            PacketPtr packet(event.packet);
+
+            size_t offset = 0;
+            while (offset < packet->dataLength) {
+                const Message *message = ReadMessage(packet.get(), offset);
+                if (message == nullptr) {
+                    TraceLog(LOG_WARNING, "Dropped a malformed message from the server");
+                    break;
+                }
+
+                if (message->content_type() == Content_Welcome) {
+                    // everything we send from now on is stamped with the id the server gave us
+                    Id = message->content_as_Welcome()->player_id();
+                    Welcomed = true;
+                }
+
+                if (!dispatcher.Dispatch(message))
+                    TraceLog(LOG_DEBUG, "Ignored a %s message from the server", EnumNameContent(message->content_type()));
             }
         }
+        else if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
+            TraceLog(LOG_WARNING, "Disconnected from server");
+            Server = nullptr;
+            Welcomed = false;
+        }
     }
-    return nullptr;
 }
 
-void ENetClient::SendPosition(float x, float y)
+bool ENetClient::Send(const MessagePacket &packet)
 {
-    auto *packet = SerializePosition(Id, x, y);
-    if (enet_peer_send(Server, RELIABLE_CHANNEL, packet) == 0) {
-        TraceLog(LOG_DEBUG, "Message was sent");
-        enet_host_flush(Client);
-    }
-    else {
+    if (packet.Packet == nullptr)
+        return false;
+
+    if (enet_peer_send(Server, packet.Channel, packet.Packet) != 0) {
         TraceLog(LOG_ERROR, "Message failed to send");
+        enet_packet_destroy(packet.Packet);
+        return false;
+    }
+
+    return true;
+}
+
+void ENetClient::Queue(Content type, const flatbuffers::FlatBufferBuilder &builder)
+{
+    if (type == Content_NONE || !IsConnected())
+        return;
+
+    Delivery delivery = GetDelivery(type);
+    Batches[delivery.Channel].Add(Packets, builder, delivery.Flags);
+}
+
+void ENetClient::SendInput(const InputCommand &input)
+{
+    BuilderPool::Lease builder = GetBuilderPool().Acquire();
+    Queue(SerializeInput(*builder, Id, input), *builder);
+}
+
+void ENetClient::SendMove(const MoveStep *steps, size_t count)
+{
+    BuilderPool::Lease builder = GetBuilderPool().Acquire();
+    Queue(SerializeMove(*builder, Id, steps, count), *builder);
+}
+
+void ENetClient::SendAck(uint32_t tick)
+{
+    BuilderPool::Lease builder = GetBuilderPool().Acquire();
+    Queue(SerializeAck(*builder, Id, tick), *builder);
+}
+
+void ENetClient::Flush()
+{
+    bool connected = IsConnected();
+    bool sent = false;
+
+    for (uint8_t channel = 0; channel < NUM_CHANNELS; channel++) {
+        if (!connected) {
+            Batches[channel].Clear(Packets);
+            continue;
+        }
+
+        ENetPacket *packet = Batches[channel].TakePacket(Packets);
+        if (packet != nullptr)
+            sent = Send(MessagePacket{packet, channel}) || sent;
     }
+
+    // what was queued this frame goes out now instead of on the next poll
+    if (sent)
+        enet_host_flush(Client);
 }
 
 void ENetClient::Disconnect()
@@ -146,6 +219,7 @@ void ENetClient::Disconnect()
             enet_peer_reset(Server);
         }
         Server = nullptr;
+        Welcomed = false;
     }
 }
 }
\ No newline at end of file
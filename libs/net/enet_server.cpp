@@ -10,7 +10,7 @@ std::shared_ptr<ENetServer> ENetServer::Create()
 }
 
 ENetServer::ENetServer()
-    : Server(nullptr), Clients({nullptr, nullptr})
+    : Server(nullptr)
 {
     if (enet_initialize() != 0) {
         spdlog::error("An error occurred while initializing ENet");
@@ -28,89 +28,275 @@ ENetServer::~ENetServer()
     enet_deinitialize();
 }
 
-int ENetServer::Start(uint32_t port)
+int ENetServer::Start(uint32_t port, uint32_t maxPlayers)
 {
+    if (maxPlayers < 1 || maxPlayers > SERVER_PEER_LIMIT) {
+        spdlog::error("Can't serve {} players, the limit is {}", maxPlayers, SERVER_PEER_LIMIT);
+        return 1;
+    }
+
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     address.port = port;
 
-    Server = enet_host_create(&address, net::SERVER_MAX_CONNECTIONS, net::NUM_CHANNELS, 0, 0);
+    Server = enet_host_create(&address, maxPlayers, net::NUM_CHANNELS, 0, 0);
 
     if (Server == nullptr) {
         spdlog::error("An error occurred while trying to create an ENet server host.");
         return 1;
     }
+
+    MaxPlayers = maxPlayers;
+    Peers.assign(maxPlayers + 1, nullptr);
+    Batches.assign(maxPlayers + 1, {});
+    ConnectedIndex.assign(maxPlayers + 1, 0);
+    RequestedRooms.assign(maxPlayers + 1, ANY_ROOM);
+    Connected.clear();
+    Connected.reserve(maxPlayers);
+
+    // handed out lowest first, the back of the list is the next id
+    FreeIds.clear();
+    for (uint32_t id = maxPlayers; id > 0; id--)
+        FreeIds.push_back(PlayerId(id));
+
+    IdQueued.assign(maxPlayers + 1, true);
+    IdQueued[NO_PLAYER] = false;
     return 0;
 }
 
-void ENetServer::Poll()
+ENetPeer *ENetServer::GetPeer(PlayerId playerId) const
+{
+    return playerId != NO_PLAYER && playerId < Peers.size() ? Peers[playerId] : nullptr;
+}
+
+RoomId ENetServer::GetRequestedRoom(PlayerId playerId) const
+{
+    return GetPeer(playerId) != nullptr ? RequestedRooms[playerId] : ANY_ROOM;
+}
+
+PlayerId ENetServer::AddPeer(ENetPeer *peer, PlayerId requested)
+{
+    // a client can ask for the id it had before, if nobody has taken it since
+    PlayerId playerId = NO_PLAYER;
+    if (requested != NO_PLAYER && requested <= MaxPlayers && Peers[requested] == nullptr)
+        playerId = requested;
+
+    // ids taken by request are still in the free list, they are skipped when they come up
+    while (playerId == NO_PLAYER && !FreeIds.empty()) {
+        PlayerId next = FreeIds.back();
+        FreeIds.pop_back();
+        IdQueued[next] = false;
+
+        if (Peers[next] == nullptr)
+            playerId = next;
+    }
+
+    if (playerId == NO_PLAYER)
+        return NO_PLAYER;
+
+    Peers[playerId] = peer;
+    ConnectedIndex[playerId] = uint32_t(Connected.size());
+    Connected.push_back(playerId);
+    peer->data = reinterpret_cast<void *>(intptr_t(playerId));
+
+    return playerId;
+}
+
+void ENetServer::RemovePeer(PlayerId playerId)
+{
+    ENetPeer *peer = GetPeer(playerId);
+    if (peer == nullptr)
+        return;
+
+    peer->data = nullptr;
+    Peers[playerId] = nullptr;
+
+    // whoever gets the id next must not get what was queued for this player
+    for (MessageBatch &batch : Batches[playerId])
+        batch.Clear(Packets);
+
+    // swap the last player into the hole
+    uint32_t index = ConnectedIndex[playerId];
+    PlayerId last = Connected.back();
+    Connected[index] = last;
+    ConnectedIndex[last] = index;
+    Connected.pop_back();
+
+    if (!IdQueued[playerId]) {
+        FreeIds.push_back(playerId);
+        IdQueued[playerId] = true;
+    }
+}
+
+void ENetServer::Poll(uint32_t timeout)
 {
+    if (!IsServing())
+        return;
+
     ENetEvent event;
-    while (true) {
-        auto res = enet_host_service(Server, &event, net::SERVER_TIMEOUT);
-        if (res > 0) {
-            if (event.type == ENET_EVENT_TYPE_CONNECT) {
-                spdlog::debug("Player {} connected from {}:{}, peer id {}, peer data {}",
-                              event.data,
-                              event.peer->address.host,
-                              event.peer->address.port, event.peer->incomingPeerID, event.peer->data);
-                int playerId = event.data;
-                Clients[playerId - 1] = event.peer;
-            }
-            else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-                spdlog::debug("Receive message from {}:{}, peer id {}",
-                              event.peer->address.host, event.peer->address.port, event.peer->incomingPeerID);
-                auto const *message = GetMessage(event.packet->data);
-                auto playerId = message->player_id();
-
-                if (message->content_type() == Content_Position) {
-                    if (Clients[2 - playerId] != nullptr && Clients[2 - playerId]->state == ENET_PEER_STATE_CONNECTED) {
-                        enet_peer_send(Clients[2 - playerId], RELIABLE_CHANNEL, event.packet);
-                    }
-                    else {
-                        spdlog::error("Failed to forward the message to player {}", 3 - playerId);
-                    }
-                }
-
-                // enet_host_broadcast(Server, 0, event.packet);
-                // enet_packet_destroy(event.packet);
-            }
-            else if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
-                auto playerId = event.data;
-                spdlog::debug("Player {} disconnected", playerId);
-                Clients[playerId - 1] = nullptr;
-            }
+    auto res = enet_host_service(Server, &event, timeout);
+    while (res > 0) {
+        HandleEvent(event);
+        res = enet_host_service(Server, &event, 0);
+    }
+
+    if (res < 0) {
+        spdlog::error("Error occurred during polling");
+    }
+}
+
+void ENetServer::HandleEvent(ENetEvent &event)
+{
+    if (event.type == ENET_EVENT_TYPE_CONNECT) {
+        // the client's connect data holds the id it would like and the room it wants to play in
+        auto requested = PlayerId(event.data & 0xFFFF);
+        PlayerId playerId = AddPeer(event.peer, requested);
+        if (playerId == NO_PLAYER) {
+            spdlog::error("Rejecting connection from {}:{}, the server is full",
+                          event.peer->address.host,
+                          event.peer->address.port);
+            enet_peer_disconnect(event.peer, 0);
+            return;
         }
-        else if (res < 0) {
-            spdlog::error("Error occurred during polling");
-            break;
+
+        RequestedRooms[playerId] = RoomId(event.data >> 16);
+
+        spdlog::debug("Player {} connected from {}:{}, peer id {}, {} players online",
+                      playerId,
+                      event.peer->address.host,
+                      event.peer->address.port,
+                      event.peer->incomingPeerID,
+                      Connected.size());
+
+        // the welcome goes out before anything the game sends for the new player
+        Send(playerId, SerializeWelcome(playerId));
+
+        if (OnConnect)
+            OnConnect(playerId);
+    }
+    else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+        // the sender is whoever owns the peer, not whatever id the message claims
+        auto playerId = PlayerId(reinterpret_cast<intptr_t>(event.peer->data));
+        PacketPtr packet(event.packet);
+
+        if (playerId == NO_PLAYER) {
+            spdlog::debug("Dropping message from unregistered peer {}", event.peer->incomingPeerID);
+            return;
         }
-        else {
-            break;
+
+        if (OnPacket) {
+            OnPacket(playerId, std::move(packet));
+            return;
         }
+
+        size_t offset = 0;
+        while (offset < packet->dataLength) {
+            const Message *message = ReadMessage(packet.get(), offset);
+            if (message == nullptr) {
+                spdlog::error("Dropping malformed message from player {}", playerId);
+                break;
+            }
+
+            if (OnMessage)
+                OnMessage(playerId, message);
+        }
+    }
+    else if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
+        auto playerId = PlayerId(reinterpret_cast<intptr_t>(event.peer->data));
+        if (playerId == NO_PLAYER)
+            return;
+
+        RemovePeer(playerId);
+        spdlog::debug("Player {} disconnected, {} players online", playerId, Connected.size());
+
+        if (OnDisconnect)
+            OnDisconnect(playerId);
     }
 }
 
-void ENetServer::Shutdown()
+void ENetServer::Send(PlayerId playerId, const MessagePacket &packet)
+{
+    ENetPeer *peer = GetPeer(playerId);
+    if (peer == nullptr || peer->state != ENET_PEER_STATE_CONNECTED
+        || enet_peer_send(peer, packet.Channel, packet.Packet) != 0) {
+        spdlog::error("Failed to send a message to player {}", playerId);
+        enet_packet_destroy(packet.Packet);
+    }
+}
+
+void ENetServer::Multicast(const std::vector<PlayerId> &players, const MessagePacket &packet)
+{
+    for (PlayerId playerId : players) {
+        ENetPeer *peer = GetPeer(playerId);
+        if (peer != nullptr && peer->state == ENET_PEER_STATE_CONNECTED)
+            enet_peer_send(peer, packet.Channel, packet.Packet);
+    }
+
+    // every peer that queued it holds a reference, nobody did if it was sent to no one
+    if (packet.Packet->referenceCount == 0)
+        enet_packet_destroy(packet.Packet);
+}
+
+void ENetServer::Broadcast(const MessagePacket &packet)
+{
+    Multicast(Connected, packet);
+}
+
+void ENetServer::Queue(PlayerId playerId, Content type, const flatbuffers::FlatBufferBuilder &builder)
 {
+    if (GetPeer(playerId) == nullptr)
+        return;
+
+    Delivery delivery = GetDelivery(type);
+    Batches[playerId][delivery.Channel].Add(Packets, builder, delivery.Flags);
+}
 
+void ENetServer::Queue(const std::vector<PlayerId> &players, Content type, const flatbuffers::FlatBufferBuilder &builder)
+{
+    for (PlayerId playerId : players)
+        Queue(playerId, type, builder);
+}
+
+void ENetServer::Flush()
+{
+    if (!IsServing())
+        return;
+
+    for (PlayerId playerId : Connected) {
+        for (uint8_t channel = 0; channel < NUM_CHANNELS; channel++) {
+            ENetPacket *packet = Batches[playerId][channel].TakePacket(Packets);
+            if (packet != nullptr)
+                Send(playerId, MessagePacket{packet, channel});
+        }
+    }
+
+    enet_host_flush(Server);
+}
+
+void ENetServer::Disconnect(PlayerId playerId)
+{
+    // the player is removed when the disconnect is acknowledged
+    ENetPeer *peer = GetPeer(playerId);
+    if (peer != nullptr)
+        enet_peer_disconnect(peer, 0);
+}
+
+void ENetServer::Shutdown()
+{
     if (!IsServing()) {
         return;
     }
 
-    for (auto it : Clients) {
-        if (it != nullptr) {
-            spdlog::debug("Disconnecting from player {}", it->incomingPeerID);
-            enet_peer_disconnect(it, 0);
-        }
+    for (PlayerId playerId : Connected) {
+        spdlog::debug("Disconnecting from player {}", playerId);
+        enet_peer_disconnect(Peers[playerId], 0);
     }
 
     auto start = std::chrono::steady_clock::now();
-    bool success = false;
 
     ENetEvent event;
 
-    while (true) {
+    while (!Connected.empty()) {
         auto res = enet_host_service(Server, &event, 0);
         if (res > 0) {
             if (event.type == ENET_EVENT_TYPE_RECEIVE) {
@@ -118,16 +304,14 @@ void ENetServer::Shutdown()
                 enet_packet_destroy(event.packet);
             }
             else if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
-                Clients[event.peer->incomingPeerID] = nullptr;
+                RemovePeer(PlayerId(reinterpret_cast<intptr_t>(event.peer->data)));
                 spdlog::debug("Disconnection of client {} is successful, {} clients remaining",
                               event.peer->incomingPeerID,
-                              Clients.size());
-                break;
+                              Connected.size());
             }
             else if (event.type == ENET_EVENT_TYPE_CONNECT) {
                 spdlog::debug("Connection accepted from client {} during server shutdown, disconnect",
                               event.peer->incomingPeerID);
-                Clients[event.peer->incomingPeerID] = event.peer;
                 enet_peer_disconnect(event.peer, 0);
             }
         }
@@ -136,12 +320,6 @@ void ENetServer::Shutdown()
             break;
         }
         else {
-            if (Clients.empty()) {
-                // all clients successfully disconnected
-                spdlog::debug("Disconnection from all clients successful");
-                success = true;
-                break;
-            }
             // check timeout
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>
                 (std::chrono::steady_clock::now() - start).count();
@@ -152,15 +330,17 @@ void ENetServer::Shutdown()
         }
     }
 
+    if (Connected.empty())
+        spdlog::debug("Disconnection from all clients successful");
+
     // force disconnect the remaining clients
-    for (auto it : Clients) {
-        if (it != nullptr) {
-            spdlog::debug("Forcibly disconnecting player {}", it->incomingPeerID);
-            enet_peer_reset(it);
-        }
+    while (!Connected.empty()) {
+        PlayerId playerId = Connected.back();
+        spdlog::debug("Forcibly disconnecting player {}", playerId);
+        enet_peer_reset(Peers[playerId]);
+        RemovePeer(playerId);
     }
 
-    Clients = {nullptr, nullptr};
     // destroy the host
     enet_host_destroy(Server);
     Server = nullptr;
@@ -3,15 +3,33 @@
 #include "enet/enet.h"
 #include "spdlog/spdlog.h"
 #include "serialize_generated.h"
+#include "packet_pool.h"
 
 #include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace Serialize;
 
 namespace net
 {
 
-constexpr uint32_t SERVER_MAX_CONNECTIONS = 2;
+// players are numbered from 1, 0 means nobody
+using PlayerId = uint16_t;
+
+constexpr PlayerId NO_PLAYER = 0;
+
+// rooms are numbered from 1, 0 lets the server pick one
+using RoomId = uint16_t;
+
+constexpr RoomId ANY_ROOM = 0;
+
+constexpr uint32_t SERVER_MAX_CONNECTIONS = 256;
+
+// enet can't address more peers than this on one host
+constexpr uint32_t SERVER_PEER_LIMIT = ENET_PROTOCOL_MAXIMUM_PEER_ID;
 
 constexpr time_t SERVER_TIMEOUT = 50000;
 
@@ -19,31 +37,157 @@ constexpr uint32_t CLIENT_MAX_CONNECTIONS = 1;
 
 constexpr time_t CLIENT_TIMEOUT = 1000;
 
+// the server ticks its world at this rate, clients predict their own player at the same one
+constexpr float SERVER_TICK_RATE = 60;
+
+// things that happen once, resent until they arrive and handed over in order
 constexpr uint8_t RELIABLE_CHANNEL = 0;
 
+// state that is replaced all the time, enet sequences unreliable packets on a channel and drops any that arrive
+// after a newer one, so a lost packet never holds up the ones behind it and the newest always wins
 constexpr uint8_t UNRELIABLE_CHANNEL = 1;
 
 constexpr uint8_t NUM_CHANNELS = 2;
 
-ENetPacket *SerializePosition(uint8_t user, float x, float y);
+// PlayerSnapshot flags
+constexpr uint32_t PLAYER_FLAG_TARGET_ACTIVE = 0x01;
+
+constexpr uint32_t PLAYER_FLAG_WAITING = 0x02;
+
+// MoveStep flags
+constexpr uint32_t MOVE_FLAG_TARGET = 0x01;
+
+// every Move packet repeats this many of the newest moves, so it takes that many lost packets in a row to lose one
+constexpr uint32_t MOVE_REDUNDANCY = 4;
+
+// EntityRef kinds
+constexpr uint32_t ENTITY_KIND_PLAYER = 0;
+
+constexpr uint32_t ENTITY_KIND_MOB = 1;
+
+constexpr uint32_t ENTITY_KIND_DROP = 2;
+
+// the client camera shows a 1280x700 window at zoom 1 and keeps the player at least 200 pixels inside it,
+// so the player can see at most this far to either side of where they stand
+constexpr float VIEW_RANGE_X = 1080;
+
+constexpr float VIEW_RANGE_Y = 500;
+
+// the item actions a player asked for since the last input was sent, movement goes as MoveSteps
+struct InputCommand
+{
+    uint32_t Sequence = 0;
+
+    int16_t ActivateSlot = -1;
+    int16_t DropSlot = -1;
+};
+
+// how a kind of message travels
+struct Delivery
+{
+    uint8_t Channel = RELIABLE_CHANNEL;
+    uint32_t Flags = ENET_PACKET_FLAG_RELIABLE;
+};
+
+// the one place that decides which messages may be lost, everything not listed is reliable
+Delivery GetDelivery(Content type);
+
+// a packet and the channel its kind of message goes out on
+struct MessagePacket
+{
+    ENetPacket *Packet = nullptr;
+    uint8_t Channel = RELIABLE_CHANNEL;
+};
+
+// each finishes its message in the builder and returns the content type, Content_NONE if there is nothing to send
+// the moves go as an unreliable Move and the item actions as a reliable Input
+Content SerializeMove(flatbuffers::FlatBufferBuilder &builder, PlayerId user, const Serialize::MoveStep *steps, size_t count);
+Content SerializeInput(flatbuffers::FlatBufferBuilder &builder, PlayerId user, const InputCommand &input);
+Content SerializeAck(flatbuffers::FlatBufferBuilder &builder, PlayerId user, uint32_t tick);
+
+MessagePacket SerializeWelcome(PlayerId user);
+
+// wraps a finished content table in a Message, size prefixed so it can share a packet with others
+void FinishMessage(flatbuffers::FlatBufferBuilder &builder, PlayerId user, Content type, flatbuffers::Offset<void> content);
+
+// finishes the message and copies it into a packet of its own, made for how the content travels
+MessagePacket CreateMessagePacket(flatbuffers::FlatBufferBuilder &builder,
+                                  PlayerId user,
+                                  Content type,
+                                  flatbuffers::Offset<void> content);
+
+// owns a received packet, a message read from it points into its data and must not outlive it
+struct PacketDeleter
+{
+    void operator()(ENetPacket *packet) const { enet_packet_destroy(packet); }
+};
+
+using PacketPtr = std::unique_ptr<ENetPacket, PacketDeleter>;
+
+// the message at offset in a packet, offset is moved on to the next one
+// nullptr once the packet is used up or if the message isn't valid, nothing after a bad one can be trusted
+const Message *ReadMessage(const ENetPacket *packet, size_t &offset);
+
+using MessageHandler = std::function<void(const Message *)>;
+
+// hands each message to the handler for its content type, the content is read in place from the packet
+class MessageDispatcher
+{
+public:
+    template<typename T>
+    void On(std::function<void(const T *)> handler)
+    {
+        Handlers[ContentTraits<T>::enum_value] = [handler = std::move(handler)](const Message *message)
+        { handler(message->content_as<T>()); };
+    }
+
+    // false if nothing handles the message's content type
+    bool Dispatch(const Message *message) const;
+
+private:
+    std::array<MessageHandler, Content_MAX + 1> Handlers;
+};
 
 class ENetClient
 {
 public:
-    static std::shared_ptr<ENetClient> Create(uint8_t id);
-    ENetClient(uint8_t id);
+    // the id is only a request, the server may hand out another one in its welcome
+    static std::shared_ptr<ENetClient> Create(PlayerId id);
+    ENetClient(PlayerId id);
     ~ENetClient();
     bool IsConnected();
-    int Connect(const std::string &host, uint32_t port);
-    const Position *GetPosition(uint8_t playerId);
-    void SendPosition(float x, float y);
+    // players that ask for the same room play in the same world, as long as it has space
+    int Connect(const std::string &host, uint32_t port, RoomId room = ANY_ROOM);
+    // the item actions go reliable, moves go on their own so a lost one never holds them up
+    void SendInput(const InputCommand &input);
+
+    // the newest moves oldest first, unreliable since the next packet repeats them
+    void SendMove(const Serialize::MoveStep *steps, size_t count);
+
+    // tells the server the newest state we have, unreliable since a newer ack replaces a lost one
+    void SendAck(uint32_t tick);
+
+    // the sends above only queue, this sends everything queued as one packet per channel
+    void Flush();
+
+    // NO_PLAYER until the server has welcomed us
+    PlayerId GetPlayerId() const { return Welcomed ? Id : NO_PLAYER; }
+
+    // dispatches every message that has arrived since the last poll, so a backlog never waits for the next frame
+    void Poll(const MessageDispatcher &dispatcher);
     // int logType, const char *text, ..
     void (*TraceLog)(int, const char *...);
 private:
-    uint8_t Id;
+    PlayerId Id;
+    bool Welcomed = false;
     ENetHost *Client;
     ENetPeer *Server;
+    bool Send(const MessagePacket &packet);
+    void Queue(Content type, const flatbuffers::FlatBufferBuilder &builder);
     void Disconnect();
+
+    PacketPool Packets;
+    std::array<MessageBatch, NUM_CHANNELS> Batches;
 };
 
 class ENetServer
@@ -52,11 +196,66 @@ public:
     static std::shared_ptr<ENetServer> Create();
     ENetServer();
     ~ENetServer();
-    int Start(uint32_t port);
-    void Poll();
+    int Start(uint32_t port, uint32_t maxPlayers = SERVER_MAX_CONNECTIONS);
+
+    // waits up to timeout for the first event, then handles everything else that is already queued
+    void Poll(uint32_t timeout = 0);
+
+    // sends a packet of its own right away, ahead of anything queued
+    void Send(PlayerId playerId, const MessagePacket &packet);
+
+    // one packet shared by every listed player, ids that aren't connected are skipped
+    void Multicast(const std::vector<PlayerId> &players, const MessagePacket &packet);
+    void Broadcast(const MessagePacket &packet);
+
+    // queues a message finished with FinishMessage, everything queued for a player on a channel
+    // goes out as one packet on the next flush, in the order it was queued
+    void Queue(PlayerId playerId, Content type, const flatbuffers::FlatBufferBuilder &builder);
+    void Queue(const std::vector<PlayerId> &players, Content type, const flatbuffers::FlatBufferBuilder &builder);
+
+    // sends everything queued, then everything enet is holding
+    void Flush();
+
+    void Disconnect(PlayerId playerId);
+
+    bool IsConnected(PlayerId playerId) const { return GetPeer(playerId) != nullptr; }
+    const std::vector<PlayerId> &GetPlayers() const { return Connected; }
+    RoomId GetRequestedRoom(PlayerId playerId) const;
+    uint32_t GetMaxPlayers() const { return MaxPlayers; }
+
+    std::function<void(PlayerId)> OnConnect;
+    std::function<void(PlayerId)> OnDisconnect;
+    std::function<void(PlayerId, const Message *)> OnMessage;
+
+    // takes every received packet whole instead of OnMessage, for reading it on another thread
+    std::function<void(PlayerId, PacketPtr)> OnPacket;
 private:
     ENetHost *Server;
-    std::array<ENetPeer *, 2> Clients;
+    uint32_t MaxPlayers = 0;
+
+    // indexed by player id, so finding a player's peer is a single lookup
+    std::vector<ENetPeer *> Peers;
+
+    // every connected player once, in no particular order, for fanning packets out
+    std::vector<PlayerId> Connected;
+    std::vector<uint32_t> ConnectedIndex;
+
+    // ids that were given back, reused before new ones so the tables stay small
+    std::vector<PlayerId> FreeIds;
+    std::vector<bool> IdQueued;
+
+    // indexed by player id, the room each player asked for when they connected
+    std::vector<RoomId> RequestedRooms;
+
+    // indexed by player id, what is queued for each player until the next flush
+    PacketPool Packets;
+    std::vector<std::array<MessageBatch, NUM_CHANNELS>> Batches;
+
+    ENetPeer *GetPeer(PlayerId playerId) const;
+    PlayerId AddPeer(ENetPeer *peer, PlayerId requested);
+    void RemovePeer(PlayerId playerId);
+
+    void HandleEvent(ENetEvent &event);
     void Shutdown();
     bool IsServing();
 };
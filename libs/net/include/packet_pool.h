@@ -0,0 +1,104 @@
+#pragma once
+
+#include "enet/enet.h"
+#include "flatbuffers/flatbuffers.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace net
+{
+
+// every message in a packet starts on this boundary, so the ones after the first can be read in place too
+constexpr size_t MESSAGE_ALIGNMENT = 8;
+
+// builders that keep their buffers between messages, so building one doesn't allocate once they have grown
+class BuilderPool
+{
+public:
+    // a cleared builder that goes back to the pool when the lease ends
+    class Lease
+    {
+    public:
+        Lease(BuilderPool &pool, std::unique_ptr<flatbuffers::FlatBufferBuilder> builder);
+        Lease(Lease &&other) = default;
+        ~Lease();
+
+        flatbuffers::FlatBufferBuilder &operator*() const { return *Builder; }
+        flatbuffers::FlatBufferBuilder *operator->() const { return Builder.get(); }
+
+    private:
+        BuilderPool *Pool;
+        std::unique_ptr<flatbuffers::FlatBufferBuilder> Builder;
+    };
+
+    Lease Acquire();
+
+private:
+    std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> Free;
+};
+
+// the pool for the calling thread
+BuilderPool &GetBuilderPool();
+
+class PacketPool;
+
+struct PacketBuffer
+{
+    PacketPool *Owner = nullptr;
+    std::vector<uint8_t> Data;
+
+    // the next buffer handed back from another thread
+    PacketBuffer *NextReturned = nullptr;
+};
+
+// buffers that packets are sent from in place, enet hands each one back when it destroys the packet using it.
+// only one thread builds packets from a pool, but the packets may be sent and destroyed on another one
+class PacketPool
+{
+public:
+    // empty, with whatever capacity it had the last time it was used
+    PacketBuffer *Acquire();
+    void Release(PacketBuffer *buffer);
+
+    // Release for a thread that doesn't own the pool, the buffer is picked up by a later Acquire
+    void Return(PacketBuffer *buffer);
+
+    // a packet over the buffer's bytes that enet sends without copying them, nullptr and the buffer released if it fails
+    ENetPacket *CreatePacket(PacketBuffer *buffer, uint32_t flags);
+
+    size_t GetBufferCount() const { return Buffers.size(); }
+
+private:
+    static void OnPacketDestroyed(ENetPacket *packet);
+
+    // every buffer ever made, owned here so one still in flight when the pool goes is freed too
+    std::vector<std::unique_ptr<PacketBuffer>> Buffers;
+    std::vector<PacketBuffer *> Free;
+
+    // pushed by any thread, only ever taken whole by the owner, so popping can't race
+    std::atomic<PacketBuffer *> Returned{nullptr};
+};
+
+// the messages for one peer on one channel, size prefixed one after another so they leave as a single packet
+class MessageBatch
+{
+public:
+    // copies a message finished with FinishMessage
+    void Add(PacketPool &pool, const flatbuffers::FlatBufferBuilder &builder, uint32_t flags);
+    bool Empty() const { return Buffer == nullptr; }
+
+    // the queued messages as a packet sent from the batch's buffer, nullptr if nothing was queued
+    ENetPacket *TakePacket(PacketPool &pool);
+
+    // drops whatever was queued
+    void Clear(PacketPool &pool);
+
+private:
+    PacketBuffer *Buffer = nullptr;
+    uint32_t Flags = 0;
+};
+
+}
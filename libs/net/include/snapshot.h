@@ -0,0 +1,91 @@
+#pragma once
+
+#include "serialize_generated.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace net
+{
+
+// how many snapshots each side keeps to delta against, the client keeps more so that
+// every baseline the server may still use is always there when its state arrives
+constexpr uint32_t SERVER_SNAPSHOT_HISTORY = 32;
+
+constexpr uint32_t CLIENT_SNAPSHOT_HISTORY = 64;
+
+// positions travel as fractions of the map bounds, in 65535 steps
+uint16_t QuantizeCoordinate(float value, float origin, float size);
+float DequantizeCoordinate(uint16_t value, float origin, float size);
+
+// timers travel in hundredths of a second
+uint16_t QuantizeTime(float seconds);
+float DequantizeTime(uint16_t value);
+
+// one world state as a client sees it, each list sorted by id
+struct Snapshot
+{
+    uint32_t Tick = 0;
+
+    std::vector<Serialize::PlayerSnapshot> Players;
+    std::vector<Serialize::MobSnapshot> Mobs;
+    std::vector<Serialize::DropSnapshot> Drops;
+
+    // every player's backpack, one player after another in the order of Players
+    std::vector<Serialize::InventorySlot> Inventory;
+
+    // 1 for every opened chest
+    std::vector<uint8_t> Chests;
+
+    // the newest move of the receiving player this state includes
+    uint32_t MoveAck = 0;
+
+    void Clear();
+};
+
+// the last few snapshots, a new one replaces the one it shares a slot with
+class SnapshotHistory
+{
+public:
+    explicit SnapshotHistory(uint32_t size);
+
+    Snapshot &Add(uint32_t tick);
+
+    // nullptr if the tick was never added or has been replaced
+    const Snapshot *Find(uint32_t tick) const;
+
+    void Clear();
+
+private:
+    std::vector<Snapshot> Snapshots;
+};
+
+// writes a snapshot as what changed since the baseline, everything when there is none
+class SnapshotWriter
+{
+public:
+    flatbuffers::Offset<Serialize::WorldState> Write(flatbuffers::FlatBufferBuilder &builder,
+                                                     const Snapshot &current,
+                                                     const Snapshot *baseline);
+
+private:
+    void DiffInventory(const Snapshot &current, const Snapshot *baseline);
+    void DiffChests(const Snapshot &current, const Snapshot *baseline);
+
+    // reused every write so it doesn't allocate once they have grown
+    std::vector<Serialize::PlayerSnapshot> Players;
+    std::vector<Serialize::MobSnapshot> Mobs;
+    std::vector<Serialize::DropSnapshot> Drops;
+    std::vector<uint16_t> RemovedPlayers;
+    std::vector<uint32_t> RemovedMobs;
+    std::vector<uint32_t> RemovedDrops;
+    std::vector<uint16_t> InventoryPlayers;
+    std::vector<Serialize::InventorySlot> Inventory;
+    std::vector<uint16_t> Chests;
+};
+
+// rebuilds the whole snapshot from a state and the baseline it was written against
+// false if the state needs a baseline and none was given
+bool ReadSnapshot(const Serialize::WorldState *state, const Snapshot *baseline, Snapshot &result);
+
+}
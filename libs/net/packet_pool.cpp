@@ -0,0 +1,131 @@
+#include "packet_pool.h"
+
+namespace net
+{
+
+BuilderPool::Lease::Lease(BuilderPool &pool, std::unique_ptr<flatbuffers::FlatBufferBuilder> builder)
+    : Pool(&pool), Builder(std::move(builder))
+{
+}
+
+BuilderPool::Lease::~Lease()
+{
+    // a moved from lease has nothing to give back
+    if (Builder == nullptr)
+        return;
+
+    // Clear keeps the buffer, Reset would free it
+    Builder->Clear();
+    Pool->Free.push_back(std::move(Builder));
+}
+
+BuilderPool::Lease BuilderPool::Acquire()
+{
+    if (Free.empty())
+        return Lease(*this, std::make_unique<flatbuffers::FlatBufferBuilder>(1024));
+
+    std::unique_ptr<flatbuffers::FlatBufferBuilder> builder = std::move(Free.back());
+    Free.pop_back();
+    return Lease(*this, std::move(builder));
+}
+
+BuilderPool &GetBuilderPool()
+{
+    thread_local BuilderPool pool;
+    return pool;
+}
+
+PacketBuffer *PacketPool::Acquire()
+{
+    if (Free.empty()) {
+        PacketBuffer *returned = Returned.exchange(nullptr, std::memory_order_acquire);
+        for (; returned != nullptr; returned = returned->NextReturned) {
+            returned->Data.clear();
+            Free.push_back(returned);
+        }
+    }
+
+    if (Free.empty()) {
+        Buffers.push_back(std::make_unique<PacketBuffer>());
+        Buffers.back()->Owner = this;
+        return Buffers.back().get();
+    }
+
+    PacketBuffer *buffer = Free.back();
+    Free.pop_back();
+    return buffer;
+}
+
+void PacketPool::Release(PacketBuffer *buffer)
+{
+    buffer->Data.clear();
+    Free.push_back(buffer);
+}
+
+void PacketPool::Return(PacketBuffer *buffer)
+{
+    PacketBuffer *head = Returned.load(std::memory_order_relaxed);
+    do {
+        buffer->NextReturned = head;
+    } while (!Returned.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+}
+
+ENetPacket *PacketPool::CreatePacket(PacketBuffer *buffer, uint32_t flags)
+{
+    ENetPacket *packet = enet_packet_create(buffer->Data.data(),
+                                            buffer->Data.size(),
+                                            flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (packet == nullptr) {
+        Release(buffer);
+        return nullptr;
+    }
+
+    // the data must stay put until enet is done with it, reliable packets live until the peer acknowledges them
+    packet->userData = buffer;
+    packet->freeCallback = &PacketPool::OnPacketDestroyed;
+    return packet;
+}
+
+void PacketPool::OnPacketDestroyed(ENetPacket *packet)
+{
+    // enet may destroy the packet on whichever thread sent it
+    auto *buffer = static_cast<PacketBuffer *>(packet->userData);
+    buffer->Owner->Return(buffer);
+}
+
+void MessageBatch::Add(PacketPool &pool, const flatbuffers::FlatBufferBuilder &builder, uint32_t flags)
+{
+    if (Buffer == nullptr)
+        Buffer = pool.Acquire();
+
+    std::vector<uint8_t> &data = Buffer->Data;
+    data.insert(data.end(), builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+
+    // pad so the next message starts aligned
+    data.resize((data.size() + MESSAGE_ALIGNMENT - 1) / MESSAGE_ALIGNMENT * MESSAGE_ALIGNMENT, 0);
+
+    // a channel only carries one kind of delivery, so this is the same for every message
+    Flags |= flags;
+}
+
+ENetPacket *MessageBatch::TakePacket(PacketPool &pool)
+{
+    if (Buffer == nullptr)
+        return nullptr;
+
+    ENetPacket *packet = pool.CreatePacket(Buffer, Flags);
+    Buffer = nullptr;
+    Flags = 0;
+    return packet;
+}
+
+void MessageBatch::Clear(PacketPool &pool)
+{
+    if (Buffer != nullptr)
+        pool.Release(Buffer);
+
+    Buffer = nullptr;
+    Flags = 0;
+}
+
+}
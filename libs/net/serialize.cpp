@@ -1,22 +1,110 @@
 #include "net.h"
 #include "serialize_generated.h"
 
+#include <algorithm>
+
 using namespace Serialize;
 
 namespace net
 {
 
-ENetPacket *SerializePosition(uint8_t user, float x, float y)
+Delivery GetDelivery(Content type)
 {
-    flatbuffers::FlatBufferBuilder builder(1024);
+    switch (type) {
+        // moves, world states and acks are all repeated or replaced by the next one. a batch or a full state can be
+        // bigger than the mtu, enet would send its fragments reliably unless told otherwise
+        case Content_Move:
+        case Content_WorldState:
+        case Content_Ack: return Delivery{UNRELIABLE_CHANNEL, ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT};
+
+        // welcomes, item actions, world events and interest changes must each arrive once and in order
+        default: return Delivery{RELIABLE_CHANNEL, ENET_PACKET_FLAG_RELIABLE};
+    }
+}
 
-    auto pos = builder.CreateStruct(Position{x, y});
-    auto orc = CreateMessage(builder, user, Content_Position, pos.Union());
-    builder.Finish(orc);
+void FinishMessage(flatbuffers::FlatBufferBuilder &builder, PlayerId user, Content type, flatbuffers::Offset<void> content)
+{
+    builder.FinishSizePrefixed(CreateMessage(builder, user, type, content));
+}
+
+MessagePacket CreateMessagePacket(flatbuffers::FlatBufferBuilder &builder,
+                                  PlayerId user,
+                                  Content type,
+                                  flatbuffers::Offset<void> content)
+{
+    FinishMessage(builder, user, type, content);
+
+    Delivery delivery = GetDelivery(type);
+    ENetPacket *packet = enet_packet_create(builder.GetBufferPointer(), builder.GetSize(), delivery.Flags);
+    return MessagePacket{packet, delivery.Channel};
+}
+
+Content SerializeMove(flatbuffers::FlatBufferBuilder &builder, PlayerId user, const MoveStep *steps, size_t count)
+{
+    if (count == 0)
+        return Content_NONE;
+
+    auto content = CreateMove(builder, builder.CreateVectorOfStructs(steps, count));
+    FinishMessage(builder, user, Content_Move, content.Union());
+    return Content_Move;
+}
+
+Content SerializeInput(flatbuffers::FlatBufferBuilder &builder, PlayerId user, const InputCommand &input)
+{
+    if (input.ActivateSlot < 0 && input.DropSlot < 0)
+        return Content_NONE;
+
+    auto content = CreateInput(builder, input.Sequence, input.ActivateSlot, input.DropSlot);
+    FinishMessage(builder, user, Content_Input, content.Union());
+    return Content_Input;
+}
+
+MessagePacket SerializeWelcome(PlayerId user)
+{
+    BuilderPool::Lease builder = GetBuilderPool().Acquire();
+    auto content = CreateWelcome(*builder, user);
+
+    return CreateMessagePacket(*builder, 0, Content_Welcome, content.Union());
+}
+
+Content SerializeAck(flatbuffers::FlatBufferBuilder &builder, PlayerId user, uint32_t tick)
+{
+    auto content = CreateAck(builder, tick);
+    FinishMessage(builder, user, Content_Ack, content.Union());
+    return Content_Ack;
+}
+
+const Message *ReadMessage(const ENetPacket *packet, size_t &offset)
+{
+    if (packet == nullptr || packet->data == nullptr || offset >= packet->dataLength)
+        return nullptr;
+
+    size_t left = packet->dataLength - offset;
+    if (left < sizeof(flatbuffers::uoffset_t))
+        return nullptr;
+
+    const uint8_t *data = packet->data + offset;
+    size_t size = sizeof(flatbuffers::uoffset_t) + flatbuffers::GetPrefixedSize(data);
+    if (size > left)
+        return nullptr;
+
+    // everything off the wire is checked before it is read, a bad packet must not crash the reader
+    flatbuffers::Verifier verifier(data, size);
+    if (!VerifySizePrefixedMessageBuffer(verifier))
+        return nullptr;
+
+    // every message is padded out to the alignment, so the next one starts where the padding ends
+    offset += std::min(left, (size + MESSAGE_ALIGNMENT - 1) / MESSAGE_ALIGNMENT * MESSAGE_ALIGNMENT);
+    return GetSizePrefixedMessage(data);
+}
+
+bool MessageDispatcher::Dispatch(const Message *message) const
+{
+    Content type = message->content_type();
+    if (type > Content_MAX || !Handlers[type])
+        return false;
 
-    return enet_packet_create(
-        builder.GetBufferPointer(),
-        builder.GetSize(),
-        ENET_PACKET_FLAG_RELIABLE);
+    Handlers[type](message);
+    return true;
 }
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "snapshot.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace Serialize;
+
+namespace net
+{
+
+namespace
+{
+
+// snapshots are plain wire structs without padding, equal bytes mean nothing changed
+template<typename T>
+bool SameState(const T &a, const T &b)
+{
+    return memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// both lists are sorted by id, so a single pass finds what is new, what changed and what went away
+template<typename T, typename Id>
+void DiffEntities(const std::vector<T> &current,
+                  const std::vector<T> *baseline,
+                  std::vector<T> &changed,
+                  std::vector<Id> &removed)
+{
+    changed.clear();
+    removed.clear();
+
+    if (baseline == nullptr) {
+        changed.assign(current.begin(), current.end());
+        return;
+    }
+
+    size_t base = 0;
+    for (const T &entity : current) {
+        while (base < baseline->size() && (*baseline)[base].id() < entity.id())
+            removed.push_back(Id((*baseline)[base++].id()));
+
+        if (base < baseline->size() && (*baseline)[base].id() == entity.id()) {
+            if (!SameState((*baseline)[base], entity))
+                changed.push_back(entity);
+            base++;
+        }
+        else {
+            changed.push_back(entity);
+        }
+    }
+
+    while (base < baseline->size())
+        removed.push_back(Id((*baseline)[base++].id()));
+}
+
+template<typename T, typename Id>
+void PatchEntities(const std::vector<T> *baseline,
+                   const flatbuffers::Vector<const T *> *changed,
+                   const flatbuffers::Vector<Id> *removed,
+                   std::vector<T> &result)
+{
+    result.clear();
+
+    size_t baseCount = baseline != nullptr ? baseline->size() : 0;
+    size_t changedCount = changed != nullptr ? changed->size() : 0;
+    size_t removedCount = removed != nullptr ? removed->size() : 0;
+
+    size_t base = 0;
+    size_t change = 0;
+    size_t remove = 0;
+    while (base < baseCount || change < changedCount) {
+        if (base == baseCount
+            || (change < changedCount && changed->Get(change)->id() <= (*baseline)[base].id())) {
+            // a changed entity replaces the baseline one with the same id
+            if (base < baseCount && changed->Get(change)->id() == (*baseline)[base].id())
+                base++;
+
+            result.push_back(*changed->Get(change++));
+            continue;
+        }
+
+        const T &entity = (*baseline)[base++];
+        while (remove < removedCount && removed->Get(remove) < entity.id())
+            remove++;
+
+        if (remove < removedCount && removed->Get(remove) == entity.id())
+            continue;
+
+        result.push_back(entity);
+    }
+}
+
+// the slots of one player's backpack, players are few and backpacks short so a scan is fine
+void FindInventory(const Snapshot &snapshot, uint32_t playerId, size_t &begin, size_t &end)
+{
+    begin = 0;
+    while (begin < snapshot.Inventory.size() && snapshot.Inventory[begin].player_id() != playerId)
+        begin++;
+
+    end = begin;
+    while (end < snapshot.Inventory.size() && snapshot.Inventory[end].player_id() == playerId)
+        end++;
+}
+
+}
+
+uint16_t QuantizeCoordinate(float value, float origin, float size)
+{
+    if (size <= 0)
+        return 0;
+
+    float fraction = std::clamp((value - origin) / size, 0.0f, 1.0f);
+    return uint16_t(lroundf(fraction * 65535));
+}
+
+float DequantizeCoordinate(uint16_t value, float origin, float size)
+{
+    return origin + (value / 65535.0f) * size;
+}
+
+uint16_t QuantizeTime(float seconds)
+{
+    return uint16_t(std::clamp(lroundf(seconds * 100), 0L, 65535L));
+}
+
+float DequantizeTime(uint16_t value)
+{
+    return value / 100.0f;
+}
+
+void Snapshot::Clear()
+{
+    Tick = 0;
+    Players.clear();
+    Mobs.clear();
+    Drops.clear();
+    Inventory.clear();
+    Chests.clear();
+    MoveAck = 0;
+}
+
+SnapshotHistory::SnapshotHistory(uint32_t size)
+    : Snapshots(std::max<uint32_t>(size, 1))
+{
+}
+
+Snapshot &SnapshotHistory::Add(uint32_t tick)
+{
+    // the vectors keep their capacity, so a full history stops allocating
+    Snapshot &snapshot = Snapshots[tick % Snapshots.size()];
+    snapshot.Clear();
+    snapshot.Tick = tick;
+    return snapshot;
+}
+
+const Snapshot *SnapshotHistory::Find(uint32_t tick) const
+{
+    if (tick == 0)
+        return nullptr;
+
+    const Snapshot &snapshot = Snapshots[tick % Snapshots.size()];
+    return snapshot.Tick == tick ? &snapshot : nullptr;
+}
+
+void SnapshotHistory::Clear()
+{
+    for (Snapshot &snapshot : Snapshots)
+        snapshot.Clear();
+}
+
+flatbuffers::Offset<WorldState> SnapshotWriter::Write(flatbuffers::FlatBufferBuilder &builder,
+                                                      const Snapshot &current,
+                                                      const Snapshot *baseline)
+{
+    DiffEntities(current.Players, baseline ? &baseline->Players : nullptr, Players, RemovedPlayers);
+    DiffEntities(current.Mobs, baseline ? &baseline->Mobs : nullptr, Mobs, RemovedMobs);
+    DiffEntities(current.Drops, baseline ? &baseline->Drops : nullptr, Drops, RemovedDrops);
+    DiffInventory(current, baseline);
+    DiffChests(current, baseline);
+
+    // empty lists are left out, most ticks most of them are
+    auto players = Players.empty() ? 0 : builder.CreateVectorOfStructs(Players);
+    auto mobs = Mobs.empty() ? 0 : builder.CreateVectorOfStructs(Mobs);
+    auto drops = Drops.empty() ? 0 : builder.CreateVectorOfStructs(Drops);
+    auto removedPlayers = RemovedPlayers.empty() ? 0 : builder.CreateVector(RemovedPlayers);
+    auto removedMobs = RemovedMobs.empty() ? 0 : builder.CreateVector(RemovedMobs);
+    auto removedDrops = RemovedDrops.empty() ? 0 : builder.CreateVector(RemovedDrops);
+    auto inventoryPlayers = InventoryPlayers.empty() ? 0 : builder.CreateVector(InventoryPlayers);
+    auto inventory = Inventory.empty() ? 0 : builder.CreateVectorOfStructs(Inventory);
+    auto chests = Chests.empty() ? 0 : builder.CreateVector(Chests);
+
+    return CreateWorldState(builder,
+                            current.Tick,
+                            baseline ? baseline->Tick : 0,
+                            players,
+                            mobs,
+                            drops,
+                            removedPlayers,
+                            removedMobs,
+                            removedDrops,
+                            inventoryPlayers,
+                            inventory,
+                            chests,
+                            current.MoveAck);
+}
+
+void SnapshotWriter::DiffInventory(const Snapshot &current, const Snapshot *baseline)
+{
+    InventoryPlayers.clear();
+    Inventory.clear();
+
+    for (const PlayerSnapshot &player : current.Players) {
+        size_t begin, end;
+        FindInventory(current, player.id(), begin, end);
+
+        if (baseline != nullptr) {
+            size_t baseBegin, baseEnd;
+            FindInventory(*baseline, player.id(), baseBegin, baseEnd);
+
+            bool same = end - begin == baseEnd - baseBegin
+                && std::equal(current.Inventory.begin() + begin,
+                              current.Inventory.begin() + end,
+                              baseline->Inventory.begin() + baseBegin,
+                              SameState<InventorySlot>);
+            if (same)
+                continue;
+        }
+
+        InventoryPlayers.push_back(player.id());
+        Inventory.insert(Inventory.end(), current.Inventory.begin() + begin, current.Inventory.begin() + end);
+    }
+}
+
+void SnapshotWriter::DiffChests(const Snapshot &current, const Snapshot *baseline)
+{
+    Chests.clear();
+
+    for (size_t i = 0; i < current.Chests.size(); i++) {
+        uint8_t before = baseline != nullptr && i < baseline->Chests.size() ? baseline->Chests[i] : 0;
+        if (current.Chests[i] != before)
+            Chests.push_back(uint16_t(i));
+    }
+}
+
+bool ReadSnapshot(const WorldState *state, const Snapshot *baseline, Snapshot &result)
+{
+    if (state->baseline() != 0 && (baseline == nullptr || baseline->Tick != state->baseline()))
+        return false;
+
+    if (state->baseline() == 0)
+        baseline = nullptr;
+
+    result.Tick = state->tick();
+    result.MoveAck = state->move_ack();
+    PatchEntities(baseline ? &baseline->Players : nullptr, state->players(), state->removed_players(), result.Players);
+    PatchEntities(baseline ? &baseline->Mobs : nullptr, state->mobs(), state->removed_mobs(), result.Mobs);
+    PatchEntities(baseline ? &baseline->Drops : nullptr, state->drops(), state->removed_drops(), result.Drops);
+
+    // a player's backpack is either sent whole or the same as in the baseline
+    result.Inventory.clear();
+    for (const PlayerSnapshot &player : result.Players) {
+        const auto *sent = state->inventory_players();
+        bool resent = sent != nullptr && std::find(sent->begin(), sent->end(), player.id()) != sent->end();
+
+        if (resent) {
+            if (state->inventory() == nullptr)
+                continue;
+
+            for (const InventorySlot *slot : *state->inventory()) {
+                if (slot->player_id() == player.id())
+                    result.Inventory.push_back(*slot);
+            }
+        }
+        else if (baseline != nullptr) {
+            size_t begin, end;
+            FindInventory(*baseline, player.id(), begin, end);
+            result.Inventory.insert(result.Inventory.end(),
+                                    baseline->Inventory.begin() + begin,
+                                    baseline->Inventory.begin() + end);
+        }
+    }
+
+    result.Chests.clear();
+    if (baseline != nullptr)
+        result.Chests = baseline->Chests;
+
+    if (state->chests() != nullptr) {
+        for (uint16_t chest : *state->chests()) {
+            if (chest >= result.Chests.size())
+                result.Chests.resize(chest + 1, 0);
+            result.Chests[chest] ^= 1;
+        }
+    }
+
+    return true;
+}
+
+}
@@ -25,11 +25,9 @@
 
 #include "combat.h"
 
-#include "raylib.h"
-
-int ResolveAttack(const AttackInfo& attack, int defense)
+int ResolveAttack(const AttackInfo& attack, int defense, sim::Random& random)
 {
-	int damage = GetRandomValue(-3, 6) + GetRandomValue(attack.MinDamage, attack.MaxDamage);
+	int damage = random.Range(-3, 6) + random.Range(attack.MinDamage, attack.MaxDamage);
 	int total = damage - defense;
 
 	if (total < 0)
@@ -0,0 +1,225 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "flow_field.h"
+
+#include "sim_math.h"
+
+#include <math.h>
+#include <algorithm>
+#include <utility>
+
+namespace sim
+{
+
+// straight and diagonal step costs, roughly 1 and sqrt(2)
+constexpr uint32_t StraightCost = 10;
+constexpr uint32_t DiagonalCost = 14;
+
+void NavGrid::Build(const Rect &bounds, float cellSize, const std::function<bool(const Vec2 &)> &isWalkable)
+{
+    Bounds = bounds;
+    CellSize = cellSize > 0 ? cellSize : 1;
+    CellsX = std::max(1, int(ceilf(bounds.width / CellSize)));
+    CellsY = std::max(1, int(ceilf(bounds.height / CellSize)));
+    Version++;
+
+    // a cell is walkable when its center is, mobs are points as far as the map is concerned
+    Walkable.assign(size_t(CellsX) * CellsY, 0);
+    for (int y = 0; y < CellsY; y++) {
+        for (int x = 0; x < CellsX; x++)
+            Walkable[size_t(y) * CellsX + x] = isWalkable(GetCellCenter(x, y)) ? 1 : 0;
+    }
+}
+
+void NavGrid::Clear()
+{
+    Bounds = Rect{0, 0, 0, 0};
+    CellsX = CellsY = 0;
+    Walkable.clear();
+    Version++;
+}
+
+bool NavGrid::IsWalkable(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= CellsX || y >= CellsY)
+        return false;
+
+    return Walkable[size_t(y) * CellsX + x] != 0;
+}
+
+int NavGrid::GetCellX(float x) const
+{
+    return std::clamp(int(floorf((x - Bounds.x) / CellSize)), 0, CellsX - 1);
+}
+
+int NavGrid::GetCellY(float y) const
+{
+    return std::clamp(int(floorf((y - Bounds.y) / CellSize)), 0, CellsY - 1);
+}
+
+Vec2 NavGrid::GetCellCenter(int x, int y) const
+{
+    return Vec2{Bounds.x + (x + 0.5f) * CellSize, Bounds.y + (y + 0.5f) * CellSize};
+}
+
+void FlowField::Reset()
+{
+    Grid = nullptr;
+    TargetCell = -1;
+    Distance.clear();
+    NextCell.clear();
+}
+
+bool FlowField::Update(const NavGrid &grid, const Vec2 &target)
+{
+    int cellsX = grid.GetCellsX();
+    int cellsY = grid.GetCellsY();
+    if (cellsX == 0 || cellsY == 0) {
+        Reset();
+        return false;
+    }
+
+    Target = target;
+
+    int targetX = grid.GetCellX(target.x);
+    int targetY = grid.GetCellY(target.y);
+    int targetCell = targetY * cellsX + targetX;
+
+    if (Grid == &grid && GridVersion == grid.GetVersion() && TargetCell == targetCell)
+        return false;
+
+    Grid = &grid;
+    GridVersion = grid.GetVersion();
+    TargetCell = targetCell;
+
+    size_t cellCount = size_t(cellsX) * cellsY;
+    Distance.assign(cellCount, Unreachable);
+    NextCell.assign(cellCount, -1);
+
+    // dijkstra out from the target, each cell remembers the neighbor it was reached from,
+    // which is the next step on the shortest path back to the target
+    using OpenCell = std::pair<uint32_t, int>;
+    std::vector<OpenCell> open;
+    auto closer = [](const OpenCell &a, const OpenCell &b) { return a.first > b.first; };
+
+    Distance[targetCell] = 0;
+    open.emplace_back(0, targetCell);
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), closer);
+        OpenCell current = open.back();
+        open.pop_back();
+
+        if (current.first != Distance[current.second])
+            continue;
+
+        int x = current.second % cellsX;
+        int y = current.second / cellsX;
+
+        for (int offsetY = -1; offsetY <= 1; offsetY++) {
+            for (int offsetX = -1; offsetX <= 1; offsetX++) {
+                if (offsetX == 0 && offsetY == 0)
+                    continue;
+
+                int neighborX = x + offsetX;
+                int neighborY = y + offsetY;
+                if (!grid.IsWalkable(neighborX, neighborY))
+                    continue;
+
+                bool diagonal = offsetX != 0 && offsetY != 0;
+
+                // don't cut corners, both cells beside a diagonal step have to be open
+                if (diagonal && (!grid.IsWalkable(x + offsetX, y) || !grid.IsWalkable(x, y + offsetY)))
+                    continue;
+
+                uint32_t distance = current.first + (diagonal ? DiagonalCost : StraightCost);
+                int neighbor = neighborY * cellsX + neighborX;
+                if (distance >= Distance[neighbor])
+                    continue;
+
+                Distance[neighbor] = distance;
+                NextCell[neighbor] = current.second;
+                open.emplace_back(distance, neighbor);
+                std::push_heap(open.begin(), open.end(), closer);
+            }
+        }
+    }
+
+    return true;
+}
+
+int FlowField::GetBestNeighbor(int x, int y) const
+{
+    int cellsX = Grid->GetCellsX();
+    int cellsY = Grid->GetCellsY();
+
+    int best = -1;
+    uint32_t bestDistance = Unreachable;
+    for (int offsetY = -1; offsetY <= 1; offsetY++) {
+        for (int offsetX = -1; offsetX <= 1; offsetX++) {
+            int neighborX = x + offsetX;
+            int neighborY = y + offsetY;
+            if (neighborX < 0 || neighborY < 0 || neighborX >= cellsX || neighborY >= cellsY)
+                continue;
+
+            int neighbor = neighborY * cellsX + neighborX;
+            if (Distance[neighbor] < bestDistance) {
+                bestDistance = Distance[neighbor];
+                best = neighbor;
+            }
+        }
+    }
+
+    return best;
+}
+
+bool FlowField::GetDirection(const Vec2 &position, Vec2 &direction) const
+{
+    if (Grid == nullptr || TargetCell < 0 || GridVersion != Grid->GetVersion())
+        return false;
+
+    int x = Grid->GetCellX(position.x);
+    int y = Grid->GetCellY(position.y);
+    int cell = y * Grid->GetCellsX() + x;
+
+    int next = cell == TargetCell ? TargetCell : NextCell[cell];
+
+    // walkers can end up in cells whose center is blocked, step back onto the field from there
+    if (next < 0)
+        next = GetBestNeighbor(x, y);
+
+    if (next < 0)
+        return false;
+
+    Vec2 goal = Target;
+    if (next != TargetCell)
+        goal = Grid->GetCellCenter(next % Grid->GetCellsX(), next / Grid->GetCellsX());
+
+    direction = Normalize(Subtract(goal, position));
+    return true;
+}
+
+}
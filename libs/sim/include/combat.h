@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include "random.h"
+
 #include <string>
 
 struct DefenseInfo
@@ -46,4 +48,4 @@ struct AttackInfo
 	float Range = 10;
 };
 
-int ResolveAttack(const AttackInfo& attack, int defense);
\ No newline at end of file
+int ResolveAttack(const AttackInfo& attack, int defense, sim::Random& random);
\ No newline at end of file
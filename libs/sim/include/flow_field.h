@@ -0,0 +1,93 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "sim_math.h"
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+namespace sim
+{
+
+// tile sized cells marking where mobs can walk, built from the map collision at load time
+class NavGrid
+{
+public:
+    void Build(const Rect &bounds, float cellSize, const std::function<bool(const Vec2 &)> &isWalkable);
+    void Clear();
+
+    bool IsWalkable(int x, int y) const;
+
+    int GetCellX(float x) const;
+    int GetCellY(float y) const;
+    Vec2 GetCellCenter(int x, int y) const;
+
+    int GetCellsX() const { return CellsX; }
+    int GetCellsY() const { return CellsY; }
+
+    // bumped on every build so flow fields know to start over
+    uint32_t GetVersion() const { return Version; }
+
+private:
+    Rect Bounds = {0, 0, 0, 0};
+    float CellSize = 1;
+    int CellsX = 0;
+    int CellsY = 0;
+    uint32_t Version = 0;
+
+    std::vector<uint8_t> Walkable;
+};
+
+// distance field from every nav cell to a single target, shared by all the mobs chasing it
+// the field is only rebuilt when the target moves into a different cell
+class FlowField
+{
+public:
+    // returns true if the field was rebuilt
+    bool Update(const NavGrid &grid, const Vec2 &target);
+    void Reset();
+
+    // direction a walker at position should move to get closer to the target
+    // returns false if the target can't be reached from there
+    bool GetDirection(const Vec2 &position, Vec2 &direction) const;
+
+    static constexpr uint32_t Unreachable = UINT32_MAX;
+
+private:
+    int GetBestNeighbor(int x, int y) const;
+
+    const NavGrid *Grid = nullptr;
+    uint32_t GridVersion = 0;
+    int TargetCell = -1;
+    Vec2 Target = {0, 0};
+
+    std::vector<uint32_t> Distance;
+    std::vector<int> NextCell;
+};
+
+}
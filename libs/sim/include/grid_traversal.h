@@ -0,0 +1,92 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "sim_math.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace sim
+{
+
+// visits the cells of a uniform grid under a segment in order (Amanatides & Woo)
+// the visitor returns true to stop the walk early, and the result is true if it did
+template<typename Visitor>
+bool WalkGridCells(const Vec2 &startPoint, const Vec2 &endPoint, const Vec2 &origin, float cellSize,
+                   int cellsX, int cellsY, Visitor visitor)
+{
+    if (cellsX <= 0 || cellsY <= 0)
+        return false;
+
+    float startX = (startPoint.x - origin.x) / cellSize;
+    float startY = (startPoint.y - origin.y) / cellSize;
+    float deltaX = (endPoint.x - startPoint.x) / cellSize;
+    float deltaY = (endPoint.y - startPoint.y) / cellSize;
+
+    int cellX = std::clamp(int(floorf(startX)), 0, cellsX - 1);
+    int cellY = std::clamp(int(floorf(startY)), 0, cellsY - 1);
+    int endCellX = std::clamp(int(floorf(startX + deltaX)), 0, cellsX - 1);
+    int endCellY = std::clamp(int(floorf(startY + deltaY)), 0, cellsY - 1);
+
+    int stepX = endCellX > cellX ? 1 : -1;
+    int stepY = endCellY > cellY ? 1 : -1;
+
+    float tDeltaX = deltaX != 0 ? fabsf(1.0f / deltaX) : INFINITY;
+    float tDeltaY = deltaY != 0 ? fabsf(1.0f / deltaY) : INFINITY;
+
+    float tMaxX = INFINITY;
+    if (deltaX > 0)
+        tMaxX = (floorf(startX) + 1 - startX) * tDeltaX;
+    else if (deltaX < 0)
+        tMaxX = (startX - floorf(startX)) * tDeltaX;
+
+    float tMaxY = INFINITY;
+    if (deltaY > 0)
+        tMaxY = (floorf(startY) + 1 - startY) * tDeltaY;
+    else if (deltaY < 0)
+        tMaxY = (startY - floorf(startY)) * tDeltaY;
+
+    // the step count is fixed up front so rounding can never walk past the end cell
+    int steps = abs(endCellX - cellX) + abs(endCellY - cellY);
+    for (int i = 0; i <= steps; i++) {
+        if (visitor(cellX, cellY))
+            return true;
+
+        if (cellX != endCellX && (cellY == endCellY || tMaxX < tMaxY)) {
+            cellX += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cellY += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+
+    return false;
+}
+
+}
@@ -70,7 +70,7 @@ public:
 Item* AddItem(const char* name, int sprite, ItemTypes type);
 Item* GetItem(int id);
 
-int GetRandomItem(int except = -1);
+int GetRandomItem(sim::Random& random, int except = -1);
 
 void SetupDefaultItems();
 
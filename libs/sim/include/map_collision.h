@@ -0,0 +1,62 @@
+#pragma once
+
+#include "sim_math.h"
+#include "map_data.h"
+#include "wall_grid.h"
+#include "occupancy_grid.h"
+#include "flow_field.h"
+
+#include <memory>
+#include <string>
+
+namespace sim
+{
+
+enum class CollisionMode
+{
+    Geometry,   // test every query against the wall rectangles
+    Bitmap,     // answer from the occupancy bitmap, only partly covered cells test the walls
+};
+
+// everything that answers where things can walk and see on a map, built once when the map loads
+class MapCollision
+{
+public:
+    void Build(const MapData &map, CollisionMode mode = CollisionMode::Bitmap);
+    void Clear();
+
+    void SetMode(CollisionMode mode) { Mode = mode; }
+    CollisionMode GetMode() const { return Mode; }
+
+    bool PointInMap(const Vec2 &point) const;
+    bool RayHitsMap(const Vec2 &startPoint, const Vec2 &endPoint) const;
+
+    const Rect &GetBounds() const { return Bounds; }
+    const WallGrid &GetWalls() const { return Walls; }
+    const OccupancyGrid &GetOccupancy() const { return Occupancy; }
+    const NavGrid &GetNavGrid() const { return Nav; }
+
+private:
+    Rect Bounds;
+    CollisionMode Mode = CollisionMode::Bitmap;
+
+    WallGrid Walls;
+    OccupancyGrid Occupancy;
+    NavGrid Nav;
+};
+
+// a map and its collision, nothing changes it once it is built
+class Level
+{
+public:
+    std::string Path;
+    MapData Map;
+    MapCollision Collision;
+};
+
+std::shared_ptr<Level> CreateLevel(const std::string &path, MapData &&map, CollisionMode mode = CollisionMode::Bitmap);
+
+// reads the map objects straight from a .tmx, nullptr if it can't be read
+std::shared_ptr<Level> LoadLevel(const char *filePath, CollisionMode mode = CollisionMode::Bitmap);
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "sim_math.h"
+
+#include <string>
+#include <vector>
+
+namespace sim
+{
+
+// common object types
+constexpr char PlayerSpawnType[] = "player_spawn";
+constexpr char MobSpawnType[] = "mob_spawn";
+constexpr char ChestType[] = "chest";
+constexpr char ExitType[] = "exit";
+constexpr char WallType[] = "wall";
+
+struct MapProperty
+{
+    std::string Name;
+    std::string Value;
+};
+
+struct MapObject
+{
+    int Id = 0;
+    std::string Name;
+    std::string Type;
+    Rect Bounds;
+    std::vector<MapProperty> Properties;
+
+    // nullptr if the object doesn't have the property
+    const std::string *GetProperty(const char *name) const;
+};
+
+// the parts of a tile map the simulation cares about, the objects and how big it is
+// the server reads this straight from the .tmx, the client fills it from the map it already loaded to draw
+class MapData
+{
+public:
+    Rect Bounds;
+    float TileSize = 32;
+    std::vector<MapObject> Objects;
+
+    std::vector<const MapObject *> GetObjectsOfType(const char *type) const;
+    const MapObject *GetFirstObjectOfType(const char *type) const;
+    std::vector<Rect> GetWalls() const;
+};
+
+bool LoadMapData(const char *filePath, MapData &map);
+
+}
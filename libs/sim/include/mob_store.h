@@ -0,0 +1,89 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "sim_math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class MOB;
+
+namespace sim
+{
+
+// mob instances are referred to by id, indexes move around as mobs die
+using MobInstanceId = uint32_t;
+constexpr MobInstanceId NoMob = 0;
+
+// live mobs stored as parallel arrays so the per frame passes stream through
+// only the fields they touch, removal swaps the last mob into the hole
+class MobStore
+{
+public:
+    // the store picks the id unless one is given, copies of another world's mobs keep that world's ids
+    MobInstanceId Add(const MOB &monster, const Vec2 &position, MobInstanceId id = NoMob);
+    void RemoveAt(size_t index);
+    void Clear();
+
+    size_t Size() const { return InstanceIds.size(); }
+    bool Empty() const { return InstanceIds.empty(); }
+
+    // -1 if the mob is gone
+    int FindIndex(MobInstanceId id) const;
+
+    // first mob within radius of the point, -1 if there isn't one
+    int FindNear(const Vec2 &point, float radius) const;
+
+    Vec2 GetPosition(size_t index) const { return Vec2{PositionX[index], PositionY[index]}; }
+    void SetPosition(size_t index, const Vec2 &position);
+
+    std::vector<MobInstanceId> InstanceIds;
+    std::vector<int> MobIds;
+    std::vector<float> PositionX;
+    std::vector<float> PositionY;
+    std::vector<int> Health;
+    std::vector<uint8_t> Triggered;
+    std::vector<float> LastAttack;
+
+    // copied out of the mob database when spawned, so the update never has to look them up
+    std::vector<float> Speed;
+    std::vector<float> DetectionRadiusSq;
+    std::vector<float> AttackRangeSq;
+
+    // filled in by the update each tick, the index of the player each mob is after and how far away it is
+    std::vector<uint16_t> TargetPlayer;
+    std::vector<float> TargetDistanceSq;
+
+private:
+    MobInstanceId NextInstanceId = 1;
+
+    // instance id to index, NoMob slots are unused
+    std::vector<int> IndexOfInstance;
+};
+
+}
@@ -25,11 +25,8 @@
 
 #pragma once
 
-#include "sprites.h"
 #include "combat.h"
 
-#include "raylib.h"
-
 #include <string>
 
 class MOB
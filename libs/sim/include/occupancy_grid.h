@@ -0,0 +1,76 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "sim_math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace sim
+{
+
+// bitmap of which cells of the map are blocked by walls, rasterized once at load time
+// walls block both movement and sight, so the same bits answer walkability and line of sight
+class OccupancyGrid
+{
+public:
+    enum class CellState : uint8_t
+    {
+        Free,       // no wall touches the cell
+        Partial,    // a wall touches part of the cell, only exact geometry can answer
+        Full,       // the whole cell is inside a wall
+    };
+
+    void Build(const std::vector<Rect> &walls, const Rect &bounds, float cellSize);
+    void Clear();
+
+    CellState GetCell(int x, int y) const;
+    CellState GetCellAt(const Vec2 &point) const;
+
+    // Full if the segment crosses a full cell, Free if it only crosses free cells, otherwise Partial
+    CellState TraceSegment(const Vec2 &startPoint, const Vec2 &endPoint) const;
+
+    int GetCellsX() const { return CellsX; }
+    int GetCellsY() const { return CellsY; }
+    float GetCellSize() const { return CellSize; }
+    const Rect &GetBounds() const { return Bounds; }
+
+private:
+    static bool TestBit(const std::vector<uint64_t> &bits, size_t index);
+    static void SetBit(std::vector<uint64_t> &bits, size_t index);
+
+    Rect Bounds = {0, 0, 0, 0};
+    float CellSize = 1;
+    int CellsX = 0;
+    int CellsY = 0;
+
+    std::vector<uint64_t> FullBits;
+    std::vector<uint64_t> PartialBits;
+};
+
+}
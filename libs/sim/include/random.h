@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace sim
+{
+
+// small seeded generator, each world owns one so a run can be replayed from its seed
+// and the server never shares state with anything else using rand()
+class Random
+{
+public:
+    static constexpr uint64_t DefaultSeed = 0x9E3779B97F4A7C15ull;
+
+    explicit Random(uint64_t seed = DefaultSeed) { Seed(seed); }
+
+    void Seed(uint64_t seed) { State = seed != 0 ? seed : DefaultSeed; }
+
+    // xorshift64*
+    uint32_t Next()
+    {
+        State ^= State >> 12;
+        State ^= State << 25;
+        State ^= State >> 27;
+        return uint32_t((State * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // min and max are both included, like GetRandomValue
+    int Range(int min, int max)
+    {
+        if (min > max) {
+            int swap = min;
+            min = max;
+            max = swap;
+        }
+
+        uint32_t span = uint32_t(int64_t(max) - min + 1);
+        return int(int64_t(min) + (span != 0 ? Next() % span : Next()));
+    }
+
+private:
+    uint64_t State = DefaultSeed;
+};
+
+}
@@ -25,8 +25,6 @@
 
 #pragma once
 
-#include "raylib.h"
-
 // texture IDs
 constexpr int TileSetTexture = 0;
 constexpr int LogoTexture = 1;
@@ -90,5 +88,3 @@ constexpr int HitSoundId = 6;
 constexpr int PlayerDamageSoundId = 7;
 constexpr int CreatureDamageSoundId = 8;
 constexpr int PlayerHealSoundId = 9;
-
-const Texture& GetTexture(int id);
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <float.h>
+#include <math.h>
+
+// the simulation's own vector math, laid out like raylib's Vector2 and Rectangle so the
+// client can convert without copying field by field, and rounding the same way raylib does
+// so a local game and the server agree on every collision
+namespace sim
+{
+
+constexpr float Pi = 3.14159265358979323846f;
+constexpr float DegToRad = Pi / 180.0f;
+
+struct Vec2
+{
+    float x = 0;
+    float y = 0;
+};
+
+struct Rect
+{
+    float x = 0;
+    float y = 0;
+    float width = 0;
+    float height = 0;
+};
+
+inline Vec2 Add(const Vec2 &a, const Vec2 &b)
+{
+    return Vec2{a.x + b.x, a.y + b.y};
+}
+
+inline Vec2 Subtract(const Vec2 &a, const Vec2 &b)
+{
+    return Vec2{a.x - b.x, a.y - b.y};
+}
+
+inline Vec2 Scale(const Vec2 &v, float scale)
+{
+    return Vec2{v.x * scale, v.y * scale};
+}
+
+inline float LengthSq(const Vec2 &v)
+{
+    return v.x * v.x + v.y * v.y;
+}
+
+inline float Length(const Vec2 &v)
+{
+    return sqrtf(LengthSq(v));
+}
+
+inline float Distance(const Vec2 &a, const Vec2 &b)
+{
+    return Length(Subtract(b, a));
+}
+
+inline float DistanceSq(const Vec2 &a, const Vec2 &b)
+{
+    return LengthSq(Subtract(b, a));
+}
+
+// zero length vectors stay zero
+inline Vec2 Normalize(const Vec2 &v)
+{
+    float length = Length(v);
+    if (length <= 0)
+        return Vec2{0, 0};
+
+    return Scale(v, 1.0f / length);
+}
+
+inline Vec2 Lerp(const Vec2 &a, const Vec2 &b, float amount)
+{
+    return Vec2{a.x + amount * (b.x - a.x), a.y + amount * (b.y - a.y)};
+}
+
+inline Vec2 RectCenter(const Rect &rect)
+{
+    return Vec2{rect.x + rect.width / 2, rect.y + rect.height / 2};
+}
+
+// the right and bottom edges are outside, like CheckCollisionPointRec
+inline bool PointInRect(const Vec2 &point, const Rect &rect)
+{
+    return point.x >= rect.x && point.x < rect.x + rect.width && point.y >= rect.y && point.y < rect.y + rect.height;
+}
+
+// parallel segments never intersect, like CheckCollisionLines
+inline bool SegmentsIntersect(const Vec2 &start1, const Vec2 &end1, const Vec2 &start2, const Vec2 &end2)
+{
+    float div = (end2.y - start2.y) * (end1.x - start1.x) - (end2.x - start2.x) * (end1.y - start1.y);
+    if (fabsf(div) < FLT_EPSILON)
+        return false;
+
+    float cross1 = start1.x * end1.y - start1.y * end1.x;
+    float cross2 = start2.x * end2.y - start2.y * end2.x;
+    float xi = ((start2.x - end2.x) * cross1 - (start1.x - end1.x) * cross2) / div;
+    float yi = ((start2.y - end2.y) * cross1 - (start1.y - end1.y) * cross2) / div;
+
+    if (fabsf(start1.x - end1.x) > FLT_EPSILON && (xi < fminf(start1.x, end1.x) || xi > fmaxf(start1.x, end1.x)))
+        return false;
+    if (fabsf(start2.x - end2.x) > FLT_EPSILON && (xi < fminf(start2.x, end2.x) || xi > fmaxf(start2.x, end2.x)))
+        return false;
+    if (fabsf(start1.y - end1.y) > FLT_EPSILON && (yi < fminf(start1.y, end1.y) || yi > fmaxf(start1.y, end1.y)))
+        return false;
+    if (fabsf(start2.y - end2.y) > FLT_EPSILON && (yi < fminf(start2.y, end2.y) || yi > fmaxf(start2.y, end2.y)))
+        return false;
+
+    return true;
+}
+
+// true if the segment touches the rectangle, edges included
+inline bool SegmentHitsRect(const Vec2 &startPoint, const Vec2 &endPoint, const Rect &rect)
+{
+    if (PointInRect(startPoint, rect) || PointInRect(endPoint, rect))
+        return true;
+
+    Vec2 topLeft = {rect.x, rect.y};
+    Vec2 topRight = {rect.x + rect.width, rect.y};
+    Vec2 bottomLeft = {rect.x, rect.y + rect.height};
+    Vec2 bottomRight = {rect.x + rect.width, rect.y + rect.height};
+
+    return SegmentsIntersect(startPoint, endPoint, topLeft, topRight)
+        || SegmentsIntersect(startPoint, endPoint, topRight, bottomRight)
+        || SegmentsIntersect(startPoint, endPoint, bottomLeft, bottomRight)
+        || SegmentsIntersect(startPoint, endPoint, topLeft, bottomLeft);
+}
+
+}
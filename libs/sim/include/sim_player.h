@@ -0,0 +1,97 @@
+#pragma once
+
+#include "sim_math.h"
+#include "combat.h"
+#include "treasure.h"
+#include "mob_store.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace sim
+{
+
+// players are numbered from 1, 0 means nobody
+using PlayerId = uint16_t;
+
+struct InventoryContents
+{
+    int ItemId;
+    int Quantity;
+};
+
+constexpr int MaxHealth = 100;
+
+constexpr float PickupDistance = 20;
+
+constexpr size_t MaxBackpackSlots = 20;
+
+// everything about a player that the simulation changes, the client adds how it is drawn and controlled
+class PlayerState
+{
+public:
+    PlayerId Id = 0;
+
+    Vec2 Position = {0, 0};
+
+    bool TargetActive = false;
+    Vec2 Target = {0, 0};
+
+    // player stats
+    int Health = MaxHealth;
+    int Gold = 0;
+
+    float Speed = 100;
+
+    float LastAttack = 0;
+    float LastConsumeable = 0;
+    float AttackCooldown = 0;
+    float ItemCooldown = 0;
+
+    int BuffItem = -1;
+    float BuffLifetimeLeft = 0;
+
+    int BuffDefense = 0;
+
+    // inventory
+    int EquippedWeapon = -1;
+    int EquippedArmor = -1;
+
+    std::vector<InventoryContents> BackpackContents;
+    bool Waiting = false;
+
+    // index into the world's chests, -1 for none
+    int TargetChest = -1;
+    MobInstanceId TargetMob = NoMob;
+
+    explicit PlayerState(PlayerId id = 0);
+
+    const AttackInfo &GetAttack() const;
+    int GetDefense() const;
+
+    TreasureInstance RemoveInventoryItem(int slot, int quantity);
+
+    // returns true if the whole drop was taken, drop is left holding whatever didn't fit
+    bool PickupItem(TreasureInstance &drop);
+
+private:
+    AttackInfo DefaultAttack = {"Slap", true, 1, 1, 1.0f, 10.0f};
+};
+
+inline const AttackInfo &PlayerState::GetAttack() const
+{
+    if (EquippedWeapon == -1)
+        return DefaultAttack;
+
+    return GetItem(EquippedWeapon)->Attack;
+}
+
+inline int PlayerState::GetDefense() const
+{
+    if (EquippedArmor == -1)
+        return 0 + BuffDefense;
+
+    return GetItem(EquippedArmor)->Defense.Defense + BuffDefense;
+}
+
+}
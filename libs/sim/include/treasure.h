@@ -27,8 +27,6 @@
 
 #include "items.h"
 
-#include "raylib.h"
-
 #include <vector>
 #include <string>
 
@@ -36,9 +34,6 @@ struct TreasureInstance
 {
 	int ItemId = -1;
 	int Quantity = 1;
-
-	Vector2 Position = { 0,0 };
-	int SpriteId;
 };
 
-std::vector<TreasureInstance> GetLoot(const std::string& loot_name);
\ No newline at end of file
+std::vector<TreasureInstance> GetLoot(const std::string& loot_name, sim::Random& random);
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#pragma once
+
+#include "sim_math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace sim
+{
+
+// uniform grid over the wall rectangles of a map, built once at load time
+// so collision queries only test the walls in the cells they touch.
+// queries don't change it, so worlds on different threads can share one
+class WallGrid
+{
+public:
+    void Build(const std::vector<Rect> &walls, const Rect &bounds, float cellSize);
+    void Clear();
+
+    bool PointHitsWall(const Vec2 &point) const;
+    bool SegmentHitsWall(const Vec2 &startPoint, const Vec2 &endPoint) const;
+
+    size_t GetWallCount() const { return Walls.size(); }
+
+private:
+    int GetCellX(float x) const;
+    int GetCellY(float y) const;
+    bool SegmentHitsCell(int cellX,
+                         int cellY,
+                         const Vec2 &startPoint,
+                         const Vec2 &endPoint,
+                         std::vector<uint32_t> &stamps,
+                         uint32_t stamp) const;
+
+    Rect Bounds = {0, 0, 0, 0};
+    float CellSize = 1;
+    int CellsX = 0;
+    int CellsY = 0;
+
+    std::vector<Rect> Walls;
+
+    // cell c owns CellWalls[CellStarts[c]] .. CellWalls[CellStarts[c + 1] - 1]
+    std::vector<int> CellStarts;
+    std::vector<int> CellWalls;
+};
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "sim_math.h"
+#include "random.h"
+#include "map_collision.h"
+#include "mob_store.h"
+#include "sim_player.h"
+#include "treasure.h"
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Item;
+
+namespace sim
+{
+
+struct Exit
+{
+    Rect Bounds;
+    std::string Destination;
+};
+
+struct Chest
+{
+    Rect Bounds;
+    std::string Contents;
+    bool Opened = false;
+};
+
+using DropId = uint32_t;
+
+struct ItemDrop
+{
+    DropId Id = 0;
+    TreasureInstance Item;
+    Vec2 Position;
+};
+
+enum class EventType : uint8_t
+{
+    MobAwoke,           // Position is the mob
+    PlayerAttacked,     // a player swung at a mob, Position is the mob, Target the player, Value the damage
+    MobAttacked,        // a mob swung at a player, Position is the mob, Target the player, Value the damage
+    MobDied,            // Id is the mob instance, Value its mob type
+    ChestOpened,        // Value is the chest index
+    LootDropped,        // Id is the drop
+    ItemPickedUp,       // Id is the player
+    GoldPickedUp,       // Id is the player, Value the gold
+    PlayerHealed,       // Id is the player
+    SpellCast,          // Position is the caster, Target the mob, Value the item
+    LevelExit,          // every player is waiting in an exit, Value is the exit index
+    GameWon,            // Value is the gold to show
+    GameLost,           // Value is the gold to show
+};
+
+constexpr uint8_t EventFlagMelee = 0x01;
+
+// something that happened in the world that can't be seen from its state alone,
+// the client plays the sounds and effects that go with it
+struct Event
+{
+    EventType Type = EventType::MobAwoke;
+    uint8_t Flags = 0;
+    uint32_t Id = 0;
+    int Value = 0;
+    Vec2 Position;
+    Vec2 Target;
+};
+
+// the game rules without any drawing, input or sound, run by the client for local games
+// and by the server for online ones
+class World
+{
+public:
+    // players are owned by whoever runs the world, they must outlive it or be removed
+    void AddPlayer(PlayerState &player);
+    void RemovePlayer(PlayerId id);
+    PlayerState *GetPlayer(PlayerId id) const;
+
+    void SetLevel(std::shared_ptr<const Level> level);
+    const Level *GetLevel() const { return CurrentLevel.get(); }
+    const MapCollision &GetCollision() const;
+
+    // puts the players at the spawn and fills the level with its mobs and chests
+    void StartLevel();
+
+    void Tick(float deltaTime);
+
+    // player commands
+    void SetMoveTarget(PlayerState &player, const Vec2 &target);
+    void ActivateItem(PlayerState &player, int slotIndex);
+    void DropItem(PlayerState &player, int slotIndex);
+
+    // walks a player one step toward its target and nothing else a tick does,
+    // online clients predict their own player with it between server states
+    void MoveTowardTarget(PlayerState &player, float deltaTime) const;
+
+    float GetGameTime() const { return float(GameClock); }
+
+    // events pile up until whoever runs the world takes them
+    std::vector<Event> Events;
+
+    std::vector<PlayerState *> Players;
+    std::vector<Exit> Exits;
+    std::vector<Chest> Chests;
+    std::vector<ItemDrop> ItemDrops;
+    MobStore Mobs;
+
+    double GameClock = 0;
+    uint32_t TickCount = 0;
+
+    // length of the tick being simulated
+    float TickDeltaTime = 0;
+
+    Random Rng;
+
+private:
+    void MovePlayer(PlayerState &player);
+    void ApplyAction(PlayerState &player);
+    void UseConsumable(PlayerState &player, Item *item);
+
+    void UpdateMobs();
+    void CullDeadMobs();
+    void MobAttack(size_t mob, PlayerState &player);
+
+    // index into Mobs, -1 if no mob is in sight
+    int GetNearestMobInSight(const Vec2 &position) const;
+
+    void PlaceItemDrop(TreasureInstance &item, const Vec2 &dropPoint, bool loot = false);
+    void DropLoot(const char *contents, const Vec2 &dropPoint);
+
+    void AddEvent(EventType type, uint32_t id, int value, const Vec2 &position, const Vec2 &target = Vec2{},
+                  uint8_t flags = 0);
+
+    std::shared_ptr<const Level> CurrentLevel;
+
+    // shared paths for every mob chasing each player, parallel to Players
+    std::vector<FlowField> PathsToPlayers;
+
+    DropId NextDropId = 1;
+};
+
+}
@@ -24,7 +24,6 @@
 **********************************************************************************************/
 
 #include "items.h"
-#include "sprites.h"
 #include "resource_ids.h"
 
 #include <vector>
@@ -36,25 +35,28 @@ Item* AddItem(const char* name, int sprite, ItemTypes type)
 {
 	int id = int(ItemDB.size());
 
-	CenterSprite(sprite);
-	ItemDB.emplace_back(Item{ id, std::string(name), sprite, type });
-	return GetItem(id);
+	Item& item = ItemDB.emplace_back();
+	item.Id = id;
+	item.Name = name;
+	item.Sprite = sprite;
+	item.ItemType = type;
+	return &item;
 }
 
 Item* GetItem(int id)
 {
-	if (id < 0 || id >= ItemDB.size())
+	if (id < 0 || id >= int(ItemDB.size()))
 	return nullptr;
 
 	return &ItemDB[id];
 }
 
-int GetRandomItem(int except)
+int GetRandomItem(sim::Random& random, int except)
 {
 	int id = -1;
 	while (id == -1)
 	{
-		int index = GetRandomValue(0, int(ItemDB.size()) - 1);
+		int index = random.Range(0, int(ItemDB.size()) - 1);
 		id = ItemDB[index].Id;
 		if (id == except)
 			id = -1;
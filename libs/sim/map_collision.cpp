@@ -0,0 +1,81 @@
+#include "map_collision.h"
+
+#include <utility>
+
+namespace sim
+{
+
+// walls are indexed at load time, cells are a couple of tiles across
+constexpr float WallGridCellSize = 64;
+
+// walkability bitmap at half tile resolution, cells walls only partly cover fall back to the wall grid
+constexpr int OccupancyCellsPerTile = 2;
+
+void MapCollision::Build(const MapData &map, CollisionMode mode)
+{
+    Bounds = map.Bounds;
+    Mode = mode;
+
+    std::vector<Rect> walls = map.GetWalls();
+    Walls.Build(walls, Bounds, WallGridCellSize);
+    Occupancy.Build(walls, Bounds, map.TileSize / OccupancyCellsPerTile);
+
+    // tile sized walkability for mob pathfinding
+    Nav.Build(Bounds, map.TileSize, [this](const Vec2 &point) { return PointInMap(point); });
+}
+
+void MapCollision::Clear()
+{
+    Bounds = Rect{0, 0, 0, 0};
+    Walls.Clear();
+    Occupancy.Clear();
+    Nav.Clear();
+}
+
+bool MapCollision::PointInMap(const Vec2 &point) const
+{
+    if (!PointInRect(point, Bounds))
+        return false;
+
+    if (Mode == CollisionMode::Bitmap) {
+        OccupancyGrid::CellState state = Occupancy.GetCellAt(point);
+        if (state != OccupancyGrid::CellState::Partial)
+            return state == OccupancyGrid::CellState::Free;
+    }
+
+    return !Walls.PointHitsWall(point);
+}
+
+bool MapCollision::RayHitsMap(const Vec2 &startPoint, const Vec2 &endPoint) const
+{
+    if (!PointInMap(startPoint) || !PointInMap(endPoint))
+        return true;
+
+    if (Mode == CollisionMode::Bitmap) {
+        OccupancyGrid::CellState state = Occupancy.TraceSegment(startPoint, endPoint);
+        if (state != OccupancyGrid::CellState::Partial)
+            return state == OccupancyGrid::CellState::Full;
+    }
+
+    return Walls.SegmentHitsWall(startPoint, endPoint);
+}
+
+std::shared_ptr<Level> CreateLevel(const std::string &path, MapData &&map, CollisionMode mode)
+{
+    auto level = std::make_shared<Level>();
+    level->Path = path;
+    level->Map = std::move(map);
+    level->Collision.Build(level->Map, mode);
+    return level;
+}
+
+std::shared_ptr<Level> LoadLevel(const char *filePath, CollisionMode mode)
+{
+    MapData map;
+    if (!LoadMapData(filePath, map))
+        return nullptr;
+
+    return CreateLevel(filePath, std::move(map), mode);
+}
+
+}
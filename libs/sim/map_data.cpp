@@ -0,0 +1,100 @@
+#include "map_data.h"
+
+#include "pugixml.hpp"
+
+#include <utility>
+
+namespace sim
+{
+
+const std::string *MapObject::GetProperty(const char *name) const
+{
+    for (const MapProperty &property : Properties) {
+        if (property.Name == name)
+            return &property.Value;
+    }
+
+    return nullptr;
+}
+
+std::vector<const MapObject *> MapData::GetObjectsOfType(const char *type) const
+{
+    std::vector<const MapObject *> objects;
+    for (const MapObject &object : Objects) {
+        if (object.Type == type)
+            objects.push_back(&object);
+    }
+
+    return objects;
+}
+
+const MapObject *MapData::GetFirstObjectOfType(const char *type) const
+{
+    for (const MapObject &object : Objects) {
+        if (object.Type == type)
+            return &object;
+    }
+
+    return nullptr;
+}
+
+std::vector<Rect> MapData::GetWalls() const
+{
+    std::vector<Rect> walls;
+    for (const MapObject &object : Objects) {
+        if (object.Type == WallType)
+            walls.push_back(object.Bounds);
+    }
+
+    return walls;
+}
+
+static void ReadObjects(const pugi::xml_node &group, MapData &map)
+{
+    for (pugi::xml_node child : group.children("object")) {
+        MapObject object;
+        object.Id = child.attribute("id").as_int();
+        object.Name = child.attribute("name").as_string();
+
+        // newer versions of tiled call the type a class
+        object.Type = child.attribute("type").as_string();
+        if (object.Type.empty())
+            object.Type = child.attribute("class").as_string();
+
+        object.Bounds.x = child.attribute("x").as_float();
+        object.Bounds.y = child.attribute("y").as_float();
+        object.Bounds.width = child.attribute("width").as_float();
+        object.Bounds.height = child.attribute("height").as_float();
+
+        for (pugi::xml_node property : child.child("properties").children("property")) {
+            object.Properties.emplace_back(MapProperty{property.attribute("name").as_string(),
+                                                       property.attribute("value").as_string()});
+        }
+
+        map.Objects.push_back(std::move(object));
+    }
+}
+
+bool LoadMapData(const char *filePath, MapData &map)
+{
+    map = MapData();
+
+    pugi::xml_document doc;
+    if (!doc.load_file(filePath))
+        return false;
+
+    pugi::xml_node root = doc.child("map");
+    if (!root)
+        return false;
+
+    map.TileSize = root.attribute("tilewidth").as_float(32);
+    map.Bounds.width = root.attribute("width").as_float() * map.TileSize;
+    map.Bounds.height = root.attribute("height").as_float() * root.attribute("tileheight").as_float(map.TileSize);
+
+    for (pugi::xml_node group : root.children("objectgroup"))
+        ReadObjects(group, map);
+
+    return true;
+}
+
+}
@@ -0,0 +1,136 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "mob_store.h"
+#include "monsters.h"
+
+#include <algorithm>
+
+namespace sim
+{
+
+template<typename T>
+static void SwapRemove(std::vector<T> &values, size_t index)
+{
+    values[index] = values.back();
+    values.pop_back();
+}
+
+MobInstanceId MobStore::Add(const MOB &monster, const Vec2 &position, MobInstanceId id)
+{
+    if (id == NoMob)
+        id = NextInstanceId++;
+    else
+        NextInstanceId = std::max(NextInstanceId, id + 1);
+
+    if (IndexOfInstance.size() <= id)
+        IndexOfInstance.resize(size_t(id) + 1, -1);
+    IndexOfInstance[id] = int(InstanceIds.size());
+
+    InstanceIds.push_back(id);
+    MobIds.push_back(monster.Id);
+    PositionX.push_back(position.x);
+    PositionY.push_back(position.y);
+    Health.push_back(monster.Health);
+    Triggered.push_back(0);
+    LastAttack.push_back(-100);
+
+    Speed.push_back(monster.Speed);
+    DetectionRadiusSq.push_back(monster.DetectionRadius * monster.DetectionRadius);
+    AttackRangeSq.push_back(monster.Attack.Range * monster.Attack.Range);
+
+    TargetPlayer.push_back(0);
+    TargetDistanceSq.push_back(0);
+
+    return id;
+}
+
+void MobStore::RemoveAt(size_t index)
+{
+    IndexOfInstance[InstanceIds[index]] = -1;
+    if (index + 1 != InstanceIds.size())
+        IndexOfInstance[InstanceIds.back()] = int(index);
+
+    SwapRemove(InstanceIds, index);
+    SwapRemove(MobIds, index);
+    SwapRemove(PositionX, index);
+    SwapRemove(PositionY, index);
+    SwapRemove(Health, index);
+    SwapRemove(Triggered, index);
+    SwapRemove(LastAttack, index);
+    SwapRemove(Speed, index);
+    SwapRemove(DetectionRadiusSq, index);
+    SwapRemove(AttackRangeSq, index);
+    SwapRemove(TargetPlayer, index);
+    SwapRemove(TargetDistanceSq, index);
+}
+
+void MobStore::Clear()
+{
+    InstanceIds.clear();
+    MobIds.clear();
+    PositionX.clear();
+    PositionY.clear();
+    Health.clear();
+    Triggered.clear();
+    LastAttack.clear();
+    Speed.clear();
+    DetectionRadiusSq.clear();
+    AttackRangeSq.clear();
+    TargetPlayer.clear();
+    TargetDistanceSq.clear();
+
+    // ids are never reused, so a stale id from the last level can't pick up a new mob
+    std::fill(IndexOfInstance.begin(), IndexOfInstance.end(), -1);
+}
+
+int MobStore::FindIndex(MobInstanceId id) const
+{
+    if (id == NoMob || id >= IndexOfInstance.size())
+        return -1;
+
+    return IndexOfInstance[id];
+}
+
+int MobStore::FindNear(const Vec2 &point, float radius) const
+{
+    float radiusSq = radius * radius;
+    for (size_t i = 0; i < InstanceIds.size(); i++) {
+        float dx = PositionX[i] - point.x;
+        float dy = PositionY[i] - point.y;
+        if (dx * dx + dy * dy <= radiusSq)
+            return int(i);
+    }
+
+    return -1;
+}
+
+void MobStore::SetPosition(size_t index, const Vec2 &position)
+{
+    PositionX[index] = position.x;
+    PositionY[index] = position.y;
+}
+
+}
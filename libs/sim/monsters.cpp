@@ -34,14 +34,17 @@ MOB* AddMob(const char* name, int sprite, int health)
 {
 	int id = int(MobDB.size());
 
-	CenterSprite(sprite);
-	MobDB.emplace_back(MOB{ id, std::string(name), sprite, health });
-	return GetMob(id);
+	MOB& mob = MobDB.emplace_back();
+	mob.Id = id;
+	mob.Name = name;
+	mob.Sprite = sprite;
+	mob.Health = health;
+	return &mob;
 }
 
 MOB* GetMob(int id)
 {
-	if (id < 0 || id >= MobDB.size())
+	if (id < 0 || id >= int(MobDB.size()))
 		return nullptr;
 
 	return &MobDB[id];
@@ -0,0 +1,140 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "occupancy_grid.h"
+#include "grid_traversal.h"
+
+#include "sim_math.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace sim
+{
+
+bool OccupancyGrid::TestBit(const std::vector<uint64_t> &bits, size_t index)
+{
+    return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+void OccupancyGrid::SetBit(std::vector<uint64_t> &bits, size_t index)
+{
+    bits[index >> 6] |= uint64_t(1) << (index & 63);
+}
+
+void OccupancyGrid::Build(const std::vector<Rect> &walls, const Rect &bounds, float cellSize)
+{
+    Clear();
+
+    Bounds = bounds;
+    CellSize = cellSize > 0 ? cellSize : 1;
+    CellsX = std::max(1, int(ceilf(bounds.width / CellSize)));
+    CellsY = std::max(1, int(ceilf(bounds.height / CellSize)));
+
+    size_t words = (size_t(CellsX) * CellsY + 63) / 64;
+    FullBits.assign(words, 0);
+    PartialBits.assign(words, 0);
+
+    for (const Rect &wall : walls) {
+        float right = wall.x + wall.width;
+        float bottom = wall.y + wall.height;
+
+        // cells that only share an edge with the wall still count as touched, the exact
+        // segment test treats wall edges as solid and the bitmap has to agree with it
+        int minX = std::max(0, int(floorf((wall.x - Bounds.x) / CellSize)) - 1);
+        int maxX = std::min(CellsX - 1, int(floorf((right - Bounds.x) / CellSize)));
+        int minY = std::max(0, int(floorf((wall.y - Bounds.y) / CellSize)) - 1);
+        int maxY = std::min(CellsY - 1, int(floorf((bottom - Bounds.y) / CellSize)));
+
+        for (int y = minY; y <= maxY; y++) {
+            float cellTop = Bounds.y + y * CellSize;
+            float cellBottom = cellTop + CellSize;
+            if (wall.y > cellBottom || bottom < cellTop)
+                continue;
+
+            for (int x = minX; x <= maxX; x++) {
+                float cellLeft = Bounds.x + x * CellSize;
+                float cellRight = cellLeft + CellSize;
+                if (wall.x > cellRight || right < cellLeft)
+                    continue;
+
+                size_t index = size_t(y) * CellsX + x;
+                if (wall.x <= cellLeft && right >= cellRight && wall.y <= cellTop && bottom >= cellBottom)
+                    SetBit(FullBits, index);
+                else
+                    SetBit(PartialBits, index);
+            }
+        }
+    }
+
+    // a cell another wall fills completely is blocked no matter what else touches it
+    for (size_t i = 0; i < words; i++)
+        PartialBits[i] &= ~FullBits[i];
+}
+
+void OccupancyGrid::Clear()
+{
+    Bounds = Rect{0, 0, 0, 0};
+    CellsX = CellsY = 0;
+    FullBits.clear();
+    PartialBits.clear();
+}
+
+OccupancyGrid::CellState OccupancyGrid::GetCell(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= CellsX || y >= CellsY)
+        return CellState::Full;
+
+    size_t index = size_t(y) * CellsX + x;
+    if (TestBit(FullBits, index))
+        return CellState::Full;
+
+    if (TestBit(PartialBits, index))
+        return CellState::Partial;
+
+    return CellState::Free;
+}
+
+OccupancyGrid::CellState OccupancyGrid::GetCellAt(const Vec2 &point) const
+{
+    return GetCell(int(floorf((point.x - Bounds.x) / CellSize)), int(floorf((point.y - Bounds.y) / CellSize)));
+}
+
+OccupancyGrid::CellState OccupancyGrid::TraceSegment(const Vec2 &startPoint, const Vec2 &endPoint) const
+{
+    CellState result = CellState::Free;
+
+    bool blocked = WalkGridCells(startPoint, endPoint, Vec2{Bounds.x, Bounds.y}, CellSize, CellsX, CellsY,
+                                 [&](int cellX, int cellY) {
+                                     CellState state = GetCell(cellX, cellY);
+                                     if (state == CellState::Partial)
+                                         result = CellState::Partial;
+                                     return state == CellState::Full;
+                                 });
+
+    return blocked ? CellState::Full : result;
+}
+
+}
@@ -26,14 +26,14 @@
 #include "treasure.h"
 #include "items.h"
 
-std::vector<TreasureInstance> GetLoot(const std::string& loot_name)
+std::vector<TreasureInstance> GetLoot(const std::string& loot_name, sim::Random& random)
 {
 	std::vector<TreasureInstance> loot;
 
 	if (loot_name == "tutorial_loot_0")
 	{
 		loot.emplace_back(TreasureInstance{ LeatherArmorItem });
-		loot.emplace_back(TreasureInstance{ FoodItem, GetRandomValue(2,5) });
+		loot.emplace_back(TreasureInstance{ FoodItem, random.Range(2, 5) });
 	}
 	else if (loot_name == "tutorial_loot_1")
 	{
@@ -41,17 +41,17 @@ std::vector<TreasureInstance> GetLoot(const std::string& loot_name)
 	}
 	else if (loot_name == "random_loot")
 	{
-		int count = GetRandomValue(1, 3);
+		int count = random.Range(1, 3);
 		for (int i = 0; i < count; i++)
-			loot.emplace_back(TreasureInstance{ GetRandomItem(GoldBagItem) });
+			loot.emplace_back(TreasureInstance{ GetRandomItem(random, GoldBagItem) });
 	}
 	else if (loot_name == "mob_loot")
 	{
-		loot.emplace_back(TreasureInstance{ GetRandomItem(GoldBagItem) });
+		loot.emplace_back(TreasureInstance{ GetRandomItem(random, GoldBagItem) });
 	}
 
 	// random gold
-	int value = GetRandomValue(1, 20);
+	int value = random.Range(1, 20);
 	loot.emplace_back(TreasureInstance{ GoldBagItem, value });
 
 	return loot;
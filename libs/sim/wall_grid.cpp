@@ -0,0 +1,164 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "wall_grid.h"
+#include "grid_traversal.h"
+
+#include "sim_math.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace sim
+{
+
+// walls spanning several cells are only tested once per segment query. the stamps belong to the thread rather than
+// the grid, every query takes a new stamp so one thread can go back and forth between grids
+struct WallStamps
+{
+    std::vector<uint32_t> Stamps;
+    uint32_t Current = 0;
+};
+
+static thread_local WallStamps QueryStamps;
+
+void WallGrid::Build(const std::vector<Rect> &walls, const Rect &bounds, float cellSize)
+{
+    Clear();
+
+    Bounds = bounds;
+    CellSize = cellSize > 0 ? cellSize : 1;
+    CellsX = std::max(1, int(ceilf(bounds.width / CellSize)));
+    CellsY = std::max(1, int(ceilf(bounds.height / CellSize)));
+
+    Walls = walls;
+
+    // walls are added to every cell their rectangle touches, edges included, so
+    // a query that lands on a cell border still sees walls from both sides
+    std::vector<int> counts(size_t(CellsX) * CellsY + 1, 0);
+    for (const Rect &wall : Walls) {
+        int minX = GetCellX(wall.x), maxX = GetCellX(wall.x + wall.width);
+        int minY = GetCellY(wall.y), maxY = GetCellY(wall.y + wall.height);
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++)
+                counts[size_t(y) * CellsX + x]++;
+        }
+    }
+
+    CellStarts.resize(counts.size());
+    int total = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        CellStarts[i] = total;
+        total += counts[i];
+    }
+
+    CellWalls.resize(total);
+    std::vector<int> fill(CellStarts.begin(), CellStarts.end() - 1);
+    for (int i = 0; i < int(Walls.size()); i++) {
+        const Rect &wall = Walls[i];
+        int minX = GetCellX(wall.x), maxX = GetCellX(wall.x + wall.width);
+        int minY = GetCellY(wall.y), maxY = GetCellY(wall.y + wall.height);
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++)
+                CellWalls[fill[size_t(y) * CellsX + x]++] = i;
+        }
+    }
+}
+
+void WallGrid::Clear()
+{
+    Bounds = Rect{0, 0, 0, 0};
+    CellsX = CellsY = 0;
+    Walls.clear();
+    CellStarts.clear();
+    CellWalls.clear();
+}
+
+int WallGrid::GetCellX(float x) const
+{
+    return std::clamp(int(floorf((x - Bounds.x) / CellSize)), 0, CellsX - 1);
+}
+
+int WallGrid::GetCellY(float y) const
+{
+    return std::clamp(int(floorf((y - Bounds.y) / CellSize)), 0, CellsY - 1);
+}
+
+bool WallGrid::PointHitsWall(const Vec2 &point) const
+{
+    if (Walls.empty())
+        return false;
+
+    size_t cell = size_t(GetCellY(point.y)) * CellsX + GetCellX(point.x);
+    for (int i = CellStarts[cell]; i < CellStarts[cell + 1]; i++) {
+        if (PointInRect(point, Walls[CellWalls[i]]))
+            return true;
+    }
+
+    return false;
+}
+
+bool WallGrid::SegmentHitsCell(int cellX,
+                               int cellY,
+                               const Vec2 &startPoint,
+                               const Vec2 &endPoint,
+                               std::vector<uint32_t> &stamps,
+                               uint32_t stamp) const
+{
+    size_t cell = size_t(cellY) * CellsX + cellX;
+    for (int i = CellStarts[cell]; i < CellStarts[cell + 1]; i++) {
+        int wall = CellWalls[i];
+        if (stamps[wall] == stamp)
+            continue;
+
+        stamps[wall] = stamp;
+        if (SegmentHitsRect(startPoint, endPoint, Walls[wall]))
+            return true;
+    }
+
+    return false;
+}
+
+bool WallGrid::SegmentHitsWall(const Vec2 &startPoint, const Vec2 &endPoint) const
+{
+    if (Walls.empty())
+        return false;
+
+    std::vector<uint32_t> &stamps = QueryStamps.Stamps;
+    if (stamps.size() < Walls.size())
+        stamps.resize(Walls.size(), 0);
+
+    if (++QueryStamps.Current == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        QueryStamps.Current = 1;
+    }
+
+    uint32_t stamp = QueryStamps.Current;
+    return WalkGridCells(startPoint, endPoint, Vec2{Bounds.x, Bounds.y}, CellSize, CellsX, CellsY,
+                         [&](int cellX, int cellY)
+                         { return SegmentHitsCell(cellX, cellY, startPoint, endPoint, stamps, stamp); });
+}
+
+}
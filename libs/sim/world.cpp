@@ -0,0 +1,630 @@
+#include "world.h"
+
+#include "items.h"
+#include "monsters.h"
+#include "treasure.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace sim
+{
+
+// how many spots around a drop point are tried before the item is left right on it
+constexpr int MaxDropPlacementTries = 100;
+
+void World::AddPlayer(PlayerState &player)
+{
+    if (GetPlayer(player.Id) != nullptr)
+        return;
+
+    Players.push_back(&player);
+    PathsToPlayers.emplace_back();
+}
+
+void World::RemovePlayer(PlayerId id)
+{
+    for (size_t i = 0; i < Players.size(); i++) {
+        if (Players[i]->Id != id)
+            continue;
+
+        Players.erase(Players.begin() + i);
+        PathsToPlayers.erase(PathsToPlayers.begin() + i);
+        return;
+    }
+}
+
+PlayerState *World::GetPlayer(PlayerId id) const
+{
+    for (PlayerState *player : Players) {
+        if (player->Id == id)
+            return player;
+    }
+
+    return nullptr;
+}
+
+void World::SetLevel(std::shared_ptr<const Level> level)
+{
+    CurrentLevel = std::move(level);
+
+    // the old fields point at the last level's nav grid
+    for (FlowField &paths : PathsToPlayers)
+        paths.Reset();
+}
+
+const MapCollision &World::GetCollision() const
+{
+    static const MapCollision noCollision;
+    return CurrentLevel ? CurrentLevel->Collision : noCollision;
+}
+
+void World::AddEvent(EventType type, uint32_t id, int value, const Vec2 &position, const Vec2 &target, uint8_t flags)
+{
+    Events.emplace_back(Event{type, flags, id, value, position, target});
+}
+
+void World::StartLevel()
+{
+    GameClock = 0;
+
+    Exits.clear();
+    Chests.clear();
+    ItemDrops.clear();
+    Mobs.Clear();
+
+    for (FlowField &paths : PathsToPlayers)
+        paths.Reset();
+
+    const MapObject *spawn = CurrentLevel ? CurrentLevel->Map.GetFirstObjectOfType(PlayerSpawnType) : nullptr;
+
+    for (PlayerState *player : Players) {
+        player->LastConsumeable = -100;
+        player->LastAttack = -100;
+        player->Waiting = false;
+        player->TargetActive = false;
+        player->TargetChest = -1;
+        player->TargetMob = NoMob;
+
+        if (spawn != nullptr)
+            player->Position = Vec2{spawn->Bounds.x, spawn->Bounds.y};
+    }
+
+    if (!CurrentLevel)
+        return;
+
+    const MapData &map = CurrentLevel->Map;
+
+    for (const MapObject *exit : map.GetObjectsOfType(ExitType)) {
+        const std::string *level = exit->GetProperty("target_level");
+        if (level != nullptr) {
+            if (*level == "-1")
+                Exits.emplace_back(Exit{exit->Bounds, "endgame"});
+            else
+                Exits.emplace_back(Exit{exit->Bounds, "level" + *level + ".tmx"});
+        }
+    }
+
+    for (const MapObject *chest : map.GetObjectsOfType(ChestType)) {
+        const std::string *contents = chest->GetProperty("contents");
+        if (contents != nullptr)
+            Chests.emplace_back(Chest{chest->Bounds, *contents});
+    }
+
+    for (const MapObject *mobSpawn : map.GetObjectsOfType(MobSpawnType)) {
+        const std::string *mobType = mobSpawn->GetProperty("mob_type");
+        if (mobType == nullptr)
+            continue;
+
+        MOB *monster = GetMob(atoi(mobType->c_str()));
+        if (monster == nullptr)
+            continue;
+
+        Mobs.Add(*monster, Vec2{mobSpawn->Bounds.x, mobSpawn->Bounds.y});
+    }
+}
+
+void World::Tick(float deltaTime)
+{
+    TickDeltaTime = deltaTime;
+    GameClock += deltaTime;
+    TickCount++;
+
+    for (PlayerState *player : Players)
+        MovePlayer(*player);
+
+    for (PlayerState *player : Players)
+        ApplyAction(*player);
+
+    UpdateMobs();
+
+    bool dead = false;
+    int gold = 0;
+    for (PlayerState *player : Players) {
+        dead = dead || player->Health < 0;
+        gold += player->Gold;
+    }
+
+    if (dead)
+        AddEvent(EventType::GameLost, 0, gold, Vec2{});
+}
+
+void World::SetMoveTarget(PlayerState &player, const Vec2 &target)
+{
+    if (player.Waiting)
+        return;
+
+    const MapCollision &collision = GetCollision();
+    if (collision.PointInMap(target)) {
+        player.TargetActive = true;
+        player.Target = target;
+    }
+
+    player.TargetChest = -1;
+    for (size_t i = 0; i < Chests.size(); i++) {
+        if (PointInRect(target, Chests[i].Bounds))
+            player.TargetChest = int(i);
+    }
+
+    // if player is close to any mob
+    int mob = Mobs.FindNear(target, 20);
+    if (mob >= 0) {
+        player.TargetMob = Mobs.InstanceIds[mob];
+
+        if (Distance(player.Position, Mobs.GetPosition(mob)) <= player.GetAttack().Range + 40)
+            player.TargetActive = false;
+    }
+}
+
+void World::CullDeadMobs()
+{
+    // walk backwards, removing a mob moves the last one into its slot
+    for (size_t i = Mobs.Size(); i-- > 0;) {
+        if (Mobs.Health[i] > 0)
+            continue;
+
+        MOB *monsterInfo = GetMob(Mobs.MobIds[i]);
+        Vec2 position = Mobs.GetPosition(i);
+
+        if (monsterInfo != nullptr)
+            DropLoot(monsterInfo->lootTable.c_str(), position);
+
+        AddEvent(EventType::MobDied, Mobs.InstanceIds[i], Mobs.MobIds[i], position);
+
+        Mobs.RemoveAt(i);
+    }
+}
+
+void World::MobAttack(size_t mob, PlayerState &player)
+{
+    MOB *monsterInfo = GetMob(Mobs.MobIds[mob]);
+    if (monsterInfo == nullptr)
+        return;
+
+    // try to attack the player
+    if (GetGameTime() - Mobs.LastAttack[mob] < monsterInfo->Attack.Cooldown)
+        return;
+
+    Mobs.LastAttack[mob] = GetGameTime();
+    int damage = ResolveAttack(monsterInfo->Attack, player.GetDefense(), Rng);
+
+    AddEvent(EventType::MobAttacked, player.Id, damage, Mobs.GetPosition(mob), player.Position,
+             monsterInfo->Attack.Melee ? EventFlagMelee : 0);
+
+    player.Health -= damage;
+}
+
+void World::UpdateMobs()
+{
+    CullDeadMobs();
+
+    if (Players.empty())
+        return;
+
+    const MapCollision &collision = GetCollision();
+
+    // only rebuilt when a player has moved into a new tile
+    for (size_t p = 0; p < Players.size(); p++)
+        PathsToPlayers[p].Update(collision.GetNavGrid(), Players[p]->Position);
+
+    size_t count = Mobs.Size();
+    const float *positionX = Mobs.PositionX.data();
+    const float *positionY = Mobs.PositionY.data();
+    uint16_t *targetPlayer = Mobs.TargetPlayer.data();
+    float *targetDistanceSq = Mobs.TargetDistanceSq.data();
+
+    // find the closest player to every mob, a straight pass over the position arrays per player
+    for (size_t i = 0; i < count; i++) {
+        targetPlayer[i] = 0;
+        targetDistanceSq[i] = INFINITY;
+    }
+
+    for (size_t p = 0; p < Players.size(); p++) {
+        const float playerX = Players[p]->Position.x;
+        const float playerY = Players[p]->Position.y;
+        for (size_t i = 0; i < count; i++) {
+            float dx = playerX - positionX[i];
+            float dy = playerY - positionY[i];
+            float distance = dx * dx + dy * dy;
+
+            // ties go to the later player, like the two player version always did
+            bool closer = p == 0 || !(targetDistanceSq[i] < distance);
+            targetPlayer[i] = closer ? uint16_t(p) : targetPlayer[i];
+            targetDistanceSq[i] = closer ? distance : targetDistanceSq[i];
+        }
+    }
+
+    // see if any sleeping mobs should wake up, only the ones in range pay for a line of sight check
+    for (size_t i = 0; i < count; i++) {
+        if (Mobs.Triggered[i] || targetDistanceSq[i] > Mobs.DetectionRadiusSq[i])
+            continue;
+
+        PlayerState &player = *Players[targetPlayer[i]];
+        if (player.Waiting)
+            continue;
+
+        Vec2 position = Mobs.GetPosition(i);
+        if (collision.RayHitsMap(player.Position, position))
+            continue; // something is blocking line of sight
+
+        // we see our prey, wake up and get em.
+        Mobs.Triggered[i] = 1;
+
+        AddEvent(EventType::MobAwoke, Mobs.InstanceIds[i], 0, position);
+    }
+
+    // awake mobs attack when they are in range and otherwise chase
+    for (size_t i = 0; i < count; i++) {
+        if (!Mobs.Triggered[i])
+            continue;
+
+        PlayerState &player = *Players[targetPlayer[i]];
+        if (player.Waiting)
+            continue;
+
+        if (targetDistanceSq[i] < Mobs.AttackRangeSq[i]) {
+            MobAttack(i, player);
+            continue;
+        }
+
+        // try to move, following the shared path to the player around walls
+        Vec2 position = Mobs.GetPosition(i);
+        const FlowField &paths = PathsToPlayers[targetPlayer[i]];
+
+        Vec2 movement;
+        if (!paths.GetDirection(position, movement))
+            movement = Normalize(Subtract(player.Position, position));
+
+        float frameSpeed = Mobs.Speed[i] * TickDeltaTime;
+        Vec2 newPos = Add(position, Scale(movement, frameSpeed));
+
+        // slide along walls instead of stopping dead
+        if (collision.PointInMap(newPos))
+            Mobs.SetPosition(i, newPos);
+        else if (collision.PointInMap(Vec2{newPos.x, position.y}))
+            Mobs.PositionX[i] = newPos.x;
+        else if (collision.PointInMap(Vec2{position.x, newPos.y}))
+            Mobs.PositionY[i] = newPos.y;
+    }
+}
+
+int World::GetNearestMobInSight(const Vec2 &position) const
+{
+    const MapCollision &collision = GetCollision();
+
+    int nearest = -1;
+    float nearestDistance = 9999999.9f;
+
+    for (size_t i = 0; i < Mobs.Size(); i++) {
+        Vec2 mobPosition = Mobs.GetPosition(i);
+
+        // cheap distance test first, the ray cast is only worth it for a closer mob
+        float dist = Distance(mobPosition, position);
+        if (dist >= nearestDistance)
+            continue;
+
+        if (collision.RayHitsMap(mobPosition, position))
+            continue;
+
+        nearest = int(i);
+        nearestDistance = dist;
+    }
+
+    return nearest;
+}
+
+void World::UseConsumable(PlayerState &player, Item *item)
+{
+    if (item == nullptr || !item->IsActivatable())
+        return;
+
+    float time = GetGameTime() - player.LastConsumeable;
+    if (time < 1)
+        return;
+
+    player.LastConsumeable = GetGameTime();
+
+    switch (item->Effect) {
+        case ActivatableEffects::Healing:player.Health += item->Value;
+            if (player.Health > MaxHealth)
+                player.Health = MaxHealth;
+
+            AddEvent(EventType::PlayerHealed, player.Id, item->Value, player.Position);
+            break;
+
+        case ActivatableEffects::Defense:player.BuffDefense = item->Value;
+            player.BuffLifetimeLeft = item->Durration;
+            player.BuffItem = item->Sprite;
+            break;
+
+        case ActivatableEffects::Damage: {
+            int mob = GetNearestMobInSight(player.Position);
+            if (mob >= 0) {
+                Mobs.Health[mob] -= item->Value;
+                AddEvent(EventType::SpellCast, player.Id, item->Id, player.Position, Mobs.GetPosition(mob));
+            }
+            break;
+        }
+
+        default: break;
+    }
+}
+
+void World::PlaceItemDrop(TreasureInstance &item, const Vec2 &dropPoint, bool loot)
+{
+    Item *itemRecord = GetItem(item.ItemId);
+    if (!itemRecord)
+        return;
+
+    const MapCollision &collision = GetCollision();
+
+    // somewhere on a ring around the drop point that nobody is standing close enough to pick up right away
+    Vec2 position = dropPoint;
+    for (int attempt = 0; attempt < MaxDropPlacementTries; attempt++) {
+        float angle = float(Rng.Range(-180, 180));
+        Vec2 spot = Add(dropPoint, Scale(Vec2{cosf(angle * DegToRad), sinf(angle * DegToRad)}, 45));
+
+        if (!collision.PointInMap(spot))
+            continue;
+
+        bool clear = std::all_of(Players.begin(), Players.end(), [&spot](const PlayerState *player) {
+            return Distance(spot, player->Position) > PickupDistance;
+        });
+
+        if (clear) {
+            position = spot;
+            break;
+        }
+    }
+
+    DropId id = NextDropId++;
+    ItemDrops.emplace_back(ItemDrop{id, item, position});
+
+    if (loot)
+        AddEvent(EventType::LootDropped, id, item.ItemId, position);
+}
+
+void World::ActivateItem(PlayerState &player, int slotIndex)
+{
+    if (slotIndex < 0 || slotIndex >= int(player.BackpackContents.size()))
+        return;
+
+    InventoryContents &inventorySlot = player.BackpackContents[slotIndex];
+
+    Item *item = GetItem(inventorySlot.ItemId);
+    if (item == nullptr)
+        return;
+
+    TreasureInstance removedItem = player.RemoveInventoryItem(slotIndex, 1);
+
+    if (removedItem.Quantity == 0)
+        return;
+
+    switch (item->ItemType) {
+        case ItemTypes::Activatable:UseConsumable(player, item);
+            removedItem.ItemId = -1;
+            removedItem.Quantity = 0;
+            break;
+
+        case ItemTypes::Weapon: {
+            // save our current weapon
+            int weapon = player.EquippedWeapon;
+
+            // equip new weapon
+            player.EquippedWeapon = removedItem.ItemId;
+
+            // replace the removed item with the old weapon
+            removedItem.ItemId = weapon;
+            break;
+        }
+
+        case ItemTypes::Armor: {
+            // save our current armor
+            int armor = player.EquippedArmor;
+
+            // equip new weapon
+            player.EquippedArmor = removedItem.ItemId;
+
+            // replace the removed item with the old weapon
+            removedItem.ItemId = armor;
+            break;
+        }
+
+        default: break;
+    }
+
+    // put whatever we have back, or drop it
+    if (removedItem.ItemId != -1) {
+        // stick it back in our bag
+        if (!player.PickupItem(removedItem)) {
+            // no room, drop it
+            PlaceItemDrop(removedItem, player.Position);
+        }
+    }
+}
+
+void World::DropItem(PlayerState &player, int slotIndex)
+{
+    TreasureInstance drop = player.RemoveInventoryItem(slotIndex, 999);
+    PlaceItemDrop(drop, player.Position);
+}
+
+void World::MoveTowardTarget(PlayerState &player, float deltaTime) const
+{
+    if (!player.TargetActive)
+        return;
+
+    Vec2 movement = Subtract(player.Target, player.Position);
+    float distance = Length(movement);
+
+    float frameSpeed = deltaTime * player.Speed;
+
+    if (distance <= frameSpeed) {
+        player.Position = player.Target;
+        player.TargetActive = false;
+    }
+    else {
+        movement = Normalize(movement);
+        Vec2 newPos = Add(player.Position, Scale(movement, frameSpeed));
+
+        if (!GetCollision().PointInMap(newPos)) {
+            player.TargetActive = false;
+        }
+        else {
+            player.Position = newPos;
+        }
+    }
+}
+
+void World::MovePlayer(PlayerState &player)
+{
+    MoveTowardTarget(player, TickDeltaTime);
+
+    // see if the player entered an exit
+    for (size_t i = 0; i < Exits.size(); i++) {
+        const Exit &exit = Exits[i];
+        if (!PointInRect(player.Position, exit.Bounds))
+            continue;
+
+        player.Waiting = true;
+        player.TargetChest = -1;
+
+        bool everyoneWaiting = std::all_of(Players.begin(), Players.end(),
+                                           [](const PlayerState *other) { return other->Waiting; });
+        if (everyoneWaiting) {
+            if (exit.Destination == "endgame")
+                AddEvent(EventType::GameWon, player.Id, player.Gold + 100, player.Position);
+            else
+                AddEvent(EventType::LevelExit, player.Id, int(i), player.Position);
+        }
+        break;
+    }
+}
+
+void World::DropLoot(const char *contents, const Vec2 &dropPoint)
+{
+    std::vector<TreasureInstance> loot = GetLoot(contents, Rng);
+    for (TreasureInstance &item : loot)
+        PlaceItemDrop(item, dropPoint, true);
+}
+
+void World::ApplyAction(PlayerState &player)
+{
+    // see if we want to attack any mobs
+    int targetMob = Mobs.FindIndex(player.TargetMob);
+    if (targetMob < 0)
+        player.TargetMob = NoMob;
+
+    if (targetMob >= 0) {
+        // see if we can even attack.
+        if (GetGameTime() - player.LastAttack >= player.GetAttack().Cooldown) {
+            Vec2 mobPosition = Mobs.GetPosition(targetMob);
+            float distance = Distance(mobPosition, player.Position);
+            if (distance < player.GetAttack().Range + 40) {
+                MOB *monsterInfo = GetMob(Mobs.MobIds[targetMob]);
+                if (monsterInfo != nullptr) {
+                    int damage = ResolveAttack(player.GetAttack(), monsterInfo->Defense.Defense, Rng);
+
+                    AddEvent(EventType::PlayerAttacked, player.Id, damage, mobPosition, player.Position,
+                             player.GetAttack().Melee ? EventFlagMelee : 0);
+
+                    if (damage > 0) {
+                        Mobs.Health[targetMob] -= damage;
+
+                        // if you hit them, they wake up!
+                        Mobs.Triggered[targetMob] = 1;
+                    }
+                }
+            }
+
+            player.TargetMob = NoMob;
+        }
+    }
+
+    // see if the player is near the last clicked chest, if so open it
+    if (player.TargetChest >= 0 && player.TargetChest < int(Chests.size())) {
+        Chest &chest = Chests[player.TargetChest];
+        Vec2 center = RectCenter(chest.Bounds);
+        float distance = Distance(center, player.Position);
+        if (distance <= 50) {
+            if (!chest.Opened) {
+                chest.Opened = true;
+                AddEvent(EventType::ChestOpened, player.Id, player.TargetChest, center);
+
+                DropLoot(chest.Contents.c_str(), center);
+            }
+            player.TargetChest = -1;
+        }
+    }
+
+    // see if we are under any items to pickup
+    for (auto drop = ItemDrops.begin(); drop != ItemDrops.end();) {
+        float distance = Distance(drop->Position, player.Position);
+        if (distance <= PickupDistance) {
+            int itemId = drop->Item.ItemId;
+            int quantity = drop->Item.Quantity;
+            bool taken = player.PickupItem(drop->Item);
+
+            if (itemId == GoldBagItem)
+                AddEvent(EventType::GoldPickedUp, player.Id, quantity, drop->Position);
+            else if (drop->Item.Quantity != quantity && GetItem(itemId) != nullptr)
+                AddEvent(EventType::ItemPickedUp, player.Id, itemId, drop->Position);
+
+            if (taken) {
+                drop = ItemDrops.erase(drop);
+                continue;
+            }
+        }
+
+        drop++;
+    }
+
+    float time = GetGameTime();
+
+    float attackTime = time - player.LastAttack;
+    float itemTime = time - player.LastConsumeable;
+
+    if (attackTime >= player.GetAttack().Cooldown)
+        player.AttackCooldown = 0;
+    else
+        player.AttackCooldown = 1.0f - (attackTime / player.AttackCooldown);
+
+    float itemCooldown = 1;
+
+    if (itemTime >= itemCooldown)
+        player.ItemCooldown = 0;
+    else
+        player.ItemCooldown = 1.0f - (itemTime / itemCooldown);
+
+    if (player.BuffLifetimeLeft > 0) {
+        player.BuffLifetimeLeft -= TickDeltaTime;
+        if (player.BuffLifetimeLeft <= 0) {
+            player.BuffDefense = 0;
+            player.BuffItem = -1;
+            player.BuffLifetimeLeft = 0;
+        }
+    }
+}
+
+}
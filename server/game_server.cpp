@@ -0,0 +1,507 @@
+#include "game_server.h"
+
+#include <algorithm>
+#include <utility>
+
+// the end of the game reaches everyone and whoever caused an event always hears about it, anything else only goes
+// to players who can see where it happened
+static bool EventReachesPlayer(const sim::Event &event, net::PlayerId playerId, const sim::Rect &area)
+{
+    switch (event.Type) {
+        case sim::EventType::GameWon:
+        case sim::EventType::GameLost:
+        case sim::EventType::LevelExit: return true;
+
+        // the id is the mob or the drop, not a player
+        case sim::EventType::MobAwoke:
+        case sim::EventType::MobDied:
+        case sim::EventType::LootDropped: return sim::PointInRect(event.Position, area);
+
+        // seen from either end, a shot from off screen still lands on screen
+        case sim::EventType::PlayerAttacked:
+        case sim::EventType::MobAttacked:
+        case sim::EventType::SpellCast:
+            return event.Id == playerId || sim::PointInRect(event.Position, area)
+                || sim::PointInRect(event.Target, area);
+
+        default: return event.Id == playerId || sim::PointInRect(event.Position, area);
+    }
+}
+
+GameServer::GameServer(SessionLink &link, LevelCache &levels)
+    : Link(link), Levels(levels)
+{
+    // one of each for every slot, not for every id the server could hand out
+    Players.resize(Link.GetMaxPlayers());
+    Moves.resize(Players.size());
+    Replication.resize(Players.size());
+
+    Link.OnConnect = [this](net::PlayerId playerId) { OnConnect(playerId); };
+    Link.OnDisconnect = [this](net::PlayerId playerId) { OnDisconnect(playerId); };
+    Link.OnMessage = [this](net::PlayerId playerId, const Serialize::Message *message)
+    { OnMessage(playerId, message); };
+}
+
+bool GameServer::LoadLevel(const std::string &level)
+{
+    // shared with every other session on the same level, the world only reads it
+    auto loaded = Levels.Get(level);
+    if (loaded == nullptr)
+        return false;
+
+    spdlog::info("Starting level {}", level);
+    LevelName = level;
+    World.SetLevel(std::move(loaded));
+    World.StartLevel();
+    ResetReplication();
+
+    // moves made on the old level would walk the players off from the new spawn
+    for (PlayerMoves &moves : Moves)
+        moves.Queue.clear();
+
+    // tell everyone to load it too
+    SendLevel();
+    return true;
+}
+
+void GameServer::RestartGame()
+{
+    for (sim::PlayerState *player : World.Players) {
+        sim::PlayerId id = player->Id;
+        *player = sim::PlayerState(id);
+    }
+
+    LoadLevel(FirstLevel);
+}
+
+void GameServer::Update(float deltaTime)
+{
+    // everything that arrived since the last tick is applied before the world moves, nothing waits on the network
+    Link.Poll();
+    Tick(deltaTime);
+
+    // everything the tick queued leaves together, one packet per player and channel
+    Link.Flush();
+}
+
+void GameServer::Tick(float deltaTime)
+{
+    // nobody to play for or nothing to play on, the world waits
+    if (World.Players.empty() || World.GetLevel() == nullptr)
+        return;
+
+    ApplyMoves();
+    World.Tick(deltaTime);
+
+    SendState();
+    if (!World.Events.empty())
+        SendEvents();
+
+    HandleWorldEvents();
+    World.Events.clear();
+}
+
+void GameServer::HandleWorldEvents()
+{
+    for (const sim::Event &event : World.Events) {
+        switch (event.Type) {
+            case sim::EventType::LevelExit:
+                if (event.Value >= 0 && event.Value < int(World.Exits.size())) {
+                    // copied, loading the level replaces the exits
+                    std::string destination = "maps/" + World.Exits[event.Value].Destination;
+                    LoadLevel(destination);
+                }
+                return;
+
+            case sim::EventType::GameWon:
+            case sim::EventType::GameLost:
+                spdlog::info("Game over, starting again");
+                RestartGame();
+                return;
+
+            default: break;
+        }
+    }
+}
+
+void GameServer::OnConnect(net::PlayerId playerId)
+{
+    uint32_t slot = Link.GetSlot(playerId);
+    Players[slot] = std::make_unique<sim::PlayerState>(playerId);
+    sim::PlayerState &player = *Players[slot];
+
+    // the first player in starts a fresh game, if the level couldn't be loaded the next one to join tries again
+    if (World.Players.empty() || World.GetLevel() == nullptr) {
+        World.AddPlayer(player);
+        if (!LoadLevel(FirstLevel))
+            spdlog::warn("Player {} waits for a level that could not be loaded", playerId);
+        return;
+    }
+
+    World.AddPlayer(player);
+
+    const sim::Level *level = World.GetLevel();
+    const sim::MapObject *spawn = level ? level->Map.GetFirstObjectOfType(sim::PlayerSpawnType) : nullptr;
+    if (spawn != nullptr)
+        player.Position = sim::Vec2{spawn->Bounds.x, spawn->Bounds.y};
+
+    // everyone else already has the level loaded
+    SendLevel(playerId);
+}
+
+void GameServer::OnDisconnect(net::PlayerId playerId)
+{
+    uint32_t slot = Link.GetSlot(playerId);
+    World.RemovePlayer(playerId);
+    Players[slot].reset();
+    Moves[slot].Clear();
+    Replication[slot].Clear();
+}
+
+void GameServer::OnMessage(net::PlayerId playerId, const Serialize::Message *message)
+{
+    uint32_t slot = Link.GetSlot(playerId);
+    sim::PlayerState *player = Players[slot].get();
+    if (player == nullptr)
+        return;
+
+    switch (message->content_type()) {
+        case Serialize::Content_Move: QueueMoves(slot, message->content_as_Move());
+            break;
+
+        case Serialize::Content_Input: ApplyInput(*player, message->content_as_Input());
+            break;
+
+        case Serialize::Content_Ack: {
+            // acks are unreliable and may come out of order, only a newer one moves the baseline
+            PlayerReplication &replication = Replication[slot];
+            uint32_t tick = message->content_as_Ack()->tick();
+            if (tick > replication.AckedTick && replication.Snapshots.Find(tick) != nullptr)
+                replication.AckedTick = tick;
+            break;
+        }
+
+        default: break;
+    }
+}
+
+void GameServer::ApplyInput(sim::PlayerState &player, const Serialize::Input *input)
+{
+    if (input->activate_slot() >= 0)
+        World.ActivateItem(player, input->activate_slot());
+
+    if (input->drop_slot() >= 0)
+        World.DropItem(player, input->drop_slot());
+}
+
+void PlayerMoves::Clear()
+{
+    Queue.clear();
+    Received = 0;
+    Applied = 0;
+}
+
+void GameServer::QueueMoves(uint32_t slot, const Serialize::Move *move)
+{
+    if (move->steps() == nullptr)
+        return;
+
+    PlayerMoves &moves = Moves[slot];
+
+    // every packet repeats the last few moves, only the ones after the newest we have are new
+    for (const Serialize::MoveStep *step : *move->steps()) {
+        if (step->sequence() <= moves.Received)
+            continue;
+
+        moves.Received = step->sequence();
+        moves.Queue.push_back(*step);
+    }
+
+    // the client predicted these, the next state tells it they were dropped and it takes the correction
+    while (moves.Queue.size() > MaxQueuedMoves) {
+        moves.Applied = moves.Queue.front().sequence();
+        moves.Queue.pop_front();
+    }
+}
+
+void GameServer::ApplyMoves()
+{
+    for (sim::PlayerState *player : World.Players) {
+        PlayerMoves &moves = Moves[Link.GetSlot(player->Id)];
+
+        // nothing came in time, the player keeps walking where it was headed and the late move is applied next tick
+        if (moves.Queue.empty())
+            continue;
+
+        const Serialize::MoveStep &step = moves.Queue.front();
+        if ((step.flags() & net::MOVE_FLAG_TARGET) != 0)
+            World.SetMoveTarget(*player, sim::Vec2{step.x(), step.y()});
+
+        moves.Applied = step.sequence();
+        moves.Queue.pop_front();
+    }
+}
+
+void GameServer::BuildInterestGrid()
+{
+    EntityGrid.Clear();
+
+    for (size_t i = 0; i < World.Players.size(); i++) {
+        const sim::PlayerState *player = World.Players[i];
+        EntityGrid.Insert(InterestEntity{net::ENTITY_KIND_PLAYER, player->Id, uint32_t(i), player->Position});
+    }
+
+    const sim::MobStore &mobs = World.Mobs;
+    for (size_t i = 0; i < mobs.Size(); i++)
+        EntityGrid.Insert(InterestEntity{net::ENTITY_KIND_MOB, mobs.InstanceIds[i], uint32_t(i), mobs.GetPosition(i)});
+
+    for (size_t i = 0; i < World.ItemDrops.size(); i++) {
+        const sim::ItemDrop &drop = World.ItemDrops[i];
+        EntityGrid.Insert(InterestEntity{net::ENTITY_KIND_DROP, drop.Id, uint32_t(i), drop.Position});
+    }
+}
+
+void GameServer::UpdateInterest(net::PlayerId playerId, uint32_t slot, const sim::PlayerState &player)
+{
+    sim::Rect enterArea = {player.Position.x - net::VIEW_RANGE_X - InterestMargin,
+                           player.Position.y - net::VIEW_RANGE_Y - InterestMargin,
+                           (net::VIEW_RANGE_X + InterestMargin) * 2,
+                           (net::VIEW_RANGE_Y + InterestMargin) * 2};
+
+    sim::Rect stayArea = {enterArea.x - InterestMargin,
+                          enterArea.y - InterestMargin,
+                          enterArea.width + InterestMargin * 2,
+                          enterArea.height + InterestMargin * 2};
+
+    Visible.clear();
+    EntityGrid.Query(stayArea, Visible);
+    Replication[slot].Interest.Update(Visible, enterArea, Entered, Left);
+    Replication[slot].ViewArea = stayArea;
+
+    if (!Entered.empty() || !Left.empty())
+        SendInterest(playerId);
+}
+
+void GameServer::SendInterest(net::PlayerId playerId)
+{
+    EnteredRefs.clear();
+    LeftRefs.clear();
+
+    // what came in carries enough to put a sprite up before the next state arrives
+    for (const InterestEntity &entity : Entered) {
+        int type = 0;
+        switch (entity.Kind) {
+            case net::ENTITY_KIND_PLAYER: type = World.Players[entity.Index]->EquippedArmor;
+                break;
+
+            case net::ENTITY_KIND_MOB: type = World.Mobs.MobIds[entity.Index];
+                break;
+
+            case net::ENTITY_KIND_DROP: type = World.ItemDrops[entity.Index].Item.ItemId;
+                break;
+
+            default: break;
+        }
+
+        EnteredRefs.emplace_back(entity.Kind, entity.Id, type, entity.Position.x, entity.Position.y);
+    }
+
+    for (const InterestEntity &entity : Left)
+        LeftRefs.emplace_back(entity.Kind, entity.Id, 0, 0.0f, 0.0f);
+
+    net::BuilderPool::Lease builder = net::GetBuilderPool().Acquire();
+    auto content = Serialize::CreateInterestDirect(*builder, World.TickCount, &EnteredRefs, &LeftRefs);
+    net::FinishMessage(*builder, 0, Serialize::Content_Interest, content.Union());
+
+    // reliable like the level change, so a client never hears about something from a level it hasn't loaded
+    Link.Queue(playerId, Serialize::Content_Interest, *builder);
+}
+
+void PlayerReplication::Clear()
+{
+    Interest.Clear();
+    ViewArea = sim::Rect{0, 0, 0, 0};
+    Snapshots.Clear();
+    AckedTick = 0;
+}
+
+void GameServer::ResetReplication()
+{
+    // the clients drop every sprite and state when they load a level, everything goes out again on the next tick
+    for (PlayerReplication &replication : Replication)
+        replication.Clear();
+
+    const sim::Level *level = World.GetLevel();
+    if (level != nullptr)
+        EntityGrid.Build(level->Map.Bounds, InterestCellSize);
+}
+
+void GameServer::SendState()
+{
+    BuildInterestGrid();
+
+    for (net::PlayerId playerId : Link.GetPlayers()) {
+        uint32_t slot = Link.GetSlot(playerId);
+        const sim::PlayerState *player = Players[slot].get();
+        if (player == nullptr)
+            continue;
+
+        UpdateInterest(playerId, slot, *player);
+        SendState(playerId, slot);
+    }
+}
+
+void GameServer::SendState(net::PlayerId playerId, uint32_t slot)
+{
+    PlayerReplication &replication = Replication[slot];
+
+    net::Snapshot &snapshot = replication.Snapshots.Add(World.TickCount);
+    BuildSnapshot(replication.Interest, snapshot);
+    snapshot.MoveAck = Moves[slot].Applied;
+
+    // nullptr once the acked state is too old to still be in the history, then everything goes out again
+    const net::Snapshot *baseline = replication.Snapshots.Find(replication.AckedTick);
+
+    net::BuilderPool::Lease builder = net::GetBuilderPool().Acquire();
+    auto content = StateWriter.Write(*builder, snapshot, baseline);
+    net::FinishMessage(*builder, 0, Serialize::Content_WorldState, content.Union());
+
+    // a lost state doesn't matter, the next tick sends a newer one
+    Link.Queue(playerId, Serialize::Content_WorldState, *builder);
+}
+
+void GameServer::BuildSnapshot(const InterestSet &interest, net::Snapshot &snapshot) const
+{
+    // positions are quantized to the level, without one there is nothing to send
+    const sim::Level *level = World.GetLevel();
+    if (level == nullptr)
+        return;
+
+    const sim::Rect &bounds = level->Map.Bounds;
+    const sim::MobStore &mobs = World.Mobs;
+
+    // only what the player knows about, sorted like the snapshot wants, the indexes were all refreshed this tick
+    for (const InterestEntity &entity : interest.GetKnown()) {
+        size_t i = entity.Index;
+        switch (entity.Kind) {
+            case net::ENTITY_KIND_PLAYER: AddPlayerSnapshot(*World.Players[i], snapshot);
+                break;
+
+            case net::ENTITY_KIND_MOB:
+                snapshot.Mobs.emplace_back(mobs.InstanceIds[i],
+                                           net::QuantizeCoordinate(mobs.PositionX[i], bounds.x, bounds.width),
+                                           net::QuantizeCoordinate(mobs.PositionY[i], bounds.y, bounds.height),
+                                           int16_t(mobs.Health[i]),
+                                           uint8_t(mobs.MobIds[i]),
+                                           uint8_t(mobs.Triggered[i] ? 1 : 0));
+                break;
+
+            case net::ENTITY_KIND_DROP: {
+                const sim::ItemDrop &drop = World.ItemDrops[i];
+                snapshot.Drops.emplace_back(drop.Id,
+                                            net::QuantizeCoordinate(drop.Position.x, bounds.x, bounds.width),
+                                            net::QuantizeCoordinate(drop.Position.y, bounds.y, bounds.height),
+                                            int16_t(drop.Item.ItemId),
+                                            int16_t(drop.Item.Quantity));
+                break;
+            }
+
+            default: break;
+        }
+    }
+
+    // chests are few and everyone can hear one open, so all of them go to everyone
+    snapshot.Chests.resize(World.Chests.size());
+    for (size_t i = 0; i < World.Chests.size(); i++)
+        snapshot.Chests[i] = World.Chests[i].Opened ? 1 : 0;
+}
+
+void GameServer::AddPlayerSnapshot(const sim::PlayerState &player, net::Snapshot &snapshot) const
+{
+    const sim::Level *level = World.GetLevel();
+    if (level == nullptr)
+        return;
+
+    const sim::Rect &bounds = level->Map.Bounds;
+
+    uint16_t flags = 0;
+    if (player.TargetActive)
+        flags |= net::PLAYER_FLAG_TARGET_ACTIVE;
+    if (player.Waiting)
+        flags |= net::PLAYER_FLAG_WAITING;
+
+    snapshot.Players.emplace_back(player.Id,
+                                  flags,
+                                  net::QuantizeCoordinate(player.Position.x, bounds.x, bounds.width),
+                                  net::QuantizeCoordinate(player.Position.y, bounds.y, bounds.height),
+                                  net::QuantizeCoordinate(player.Target.x, bounds.x, bounds.width),
+                                  net::QuantizeCoordinate(player.Target.y, bounds.y, bounds.height),
+                                  int16_t(player.Health),
+                                  int16_t(player.EquippedWeapon),
+                                  int16_t(player.EquippedArmor),
+                                  int16_t(player.BuffItem),
+                                  int16_t(player.BuffDefense),
+                                  net::QuantizeTime(player.BuffLifetimeLeft),
+                                  net::QuantizeTime(player.AttackCooldown),
+                                  net::QuantizeTime(player.ItemCooldown),
+                                  player.Gold);
+
+    for (const sim::InventoryContents &contents : player.BackpackContents)
+        snapshot.Inventory.emplace_back(player.Id, contents.ItemId, contents.Quantity);
+}
+
+bool GameServer::BuildEvents(flatbuffers::FlatBufferBuilder &builder, const char *level, net::PlayerId playerId)
+{
+    GameEvents.clear();
+
+    // a level change goes out on its own, the events before it belong to the old level
+    if (level == nullptr) {
+        const sim::Rect &area = Replication[Link.GetSlot(playerId)].ViewArea;
+        for (const sim::Event &event : World.Events) {
+            if (!EventReachesPlayer(event, playerId, area))
+                continue;
+
+            GameEvents.emplace_back(uint32_t(event.Type),
+                                    uint32_t(event.Flags),
+                                    event.Id,
+                                    event.Value,
+                                    event.Position.x,
+                                    event.Position.y,
+                                    event.Target.x,
+                                    event.Target.y);
+        }
+
+        if (GameEvents.empty())
+            return false;
+    }
+
+    auto content = Serialize::CreateWorldEventsDirect(builder, World.TickCount, level, &GameEvents);
+    net::FinishMessage(builder, 0, Serialize::Content_WorldEvents, content.Union());
+    return true;
+}
+
+void GameServer::SendEvents()
+{
+    net::BuilderPool::Lease builder = net::GetBuilderPool().Acquire();
+
+    for (net::PlayerId playerId : Link.GetPlayers()) {
+        if (Players[Link.GetSlot(playerId)] == nullptr)
+            continue;
+
+        builder->Clear();
+        if (BuildEvents(*builder, nullptr, playerId))
+            Link.Queue(playerId, Serialize::Content_WorldEvents, *builder);
+    }
+}
+
+void GameServer::SendLevel(net::PlayerId playerId)
+{
+    net::BuilderPool::Lease builder = net::GetBuilderPool().Acquire();
+    BuildEvents(*builder, LevelName.c_str(), playerId);
+
+    // queued behind whatever this tick already queued, so interest from the old level always arrives first
+    if (playerId == net::NO_PLAYER)
+        Link.Queue(Link.GetPlayers(), Serialize::Content_WorldEvents, *builder);
+    else
+        Link.Queue(playerId, Serialize::Content_WorldEvents, *builder);
+}
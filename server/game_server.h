@@ -0,0 +1,120 @@
+#pragma once
+
+#include "interest.h"
+#include "level_cache.h"
+#include "net.h"
+#include "session_link.h"
+#include "snapshot.h"
+#include "world.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr float ServerTickRate = net::SERVER_TICK_RATE;
+
+constexpr char FirstLevel[] = "maps/level0.tmx";
+
+// a player may get this many moves ahead of the server before the oldest are dropped,
+// enough to ride out a burst of jitter without the queue turning into lag
+constexpr size_t MaxQueuedMoves = 8;
+
+// the moves a player sent that no tick has applied yet, one is applied per tick like the client made them
+struct PlayerMoves
+{
+    std::deque<Serialize::MoveStep> Queue;
+
+    // the newest move that was queued and the newest that was applied or dropped
+    uint32_t Received = 0;
+    uint32_t Applied = 0;
+
+    void Clear();
+};
+
+// what one player has been sent, so the next state only has to carry what changed
+struct PlayerReplication
+{
+    InterestSet Interest;
+
+    // how far around the player it hears about anything this tick, events outside it aren't sent
+    sim::Rect ViewArea = {0, 0, 0, 0};
+
+    net::SnapshotHistory Snapshots{net::SERVER_SNAPSHOT_HISTORY};
+
+    // the newest state the player said it has, 0 until it acks one on this level
+    uint32_t AckedTick = 0;
+
+    void Clear();
+};
+
+// runs the authoritative world for one session's players, clients only send inputs and draw what it sends back.
+// a session is only ever touched by the worker that owns it
+class GameServer
+{
+public:
+    GameServer(SessionLink &link, LevelCache &levels);
+
+    bool LoadLevel(const std::string &level);
+
+    // handles what arrived since the last tick, ticks the world and hands what it sends to the network thread
+    void Update(float deltaTime);
+    void Tick(float deltaTime);
+
+private:
+    void OnConnect(net::PlayerId playerId);
+    void OnDisconnect(net::PlayerId playerId);
+    void OnMessage(net::PlayerId playerId, const Serialize::Message *message);
+    void ApplyInput(sim::PlayerState &player, const Serialize::Input *input);
+    void QueueMoves(uint32_t slot, const Serialize::Move *move);
+    void ApplyMoves();
+
+    // level changes and the end of the game, after the events that caused them went out
+    void HandleWorldEvents();
+    void RestartGame();
+
+    // every player only hears about what is near enough for their camera to show
+    void BuildInterestGrid();
+    void UpdateInterest(net::PlayerId playerId, uint32_t slot, const sim::PlayerState &player);
+    void SendInterest(net::PlayerId playerId);
+    void ResetReplication();
+
+    void SendState();
+    void SendState(net::PlayerId playerId, uint32_t slot);
+    void BuildSnapshot(const InterestSet &interest, net::Snapshot &snapshot) const;
+    void AddPlayerSnapshot(const sim::PlayerState &player, net::Snapshot &snapshot) const;
+    // every player gets the tick's events they can see or caused, after SendState worked out what they can see
+    void SendEvents();
+
+    // tells one player, or everyone when the id is NO_PLAYER, to start the current level
+    void SendLevel(net::PlayerId playerId = net::NO_PLAYER);
+
+    // a level change, or this tick's events for one player. false when none of the events reach the player
+    bool BuildEvents(flatbuffers::FlatBufferBuilder &builder, const char *level, net::PlayerId playerId);
+
+    SessionLink &Link;
+    LevelCache &Levels;
+    std::string LevelName;
+
+    sim::World World;
+
+    // indexed by the slot each player holds in the session, the world holds pointers so they must not move
+    std::vector<std::unique_ptr<sim::PlayerState>> Players;
+
+    // indexed by slot, the moves each player is waiting on
+    std::vector<PlayerMoves> Moves;
+
+    InterestGrid EntityGrid;
+
+    // indexed by slot, what each player has been told is around them
+    std::vector<PlayerReplication> Replication;
+    std::vector<InterestEntity> Visible;
+    std::vector<InterestEntity> Entered;
+    std::vector<InterestEntity> Left;
+
+    // reused every tick so building a message doesn't allocate once they have grown
+    net::SnapshotWriter StateWriter;
+    std::vector<Serialize::GameEvent> GameEvents;
+    std::vector<Serialize::EntityRef> EnteredRefs;
+    std::vector<Serialize::EntityRef> LeftRefs;
+};
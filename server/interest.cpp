@@ -0,0 +1,100 @@
+#include "interest.h"
+
+#include <math.h>
+#include <algorithm>
+
+void InterestGrid::Build(const sim::Rect &bounds, float cellSize)
+{
+    Bounds = bounds;
+    CellSize = cellSize > 0 ? cellSize : 1;
+    CellsX = std::max(1, int(ceilf(bounds.width / CellSize)));
+    CellsY = std::max(1, int(ceilf(bounds.height / CellSize)));
+
+    Cells.clear();
+    Cells.resize(size_t(CellsX) * CellsY);
+}
+
+void InterestGrid::Clear()
+{
+    for (auto &cell : Cells)
+        cell.clear();
+}
+
+int InterestGrid::GetCellX(float x) const
+{
+    // anything off the map is kept in the edge cells, it still has to be seen by someone standing near it
+    return std::clamp(int(floorf((x - Bounds.x) / CellSize)), 0, CellsX - 1);
+}
+
+int InterestGrid::GetCellY(float y) const
+{
+    return std::clamp(int(floorf((y - Bounds.y) / CellSize)), 0, CellsY - 1);
+}
+
+void InterestGrid::Insert(const InterestEntity &entity)
+{
+    if (Cells.empty())
+        return;
+
+    Cells[size_t(GetCellY(entity.Position.y)) * CellsX + GetCellX(entity.Position.x)].push_back(entity);
+}
+
+void InterestGrid::Query(const sim::Rect &area, std::vector<InterestEntity> &result) const
+{
+    if (Cells.empty())
+        return;
+
+    int minX = GetCellX(area.x);
+    int maxX = GetCellX(area.x + area.width);
+    int minY = GetCellY(area.y);
+    int maxY = GetCellY(area.y + area.height);
+
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            for (const InterestEntity &entity : Cells[size_t(y) * CellsX + x]) {
+                if (sim::PointInRect(entity.Position, area))
+                    result.push_back(entity);
+            }
+        }
+    }
+}
+
+void InterestSet::Update(std::vector<InterestEntity> &visible,
+                         const sim::Rect &enterArea,
+                         std::vector<InterestEntity> &entered,
+                         std::vector<InterestEntity> &left)
+{
+    std::sort(visible.begin(), visible.end(), [](const InterestEntity &a, const InterestEntity &b)
+    { return a.GetKey() < b.GetKey(); });
+
+    entered.clear();
+    left.clear();
+    Next.clear();
+
+    // both lists are sorted, so one pass over them finds what came and went
+    size_t known = 0;
+    size_t seen = 0;
+    while (known < Known.size() || seen < visible.size()) {
+        if (seen == visible.size() || (known < Known.size() && Known[known].GetKey() < visible[seen].GetKey())) {
+            left.push_back(Known[known++]);
+            continue;
+        }
+
+        const InterestEntity &entity = visible[seen++];
+        if (known < Known.size() && Known[known].GetKey() == entity.GetKey()) {
+            Next.push_back(entity);
+            known++;
+        }
+        else if (sim::PointInRect(entity.Position, enterArea)) {
+            Next.push_back(entity);
+            entered.push_back(entity);
+        }
+    }
+
+    Known.swap(Next);
+}
+
+void InterestSet::Clear()
+{
+    Known.clear();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "sim_math.h"
+
+#include <stdint.h>
+#include <vector>
+
+// how big the cells of the interest grid are, a player's view covers a few dozen of them
+constexpr float InterestCellSize = 256;
+
+// things come into view this far outside what the camera can show, so they are there before they scroll in,
+// and only go out of view once they are twice as far, so nothing flickers in and out at the edge
+constexpr float InterestMargin = 128;
+
+// one thing the server replicates, as the interest grid sees it this tick
+struct InterestEntity
+{
+    uint32_t Kind = 0;
+    uint32_t Id = 0;
+
+    // where the entity is in its world container this tick, so snapshots don't have to search for it
+    uint32_t Index = 0;
+
+    sim::Vec2 Position = {0, 0};
+
+    uint64_t GetKey() const { return (uint64_t(Kind) << 32) | Id; }
+};
+
+// buckets entities by the map cell they stand in, so a view only has to look at the cells it covers
+class InterestGrid
+{
+public:
+    void Build(const sim::Rect &bounds, float cellSize);
+
+    // empties every cell, the layout stays for the next tick
+    void Clear();
+    void Insert(const InterestEntity &entity);
+
+    // appends every entity inside the area
+    void Query(const sim::Rect &area, std::vector<InterestEntity> &result) const;
+
+private:
+    int GetCellX(float x) const;
+    int GetCellY(float y) const;
+
+    sim::Rect Bounds = {0, 0, 0, 0};
+    float CellSize = 1;
+    int CellsX = 0;
+    int CellsY = 0;
+
+    std::vector<std::vector<InterestEntity>> Cells;
+};
+
+// what one player has been told about, so only the changes have to go out as enter and leave notifications
+class InterestSet
+{
+public:
+    // visible is everything in range this tick and is sorted in place, something new only enters once it is inside
+    // enterArea, something already known stays for as long as it is visible at all
+    void Update(std::vector<InterestEntity> &visible,
+                const sim::Rect &enterArea,
+                std::vector<InterestEntity> &entered,
+                std::vector<InterestEntity> &left);
+
+    // everything the player knows about, sorted by kind then id
+    const std::vector<InterestEntity> &GetKnown() const { return Known; }
+
+    void Clear();
+
+private:
+    std::vector<InterestEntity> Known;
+    std::vector<InterestEntity> Next;
+};
@@ -0,0 +1,38 @@
+#include "level_cache.h"
+
+#include "spdlog/spdlog.h"
+
+#include <utility>
+
+LevelCache::LevelCache(std::string resourceDir)
+    : ResourceDir(std::move(resourceDir))
+{
+}
+
+std::shared_ptr<const sim::Level> LevelCache::Get(const std::string &level)
+{
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (std::shared_ptr<const sim::Level> loaded = Levels[level].lock())
+            return loaded;
+    }
+
+    // other workers keep ticking while this one reads the map
+    std::string path = ResourceDir + "/" + level;
+    std::shared_ptr<const sim::Level> loaded = sim::LoadLevel(path.c_str());
+    if (loaded == nullptr) {
+        spdlog::error("Failed to load level {}", path);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    // two sessions asked at once, whoever got in first wins and the other copy goes again
+    std::weak_ptr<const sim::Level> &entry = Levels[level];
+    if (std::shared_ptr<const sim::Level> raced = entry.lock())
+        return raced;
+
+    spdlog::debug("Loaded level {}", level);
+    entry = loaded;
+    return loaded;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "map_collision.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// every level loaded once no matter how many sessions play it, nothing changes a level after it is built so
+// sessions on different workers read the same one. a level goes when the last session playing it moves on
+class LevelCache
+{
+public:
+    explicit LevelCache(std::string resourceDir);
+
+    // the level at a path under the resource folder, loaded if no session is playing it, nullptr if it can't be
+    std::shared_ptr<const sim::Level> Get(const std::string &level);
+
+private:
+    std::string ResourceDir;
+
+    // only held to look a level up or put one in, never while one loads
+    std::mutex Mutex;
+    std::unordered_map<std::string, std::weak_ptr<const sim::Level>> Levels;
+};
@@ -1,10 +1,118 @@
 #include "net.h"
+#include "game_server.h"
+#include "level_cache.h"
+#include "network_thread.h"
+#include "simulation_worker.h"
 
-int main()
+#include "items.h"
+#include "monsters.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <string>
+#include <thread>
+
+// how many players play in one world, more connections open more sessions
+constexpr uint32_t DefaultSessionPlayers = 4;
+
+namespace
+{
+std::atomic<bool> StopRequested{false};
+
+// leave the tick loops so the server can disconnect everyone on the way out
+void StopServer(int)
+{
+    StopRequested = true;
+}
+
+// a count from the command line, only a whole number above zero is one
+bool ParseCount(const char *text, uint32_t &count)
+{
+    char *end = nullptr;
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (text[0] == '-' || end == text || *end != '\0' || errno == ERANGE || value == 0 || value > UINT32_MAX)
+        return false;
+
+    count = uint32_t(value);
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
 {
     spdlog::set_level(spdlog::level::debug);
 
+    // maps are read from the same resource folder the client uses
+    std::string resourceDir = argc > 1 ? argv[1] : "_resources";
+    uint32_t maxPlayers = net::SERVER_MAX_CONNECTIONS;
+
+    // one core is left for the network thread, hardware_concurrency is 0 when it can't tell
+    uint32_t workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    uint32_t sessionPlayers = DefaultSessionPlayers;
+
+    if (argc > 5 || (argc > 2 && !ParseCount(argv[2], maxPlayers)) || (argc > 3 && !ParseCount(argv[3], workerCount))
+        || (argc > 4 && !ParseCount(argv[4], sessionPlayers))) {
+        spdlog::error("usage: {} [resource folder] [max players] [workers] [players per room]", argv[0]);
+        return 1;
+    }
+
+    // every room is set up before the host checks it, so too many players has to be caught here
+    if (maxPlayers > net::SERVER_PEER_LIMIT) {
+        spdlog::error("Can't serve {} players, the limit is {}", maxPlayers, net::SERVER_PEER_LIMIT);
+        return 1;
+    }
+
+    sessionPlayers = std::max(1u, std::min(sessionPlayers, maxPlayers));
+    uint32_t sessionCount = (maxPlayers + sessionPlayers - 1) / sessionPlayers;
+    workerCount = std::max(1u, std::min(workerCount, sessionCount));
+
+    SetupDefaultItems();
+    SetupDefaultMobs();
+
+    // declared before the host so they outlive it, packets still in flight hand their buffers back to the links
+    OutboundQueue outbound(OutboundCapacity);
+    std::vector<std::unique_ptr<SessionLink>> links;
+    std::vector<SessionLink *> sessions;
+    for (uint32_t i = 0; i < sessionCount; i++) {
+        links.push_back(std::make_unique<SessionLink>(sessionPlayers, outbound));
+        sessions.push_back(links.back().get());
+    }
+
     auto server = net::ENetServer::Create();
-    server->Start(8000);
-    server->Poll();
-}
\ No newline at end of file
+    if (server->Start(8000, maxPlayers) != 0)
+        return 1;
+
+    NetworkThread network(server, sessions, sessionPlayers, outbound);
+
+    // sessions on the same level all play the one copy of it
+    LevelCache levels(resourceDir);
+
+    // sessions are dealt out round robin, each one stays on its worker for good
+    std::vector<std::unique_ptr<SimulationWorker>> workers;
+    for (uint32_t i = 0; i < workerCount; i++)
+        workers.push_back(std::make_unique<SimulationWorker>(i));
+    for (uint32_t i = 0; i < sessionCount; i++)
+        workers[i % workerCount]->AddSession(std::make_unique<GameServer>(*links[i], levels));
+
+    spdlog::info("Serving {} players in {} rooms of {} on {} workers", maxPlayers, sessionCount, sessionPlayers,
+                 workerCount);
+
+    std::signal(SIGINT, StopServer);
+    std::signal(SIGTERM, StopServer);
+
+    network.Start();
+    for (const std::unique_ptr<SimulationWorker> &worker : workers)
+        worker->Start(ServerTickRate);
+
+    while (!StopRequested)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // the workers stop first so the network thread can send the last of what they queued
+    for (const std::unique_ptr<SimulationWorker> &worker : workers)
+        worker->Stop();
+    network.Stop();
+}
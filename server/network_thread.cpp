@@ -0,0 +1,150 @@
+#include "network_thread.h"
+
+#include <utility>
+
+NetworkThread::NetworkThread(std::shared_ptr<net::ENetServer> server,
+                             const std::vector<SessionLink *> &sessions,
+                             uint32_t sessionPlayers,
+                             OutboundQueue &outbound)
+    : Server(std::move(server)), Sessions(sessions), SessionPlayers(sessionPlayers), Outbound(outbound)
+{
+    SessionSizes.assign(Sessions.size(), 0);
+    Backlog.resize(Sessions.size());
+    PlayerSessions.assign(Server->GetMaxPlayers() + 1, NoSession);
+    Connections.assign(Server->GetMaxPlayers() + 1, 0);
+
+    Server->OnConnect = [this](net::PlayerId playerId) { OnConnect(playerId); };
+    Server->OnDisconnect = [this](net::PlayerId playerId) { OnDisconnect(playerId); };
+    Server->OnPacket = [this](net::PlayerId playerId, net::PacketPtr packet)
+    { OnPacket(playerId, std::move(packet)); };
+}
+
+NetworkThread::~NetworkThread()
+{
+    Stop();
+}
+
+void NetworkThread::Start()
+{
+    Running = true;
+    Thread = std::thread(&NetworkThread::Run, this);
+}
+
+void NetworkThread::Stop()
+{
+    Running = false;
+    if (Thread.joinable())
+        Thread.join();
+}
+
+void NetworkThread::Run()
+{
+    while (Running) {
+        Server->Poll(NetworkPollTimeout);
+        ForwardBacklog();
+        SendOutbound();
+    }
+
+    // the last ticks before the workers stopped
+    SendOutbound();
+}
+
+uint32_t NetworkThread::PickSession(net::RoomId room) const
+{
+    // a party asks for the same room so they end up in one world, room n is session n - 1
+    if (room != net::ANY_ROOM) {
+        uint32_t session = room - 1u;
+        if (session < Sessions.size() && SessionSizes[session] < SessionPlayers)
+            return session;
+
+        spdlog::warn("Room {} is full or doesn't exist, picking another", room);
+    }
+
+    // otherwise the emptiest session, so nobody waits on a busy one while another idles
+    uint32_t session = NoSession;
+    for (uint32_t i = 0; i < Sessions.size(); i++) {
+        if (SessionSizes[i] < SessionPlayers && (session == NoSession || SessionSizes[i] < SessionSizes[session]))
+            session = i;
+    }
+
+    return session;
+}
+
+void NetworkThread::OnConnect(net::PlayerId playerId)
+{
+    uint32_t session = PickSession(Server->GetRequestedRoom(playerId));
+
+    if (session == NoSession) {
+        spdlog::error("No session has room for player {}", playerId);
+        Server->Disconnect(playerId);
+        return;
+    }
+
+    SessionSizes[session]++;
+    PlayerSessions[playerId] = session;
+    Connections[playerId] = ++NextConnection;
+
+    spdlog::debug("Player {} joins room {}, {} players in it", playerId, session + 1, SessionSizes[session]);
+    Forward(session, InboundEvent{InboundEvent::Kind::Connect, playerId, Connections[playerId], nullptr});
+}
+
+void NetworkThread::OnDisconnect(net::PlayerId playerId)
+{
+    uint32_t session = PlayerSessions[playerId];
+    if (session == NoSession)
+        return;
+
+    SessionSizes[session]--;
+    PlayerSessions[playerId] = NoSession;
+    Forward(session, InboundEvent{InboundEvent::Kind::Disconnect, playerId, Connections[playerId], nullptr});
+}
+
+void NetworkThread::OnPacket(net::PlayerId playerId, net::PacketPtr packet)
+{
+    uint32_t session = PlayerSessions[playerId];
+    if (session == NoSession)
+        return;
+
+    Forward(session, InboundEvent{InboundEvent::Kind::Packet, playerId, Connections[playerId], std::move(packet)});
+}
+
+void NetworkThread::Forward(uint32_t session, InboundEvent &&event)
+{
+    // nothing may overtake what is already waiting, a connect has to arrive before that player's input
+    std::deque<InboundEvent> &backlog = Backlog[session];
+    if (backlog.empty() && Sessions[session]->Push(std::move(event)))
+        return;
+
+    if (backlog.empty())
+        spdlog::warn("Session {} is falling behind, holding on to its network events", session);
+
+    backlog.push_back(std::move(event));
+}
+
+void NetworkThread::ForwardBacklog()
+{
+    for (uint32_t session = 0; session < Sessions.size(); session++) {
+        std::deque<InboundEvent> &backlog = Backlog[session];
+        while (!backlog.empty() && Sessions[session]->Push(std::move(backlog.front())))
+            backlog.pop_front();
+    }
+}
+
+void NetworkThread::SendOutbound()
+{
+    OutboundPacket outbound;
+    bool sent = false;
+    while (Outbound.Pop(outbound)) {
+        // the player left, or left and someone else got the id, since the session built it
+        if (!Server->IsConnected(outbound.Player) || Connections[outbound.Player] != outbound.Connection) {
+            outbound.Packet.reset();
+            continue;
+        }
+
+        Server->Send(outbound.Player, net::MessagePacket{outbound.Packet.release(), outbound.Channel});
+        sent = true;
+    }
+
+    if (sent)
+        Server->Flush();
+}
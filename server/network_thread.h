@@ -0,0 +1,65 @@
+#pragma once
+
+#include "net.h"
+#include "session_link.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// how long the network thread waits on enet before it checks for packets from the sessions again,
+// so this is also the most a finished tick waits before it goes out
+constexpr uint32_t NetworkPollTimeout = 1;
+
+// owns the enet host, nothing else touches it while the thread runs. players are spread over the sessions as they
+// connect, what they send goes to their session's link and what the sessions send comes back over one shared queue
+class NetworkThread
+{
+public:
+    NetworkThread(std::shared_ptr<net::ENetServer> server,
+                  const std::vector<SessionLink *> &sessions,
+                  uint32_t sessionPlayers,
+                  OutboundQueue &outbound);
+    ~NetworkThread();
+
+    void Start();
+
+    // stop the workers first, whatever they left in the queue is sent on the way out
+    void Stop();
+
+private:
+    static constexpr uint32_t NoSession = UINT32_MAX;
+
+    void Run();
+
+    // NoSession when every session is full
+    uint32_t PickSession(net::RoomId room) const;
+
+    void OnConnect(net::PlayerId playerId);
+    void OnDisconnect(net::PlayerId playerId);
+    void OnPacket(net::PlayerId playerId, net::PacketPtr packet);
+
+    // hands an event to a session, or holds on to it in order while the session is behind
+    void Forward(uint32_t session, InboundEvent &&event);
+    void ForwardBacklog();
+    void SendOutbound();
+
+    std::shared_ptr<net::ENetServer> Server;
+    std::vector<SessionLink *> Sessions;
+    uint32_t SessionPlayers;
+    OutboundQueue &Outbound;
+
+    // indexed by session, how many players each has and what it hasn't had room for yet
+    std::vector<uint32_t> SessionSizes;
+    std::vector<std::deque<InboundEvent>> Backlog;
+
+    // indexed by player id, the session each player is in and the connection they are on
+    std::vector<uint32_t> PlayerSessions;
+    std::vector<uint32_t> Connections;
+    uint32_t NextConnection = 0;
+
+    std::atomic<bool> Running{false};
+    std::thread Thread;
+};
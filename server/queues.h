@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+// keeps the two ends of a queue on their own cache lines, so the threads don't bounce one line between them
+constexpr size_t CacheLineSize = 64;
+
+// a bounded ring for one producer thread and one consumer thread, capacity is rounded up to a power of two
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : Slots(RoundUp(capacity)), Mask(Slots.size() - 1)
+    {
+    }
+
+    // false when full, value is only moved from when it was pushed
+    bool Push(T &&value)
+    {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        if (tail - Head.load(std::memory_order_acquire) == Slots.size())
+            return false;
+
+        Slots[tail & Mask] = std::move(value);
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &value)
+    {
+        size_t head = Head.load(std::memory_order_relaxed);
+        if (head == Tail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(Slots[head & Mask]);
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static size_t RoundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        return size;
+    }
+
+    std::vector<T> Slots;
+    size_t Mask;
+
+    alignas(CacheLineSize) std::atomic<size_t> Head{0};
+    alignas(CacheLineSize) std::atomic<size_t> Tail{0};
+};
+
+// a bounded ring any number of threads push to and one thread pops from, capacity is rounded up to a power of two.
+// every slot carries a sequence number that says whose turn it is, so producers only ever race on the tail
+template<typename T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(size_t capacity)
+        : Slots(RoundUp(capacity)), Mask(Slots.size() - 1)
+    {
+        for (size_t i = 0; i < Slots.size(); i++)
+            Slots[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // false when full, value is only moved from when it was pushed
+    bool Push(T &&value)
+    {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = Slots[tail & Mask];
+            size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+
+            // the slot is free for this lap, claim it by moving the tail past it
+            if (sequence == tail) {
+                if (Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.Value = std::move(value);
+                    slot.Sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            // the consumer hasn't emptied it since the last lap
+            else if (sequence < tail) {
+                return false;
+            }
+            // another producer claimed it first
+            else {
+                tail = Tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Pop(T &value)
+    {
+        Slot &slot = Slots[Head & Mask];
+        if (slot.Sequence.load(std::memory_order_acquire) != Head + 1)
+            return false;
+
+        value = std::move(slot.Value);
+
+        // free for the producers' next lap
+        slot.Sequence.store(Head + Slots.size(), std::memory_order_release);
+        Head++;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> Sequence{0};
+        T Value;
+    };
+
+    static size_t RoundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        return size;
+    }
+
+    std::vector<Slot> Slots;
+    size_t Mask;
+
+    // only the consumer touches the head
+    alignas(CacheLineSize) size_t Head = 0;
+    alignas(CacheLineSize) std::atomic<size_t> Tail{0};
+};
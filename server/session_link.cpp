@@ -0,0 +1,141 @@
+#include "session_link.h"
+
+#include <algorithm>
+#include <thread>
+
+SessionLink::SessionLink(uint32_t maxPlayers, OutboundQueue &outbound)
+    : MaxPlayers(maxPlayers), Inbound(SessionInboundCapacity), Outbound(outbound)
+{
+    Connections.assign(maxPlayers, 0);
+    Batches.assign(maxPlayers, {});
+
+    // taken from the back, so the first player in gets slot 0
+    for (uint32_t slot = maxPlayers; slot > 0; slot--)
+        FreeSlots.push_back(slot - 1);
+}
+
+uint32_t SessionLink::GetSlot(net::PlayerId playerId) const
+{
+    auto found = Slots.find(playerId);
+    return found != Slots.end() ? found->second : NoSlot;
+}
+
+void SessionLink::Poll()
+{
+    InboundEvent event;
+    while (Inbound.Pop(event)) {
+        switch (event.Type) {
+            case InboundEvent::Kind::Connect:
+                if (AddPlayer(event.Player, event.Connection) && OnConnect)
+                    OnConnect(event.Player);
+                break;
+
+            case InboundEvent::Kind::Disconnect:
+                // the handler still finds the player's slot, it is only given up after
+                if (GetSlot(event.Player) != NoSlot && OnDisconnect)
+                    OnDisconnect(event.Player);
+                RemovePlayer(event.Player);
+                break;
+
+            case InboundEvent::Kind::Packet: ReadPacket(event.Player, event.Packet.get());
+                break;
+        }
+
+        // the packet goes back to enet here rather than whenever the slot is next reused
+        event.Packet.reset();
+    }
+}
+
+void SessionLink::ReadPacket(net::PlayerId playerId, const ENetPacket *packet)
+{
+    // anything still queued from before the player left
+    if (GetSlot(playerId) == NoSlot)
+        return;
+
+    // read here rather than on the network thread, so verifying messages is spread over the workers
+    size_t offset = 0;
+    while (offset < packet->dataLength) {
+        const Serialize::Message *message = net::ReadMessage(packet, offset);
+        if (message == nullptr) {
+            spdlog::error("Dropping malformed message from player {}", playerId);
+            break;
+        }
+
+        if (OnMessage)
+            OnMessage(playerId, message);
+    }
+}
+
+bool SessionLink::AddPlayer(net::PlayerId playerId, uint32_t connection)
+{
+    uint32_t slot = GetSlot(playerId);
+    if (slot == NoSlot) {
+        // the network thread never sends a session more players than it has slots
+        if (FreeSlots.empty()) {
+            spdlog::error("No free slot for player {}", playerId);
+            return false;
+        }
+
+        slot = FreeSlots.back();
+        FreeSlots.pop_back();
+        Slots[playerId] = slot;
+        Players.push_back(playerId);
+    }
+
+    Connections[slot] = connection;
+    return true;
+}
+
+void SessionLink::RemovePlayer(net::PlayerId playerId)
+{
+    auto found = Slots.find(playerId);
+    if (found == Slots.end())
+        return;
+
+    uint32_t slot = found->second;
+    Slots.erase(found);
+    FreeSlots.push_back(slot);
+
+    Connections[slot] = 0;
+    Players.erase(std::find(Players.begin(), Players.end(), playerId));
+
+    // whoever gets the slot next must not get what was queued for this player
+    for (net::MessageBatch &batch : Batches[slot])
+        batch.Clear(Packets);
+}
+
+void SessionLink::Queue(net::PlayerId playerId, Serialize::Content type, const flatbuffers::FlatBufferBuilder &builder)
+{
+    uint32_t slot = GetSlot(playerId);
+    if (slot == NoSlot)
+        return;
+
+    net::Delivery delivery = net::GetDelivery(type);
+    Batches[slot][delivery.Channel].Add(Packets, builder, delivery.Flags);
+}
+
+void SessionLink::Queue(const std::vector<net::PlayerId> &players,
+                        Serialize::Content type,
+                        const flatbuffers::FlatBufferBuilder &builder)
+{
+    for (net::PlayerId playerId : players)
+        Queue(playerId, type, builder);
+}
+
+void SessionLink::Flush()
+{
+    for (net::PlayerId playerId : Players) {
+        uint32_t slot = GetSlot(playerId);
+        for (uint8_t channel = 0; channel < net::NUM_CHANNELS; channel++) {
+            ENetPacket *packet = Batches[slot][channel].TakePacket(Packets);
+            if (packet == nullptr)
+                continue;
+
+            OutboundPacket outbound{playerId, Connections[slot], channel, net::PacketPtr(packet)};
+
+            // the network thread never waits on a session, a full queue only holds up this session's worker
+            while (!Outbound.Push(std::move(outbound)))
+                std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "net.h"
+#include "queues.h"
+
+#include <array>
+#include <functional>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// how many network events may wait for a session before the network thread holds on to the rest itself
+constexpr size_t SessionInboundCapacity = 1024;
+
+// how many packets every session together may have waiting for the network thread
+constexpr size_t OutboundCapacity = 4096;
+
+// something the network thread saw happen to one of a session's players
+struct InboundEvent
+{
+    enum class Kind : uint8_t
+    {
+        Connect,
+        Disconnect,
+        Packet,
+    };
+
+    Kind Type = Kind::Packet;
+    net::PlayerId Player = net::NO_PLAYER;
+
+    // which connection of the player this is, so nothing meant for the last one to hold the id reaches the next
+    uint32_t Connection = 0;
+
+    net::PacketPtr Packet;
+};
+
+// a batch a session built for one of its players, sent by the network thread
+struct OutboundPacket
+{
+    net::PlayerId Player = net::NO_PLAYER;
+    uint32_t Connection = 0;
+    uint8_t Channel = 0;
+    net::PacketPtr Packet;
+};
+
+using OutboundQueue = MpscQueue<OutboundPacket>;
+
+// a session's side of the network thread, it looks like the server to the session but is only ever touched from
+// the session's worker, the network thread only pushes events in and takes packets out through the queues.
+// every player in the session holds one of its slots, so what a session keeps per player grows with the session
+// rather than with the whole server
+class SessionLink
+{
+public:
+    static constexpr uint32_t NoSlot = UINT32_MAX;
+
+    SessionLink(uint32_t maxPlayers, OutboundQueue &outbound);
+
+    // network thread, false when the session is too far behind to take it
+    bool Push(InboundEvent &&event) { return Inbound.Push(std::move(event)); }
+
+    // reads every event the network thread has handed over and calls the handlers for them
+    void Poll();
+
+    // queues a message finished with FinishMessage, like ENetServer::Queue
+    void Queue(net::PlayerId playerId, Serialize::Content type, const flatbuffers::FlatBufferBuilder &builder);
+    void Queue(const std::vector<net::PlayerId> &players,
+               Serialize::Content type,
+               const flatbuffers::FlatBufferBuilder &builder);
+
+    // hands everything queued to the network thread, one packet per player and channel
+    void Flush();
+
+    const std::vector<net::PlayerId> &GetPlayers() const { return Players; }
+
+    // how many players the session holds, every slot is below it
+    uint32_t GetMaxPlayers() const { return MaxPlayers; }
+
+    // the slot a player holds until it leaves the session, NoSlot for anyone not in it
+    uint32_t GetSlot(net::PlayerId playerId) const;
+
+    std::function<void(net::PlayerId)> OnConnect;
+    std::function<void(net::PlayerId)> OnDisconnect;
+    std::function<void(net::PlayerId, const Serialize::Message *)> OnMessage;
+
+private:
+    bool AddPlayer(net::PlayerId playerId, uint32_t connection);
+    void RemovePlayer(net::PlayerId playerId);
+    void ReadPacket(net::PlayerId playerId, const ENetPacket *packet);
+
+    uint32_t MaxPlayers;
+
+    SpscQueue<InboundEvent> Inbound;
+    OutboundQueue &Outbound;
+
+    // the session's players in no particular order, the slot each one holds and the slots nobody holds
+    std::vector<net::PlayerId> Players;
+    std::unordered_map<net::PlayerId, uint32_t> Slots;
+    std::vector<uint32_t> FreeSlots;
+
+    // indexed by slot, the connection its player is on and what is queued for it until the next flush
+    std::vector<uint32_t> Connections;
+    net::PacketPool Packets;
+    std::vector<std::array<net::MessageBatch, net::NUM_CHANNELS>> Batches;
+};
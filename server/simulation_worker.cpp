@@ -0,0 +1,117 @@
+#include "simulation_worker.h"
+
+#include <algorithm>
+#include <utility>
+
+SimulationWorker::SimulationWorker(uint32_t index)
+    : Index(index)
+{
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    Stop();
+}
+
+void SimulationWorker::AddSession(std::unique_ptr<GameServer> session)
+{
+    Sessions.push_back(std::move(session));
+}
+
+void SimulationWorker::Start(float tickRate)
+{
+    Running = true;
+    Thread = std::thread(&SimulationWorker::Run, this, tickRate);
+}
+
+void SimulationWorker::Stop()
+{
+    Running = false;
+    if (Thread.joinable())
+        Thread.join();
+}
+
+void SimulationWorker::Run(float tickRate)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const float step = 1.0f / tickRate;
+    const auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(step));
+
+    Stats = TickStats();
+
+    auto nextTick = Clock::now();
+    auto nextReport = nextTick + TickReportInterval;
+    while (Running) {
+        auto tickStart = Clock::now();
+
+        for (const std::unique_ptr<GameServer> &session : Sessions)
+            session->Update(step);
+
+        TickCount++;
+
+        auto tickEnd = Clock::now();
+        auto tickTime = tickEnd - tickStart;
+        Stats.Ticks++;
+        Stats.TotalTime += tickTime;
+        Stats.MaxTime = std::max(Stats.MaxTime, tickTime);
+
+        nextTick += tickLength;
+        if (tickEnd > nextTick) {
+            // too late for the next tick already, drop the ones we missed instead of running them back to back
+            auto behind = tickEnd - nextTick;
+            auto skipped = uint32_t(behind / tickLength);
+
+            Stats.Overruns++;
+            Stats.SkippedTicks += skipped;
+            spdlog::warn("Worker {} tick {} took {:.2f} ms, over its {:.2f} ms budget, skipping {} ticks",
+                         Index,
+                         TickCount,
+                         std::chrono::duration<double, std::milli>(tickTime).count(),
+                         std::chrono::duration<double, std::milli>(tickLength).count(),
+                         skipped);
+
+            nextTick += tickLength * (skipped + 1);
+        }
+
+        if (tickEnd >= nextReport) {
+            ReportTicks(tickLength);
+            nextReport = tickEnd + TickReportInterval;
+        }
+
+        SleepUntil(nextTick);
+    }
+}
+
+void SimulationWorker::SleepUntil(std::chrono::steady_clock::time_point time)
+{
+    // the os can wake us late by a scheduler slice, sleep most of the way and spin the rest
+    auto wake = time - TickSpinMargin;
+    if (std::chrono::steady_clock::now() < wake)
+        std::this_thread::sleep_until(wake);
+
+    while (std::chrono::steady_clock::now() < time)
+        std::this_thread::yield();
+}
+
+void SimulationWorker::ReportTicks(std::chrono::steady_clock::duration tickLength)
+{
+    if (Stats.Ticks == 0)
+        return;
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    double average = Milliseconds(Stats.TotalTime).count() / Stats.Ticks;
+    double budget = Milliseconds(tickLength).count();
+
+    // quiet while the worker keeps up, loud once it starts falling behind
+    if (Stats.Overruns > 0)
+        spdlog::warn("Worker {}: {} ticks over {} sessions, {:.3f} ms average, {:.3f} ms max of a {:.2f} ms budget, "
+                     "{} overruns, {} ticks skipped",
+                     Index, Stats.Ticks, Sessions.size(), average, Milliseconds(Stats.MaxTime).count(), budget,
+                     Stats.Overruns, Stats.SkippedTicks);
+    else
+        spdlog::debug("Worker {}: {} ticks over {} sessions, {:.3f} ms average, {:.3f} ms max of a {:.2f} ms budget",
+                      Index, Stats.Ticks, Sessions.size(), average, Milliseconds(Stats.MaxTime).count(), budget);
+
+    Stats = TickStats();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "game_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// sleeping is only trusted to get this close to the next tick, the rest is spent spinning
+constexpr std::chrono::microseconds TickSpinMargin{1500};
+
+// how often the tick timings are logged
+constexpr std::chrono::seconds TickReportInterval{10};
+
+// how long ticks took since the last report
+struct TickStats
+{
+    uint32_t Ticks = 0;
+    uint32_t Overruns = 0;
+    uint32_t SkippedTicks = 0;
+    std::chrono::steady_clock::duration TotalTime{0};
+    std::chrono::steady_clock::duration MaxTime{0};
+};
+
+// a thread that ticks its own sessions at a fixed rate, no session is ever touched by two workers
+// so nothing in the simulation needs a lock
+class SimulationWorker
+{
+public:
+    explicit SimulationWorker(uint32_t index);
+    ~SimulationWorker();
+
+    // only before Start
+    void AddSession(std::unique_ptr<GameServer> session);
+
+    void Start(float tickRate);
+    void Stop();
+
+private:
+    void Run(float tickRate);
+    static void SleepUntil(std::chrono::steady_clock::time_point time);
+    void ReportTicks(std::chrono::steady_clock::duration tickLength);
+
+    uint32_t Index;
+    std::vector<std::unique_ptr<GameServer>> Sessions;
+
+    uint32_t TickCount = 0;
+    TickStats Stats;
+
+    std::atomic<bool> Running{false};
+    std::thread Thread;
+};
@@ -0,0 +1,300 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "sprite_atlas.h"
+
+#include "raylib.h"
+
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// packs every png under the resource folder into as few atlases as fit and writes the sprite table the game loads
+// them with. the pngs listed in sprites.txt are cut into a grid of frames and come first, so their ids never move
+// usage: rpg_atlas_builder [resource folder]
+
+// no bigger than the smallest texture limit the game runs on
+constexpr int MinAtlasSize = 256;
+constexpr int MaxAtlasSize = 2048;
+
+// empty pixels around every frame, so nothing drawn scaled picks up its neighbour
+constexpr int AtlasPadding = 2;
+
+constexpr char AtlasPrefix[] = "atlas_";
+
+struct SliceRule
+{
+    std::string File;
+    int Columns = 1;
+    int Rows = 1;
+    int Spacing = 0;
+};
+
+struct SourceImage
+{
+    std::string File;
+    Image Pixels = {};
+};
+
+struct Frame
+{
+    int Source = 0;
+    Rectangle From = {0, 0, 0, 0};
+
+    int Atlas = 0;
+    int X = 0;
+    int Y = 0;
+};
+
+// a line is a file name then columns, rows and spacing. names can have spaces, the numbers are the last three words
+static std::vector<SliceRule> ReadSliceRules(const std::filesystem::path &path)
+{
+    std::vector<SliceRule> rules;
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::vector<std::string> words;
+        std::istringstream stream(line);
+        for (std::string word; stream >> word;)
+            words.push_back(word);
+
+        if (words.size() < 4) {
+            TraceLog(LOG_WARNING, "Skipping sprite list line '%s'", line.c_str());
+            continue;
+        }
+
+        SliceRule &rule = rules.emplace_back();
+        for (size_t i = 0; i + 3 < words.size(); i++)
+            rule.File += (i == 0 ? "" : " ") + words[i];
+
+        rule.Columns = std::max(1, atoi(words[words.size() - 3].c_str()));
+        rule.Rows = std::max(1, atoi(words[words.size() - 2].c_str()));
+        rule.Spacing = std::max(0, atoi(words[words.size() - 1].c_str()));
+    }
+
+    return rules;
+}
+
+// every png under the folder by its path from the folder, leaving out atlases from an earlier run
+static std::vector<std::string> FindImages(const std::filesystem::path &folder)
+{
+    std::vector<std::string> images;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(folder, error)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".png")
+            continue;
+
+        std::string file = entry.path().lexically_relative(folder).generic_string();
+        if (file.rfind(AtlasPrefix, 0) == 0)
+            continue;
+
+        images.push_back(file);
+    }
+
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+// shelves of frames, tallest first, a frame that doesn't fit on the page starts the next one. returns the page count,
+// or 0 if a frame is bigger than a page
+static int PackFrames(std::vector<Frame> &frames, const std::vector<size_t> &order, int size)
+{
+    int atlas = 0;
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+
+    for (size_t index : order) {
+        Frame &frame = frames[index];
+        int width = int(frame.From.width) + AtlasPadding;
+        int height = int(frame.From.height) + AtlasPadding;
+        if (width > size || height > size)
+            return 0;
+
+        if (x + width > size) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+
+        if (y + height > size) {
+            atlas++;
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+
+        frame.Atlas = atlas;
+        frame.X = x;
+        frame.Y = y;
+
+        x += width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+
+    return atlas + 1;
+}
+
+static void CopyFrame(Image &atlas, const Image &source, const Frame &frame)
+{
+    const auto *from = static_cast<const uint8_t *>(source.data);
+    auto *to = static_cast<uint8_t *>(atlas.data);
+
+    int width = int(frame.From.width);
+    for (int row = 0; row < int(frame.From.height); row++) {
+        const uint8_t *sourceRow = from + ((int(frame.From.y) + row) * source.width + int(frame.From.x)) * 4;
+        uint8_t *atlasRow = to + ((frame.Y + row) * atlas.width + frame.X) * 4;
+        memcpy(atlasRow, sourceRow, size_t(width) * 4);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path folder = argc > 1 ? argv[1] : "_resources";
+
+    // the listed pngs first in list order, then everything else
+    std::vector<SliceRule> rules = ReadSliceRules(folder / SpriteListFile);
+    std::vector<std::string> files;
+    for (const SliceRule &rule : rules)
+        files.push_back(rule.File);
+
+    for (const std::string &file : FindImages(folder)) {
+        if (std::find(files.begin(), files.end(), file) == files.end())
+            files.push_back(file);
+    }
+
+    std::vector<SourceImage> images;
+    std::vector<Frame> frames;
+    SpriteTable table;
+
+    for (const std::string &file : files) {
+        Image pixels = LoadImage((folder / file).string().c_str());
+        if (pixels.data == nullptr) {
+            TraceLog(LOG_ERROR, "Failed to load %s", file.c_str());
+            return 1;
+        }
+
+        ImageFormat(&pixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+        SliceRule rule;
+        auto ruleItr = std::find_if(rules.begin(), rules.end(), [&](const SliceRule &r) { return r.File == file; });
+        if (ruleItr != rules.end())
+            rule = *ruleItr;
+
+        // the same grid LoadSpriteFrames cuts
+        int itemWidth = (pixels.width + rule.Spacing) / rule.Columns;
+        int itemHeight = (pixels.height + rule.Spacing) / rule.Rows;
+
+        AtlasSource &source = table.Sources.emplace_back();
+        source.File = file;
+        source.FirstSprite = int(frames.size());
+        source.SpriteCount = rule.Columns * rule.Rows;
+
+        for (int y = 0; y < rule.Rows; y++) {
+            for (int x = 0; x < rule.Columns; x++) {
+                Frame &frame = frames.emplace_back();
+                frame.Source = int(images.size());
+                frame.From = Rectangle{float(x * itemWidth),
+                                       float(y * itemHeight),
+                                       float(itemWidth - rule.Spacing),
+                                       float(itemHeight - rule.Spacing)};
+            }
+        }
+
+        images.push_back(SourceImage{file, pixels});
+    }
+
+    std::vector<size_t> order(frames.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        if (frames[a].From.height != frames[b].From.height)
+            return frames[a].From.height > frames[b].From.height;
+        return frames[a].From.width > frames[b].From.width;
+    });
+
+    // the smallest square that holds everything, or as many of the largest as it takes
+    int size = MinAtlasSize;
+    int atlasCount = PackFrames(frames, order, size);
+    while (atlasCount != 1 && size < MaxAtlasSize) {
+        size *= 2;
+        atlasCount = PackFrames(frames, order, size);
+    }
+
+    if (atlasCount == 0) {
+        TraceLog(LOG_ERROR, "A sprite is bigger than a %d atlas", MaxAtlasSize);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int atlas = 0; atlas < atlasCount; atlas++) {
+        Image pixels = GenImageColor(size, size, BLANK);
+        for (const Frame &frame : frames) {
+            if (frame.Atlas == atlas)
+                CopyFrame(pixels, images[frame.Source].Pixels, frame);
+        }
+
+        std::string file = AtlasPrefix + std::to_string(atlas) + ".png";
+        if (!ExportImage(pixels, (folder / file).string().c_str())) {
+            TraceLog(LOG_ERROR, "Failed to write atlas %s", file.c_str());
+            failures++;
+        }
+
+        table.Atlases.push_back(file);
+        UnloadImage(pixels);
+    }
+
+    for (const Frame &frame : frames) {
+        AtlasSprite &sprite = table.Sprites.emplace_back();
+        sprite.Atlas = frame.Atlas;
+        sprite.SourceRect = Rectangle{float(frame.X), float(frame.Y), frame.From.width, frame.From.height};
+    }
+
+    for (SourceImage &image : images)
+        UnloadImage(image.Pixels);
+
+    std::string tablePath = (folder / SpriteTableFile).string();
+    if (failures == 0 && !WriteSpriteTable(tablePath.c_str(), table)) {
+        TraceLog(LOG_ERROR, "Failed to write sprite table %s", tablePath.c_str());
+        failures++;
+    }
+
+    if (failures == 0)
+        TraceLog(LOG_INFO, "Packed %zu sprites from %zu pngs into %d atlases of %d", frames.size(), images.size(),
+                 atlasCount, size);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "effects.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <new>
+#include <vector>
+
+// times aging and drawing a steady crowd of effects, a node per effect in a list against the effect system
+// usage: rpg_effects_bench [effects] [ticks]
+static size_t Allocations = 0;
+
+void *operator new(size_t size)
+{
+    Allocations++;
+    if (void *memory = malloc(size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+constexpr float TickTime = 1.0f / 30;
+
+struct BenchResult
+{
+    double MicrosecondsPerTick = 0;
+    double AllocationsPerTick = 0;
+    double Checksum = 0;
+};
+
+// what combat spawns, the same sequence for both paths
+struct Spawner
+{
+    unsigned int Seed = 1;
+
+    int Next()
+    {
+        Seed = Seed * 1103515245 + 12345;
+        return int((Seed >> 16) & 0x7FFF);
+    }
+
+    EffectType NextType()
+    {
+        return EffectType(Next() % EffectTypeCount);
+    }
+
+    float NextLifetime()
+    {
+        return 0.25f + (Next() % 100) / 100.0f * 3.25f;
+    }
+
+    Vector2 NextPoint()
+    {
+        return Vector2{float(Next() % 2000), float(Next() % 2000)};
+    }
+};
+
+// the old effect, a list node each, aged in the tick and worked out per type while drawing
+struct EffectInstance
+{
+    Vector2 Position = {0, 0};
+    EffectType Effect = EffectType::Fade;
+    int SpriteId = -1;
+    float Lifetime = 1;
+    float MaxLifetime = 1;
+    Vector2 Target = {0, 0};
+};
+
+static double DrawList(const std::list<EffectInstance> &effects)
+{
+    double checksum = 0;
+    for (const EffectInstance &effect : effects) {
+        float param = effect.Lifetime / effect.MaxLifetime;
+        float rotation = 0;
+        float alpha = 1;
+        float scale = 1;
+        Vector2 pos = effect.Position;
+
+        switch (effect.Effect) {
+            case EffectType::Fade: alpha = param;
+                break;
+
+            case EffectType::RiseFade: alpha = param;
+                pos.y -= (1.0f - param) * 30;
+                break;
+
+            case EffectType::RotateFade: rotation = (1.0f - param) * 360;
+                alpha = param;
+                break;
+
+            case EffectType::ScaleFade: alpha = param;
+                scale = 1 + (1.0f - param);
+                break;
+
+            case EffectType::ToTarget: {
+                float dx = effect.Target.x - effect.Position.x;
+                float dy = effect.Target.y - effect.Position.y;
+                float dist = sqrtf(dx * dx + dy * dy);
+                if (dist > 0) {
+                    pos.x += dx / dist * dist * (1.0f - param);
+                    pos.y += dy / dist * dist * (1.0f - param);
+                }
+                break;
+            }
+        }
+
+        checksum += pos.x + pos.y + rotation + scale + alpha;
+    }
+
+    return checksum;
+}
+
+static BenchResult RunList(size_t count, int ticks)
+{
+    Spawner spawner;
+    std::list<EffectInstance> effects;
+
+    size_t allocations = Allocations;
+    double checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int tick = 0; tick < ticks; tick++) {
+        while (effects.size() < count) {
+            float lifetime = spawner.NextLifetime();
+            EffectType type = spawner.NextType();
+            Vector2 position = spawner.NextPoint();
+            effects.emplace_back(EffectInstance{position, type, 0, lifetime, lifetime, spawner.NextPoint()});
+        }
+
+        for (auto effect = effects.begin(); effect != effects.end();) {
+            effect->Lifetime -= TickTime;
+            if (effect->Lifetime < 0) {
+                effect = effects.erase(effect);
+                continue;
+            }
+            effect++;
+        }
+
+        checksum += DrawList(effects);
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return BenchResult{elapsed.count() / ticks, double(Allocations - allocations) / ticks, checksum};
+}
+
+static BenchResult RunSystem(size_t count, int ticks)
+{
+    Spawner spawner;
+
+    // every type has room for all of them, nothing is dropped whatever the spawner picks
+    EffectSystem effects(count);
+
+    size_t allocations = Allocations;
+    double checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int tick = 0; tick < ticks; tick++) {
+        while (effects.Size() < count) {
+            float lifetime = spawner.NextLifetime();
+            EffectType type = spawner.NextType();
+            Vector2 position = spawner.NextPoint();
+            effects.Add(position, type, 0, spawner.NextPoint(), lifetime);
+        }
+
+        effects.Update(TickTime);
+
+        for (size_t type = 0; type < EffectTypeCount; type++) {
+            const EffectArrays &drawn = effects.Get(EffectType(type));
+            for (size_t i = 0; i < drawn.Count; i++)
+                checksum += drawn.DrawPositions[i].x + drawn.DrawPositions[i].y + drawn.Rotations[i] + drawn.Scales[i]
+                    + drawn.Alphas[i];
+        }
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return BenchResult{elapsed.count() / ticks, double(Allocations - allocations) / ticks, checksum};
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = argc > 2 ? std::max(1, atoi(argv[2])) : 2000;
+
+    std::vector<size_t> counts = {1000, 4000, 16000};
+    if (argc > 1)
+        counts = {size_t(std::max(1, atoi(argv[1])))};
+
+    printf("%-10s %-16s %14s %14s\n", "effects", "path", "us/tick", "allocs/tick");
+    for (size_t count : counts) {
+        BenchResult before = RunList(count, ticks);
+        BenchResult after = RunSystem(count, ticks);
+
+        // both paths spawn the same effects and age them the same way, they have to draw the same thing
+        if (fabs(before.Checksum - after.Checksum) > fabs(before.Checksum) * 1e-6) {
+            printf("Checksums differ for %zu effects: %f and %f\n", count, before.Checksum, after.Checksum);
+            return 1;
+        }
+
+        printf("%-10zu %-16s %14.2f %14.3f\n", count, "list", before.MicrosecondsPerTick, before.AllocationsPerTick);
+        printf("%-10zu %-16s %14.2f %14.3f\n", count, "effect system", after.MicrosecondsPerTick,
+               after.AllocationsPerTick);
+    }
+
+    printf("%d ticks of %.1f ms\n", ticks, TickTime * 1000);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "tile_map.h"
+
+#include "raylib.h"
+
+#include <string>
+
+// compiles Tiled .tmx maps into the flat format ReadTileMap can memory map
+// usage: rpg_map_compiler <map.tmx> [<map.tmx> ...]
+//        rpg_map_compiler -o <output> <map.tmx>
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        TraceLog(LOG_ERROR, "usage: %s [-o output] <map.tmx> [<map.tmx> ...]", argv[0]);
+        return 1;
+    }
+
+    std::string outputOverride;
+    int firstInput = 1;
+    if (std::string(argv[1]) == "-o") {
+        if (argc != 4) {
+            TraceLog(LOG_ERROR, "-o can only be used with a single input map");
+            return 1;
+        }
+        outputOverride = argv[2];
+        firstInput = 3;
+    }
+
+    int failures = 0;
+    for (int i = firstInput; i < argc; i++) {
+        const char *input = argv[i];
+        std::string output = outputOverride.empty() ? GetCompiledMapPath(input) : outputOverride;
+
+        TileMap map;
+        if (!ReadTileMapXML(input, map)) {
+            TraceLog(LOG_ERROR, "Failed to read map %s", input);
+            failures++;
+            continue;
+        }
+
+        if (!WriteCompiledTileMap(output.c_str(), map)) {
+            TraceLog(LOG_ERROR, "Failed to write compiled map %s", output.c_str());
+            failures++;
+            continue;
+        }
+
+        TraceLog(LOG_INFO, "Compiled %s -> %s", input, output.c_str());
+    }
+
+    return failures == 0 ? 0 : 1;
+}
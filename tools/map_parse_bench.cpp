@@ -0,0 +1,91 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "tile_map.h"
+
+#include "raylib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// times the xml and compiled map loaders over every .tmx in a folder
+// usage: rpg_map_bench [maps folder] [iterations]
+template<typename Loader>
+static double TimeLoads(const std::string &path, int iterations, Loader loader)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        TileMap map;
+        if (!loader(path.c_str(), map))
+            return -1;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string folder = argc > 1 ? argv[1] : "_resources/maps";
+    int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 50;
+
+    std::vector<std::string> maps;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(folder, error)) {
+        if (entry.path().extension() == ".tmx")
+            maps.push_back(entry.path().string());
+    }
+
+    if (maps.empty()) {
+        TraceLog(LOG_ERROR, "No .tmx maps found in %s", folder.c_str());
+        return 1;
+    }
+
+    // keep the loaders' own logging out of the timings
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::string compiledPath = (std::filesystem::temp_directory_path() / "rpg_map_bench.rpgmap").string();
+
+    printf("%-40s %12s %12s\n", "map", "xml (ms)", "compiled (ms)");
+    for (const std::string &path : maps) {
+        TileMap source;
+        if (!ReadTileMapXML(path.c_str(), source) || !WriteCompiledTileMap(compiledPath.c_str(), source)) {
+            TraceLog(LOG_ERROR, "Failed to prepare %s", path.c_str());
+            continue;
+        }
+
+        double xml = TimeLoads(path, iterations, ReadTileMapXML);
+        double compiled = TimeLoads(compiledPath, iterations, ReadCompiledTileMap);
+
+        printf("%-40s %12.3f %12.3f\n", std::filesystem::path(path).filename().string().c_str(), xml, compiled);
+    }
+
+    std::filesystem::remove(compiledPath, error);
+    return 0;
+}
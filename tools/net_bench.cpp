@@ -0,0 +1,155 @@
+/**********************************************************************************************
+*
+*   Raylib RPG Example * A simple RPG made using raylib
+*
+*    LICENSE: zlib/libpng
+*
+*   Copyright (c) 2020 Jeffery Myers
+*
+*   This software is provided "as-is", without any express or implied warranty. In no event
+*   will the authors be held liable for any damages arising from the use of this software.
+*
+*   Permission is granted to anyone to use this software for any purpose, including commercial
+*   applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*     1. The origin of this software must not be misrepresented; you must not claim that you
+*     wrote the original software. If you use this software in a product, an acknowledgment
+*     in the product documentation would be appreciated but is not required.
+*
+*     2. Altered source versions must be plainly marked as such, and must not be misrepresented
+*     as being the original software.
+*
+*     3. This notice may not be removed or altered from any source distribution.
+*
+**********************************************************************************************/
+
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+// times building and packing outbound messages, one packet per message against pooled builders and batches
+// usage: rpg_net_bench [messages] [messages per packet]
+static size_t Allocations = 0;
+
+void *operator new(size_t size)
+{
+    Allocations++;
+    if (void *memory = malloc(size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+static void *CountedMalloc(size_t size)
+{
+    Allocations++;
+    return malloc(size);
+}
+
+struct BenchResult
+{
+    double MessagesPerSecond = 0;
+    double AllocationsPerMessage = 0;
+};
+
+template<typename Pack>
+static BenchResult Run(int messages, Pack pack)
+{
+    size_t allocations = Allocations;
+    auto start = std::chrono::steady_clock::now();
+
+    pack(messages);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return BenchResult{messages / elapsed.count(), double(Allocations - allocations) / messages};
+}
+
+// a typical client tick, the last few move steps
+static Serialize::Content BuildMove(flatbuffers::FlatBufferBuilder &builder, int index)
+{
+    Serialize::MoveStep steps[net::MOVE_REDUNDANCY];
+    for (uint32_t i = 0; i < net::MOVE_REDUNDANCY; i++)
+        steps[i] = Serialize::MoveStep(uint32_t(index - i), net::MOVE_FLAG_TARGET, float(index), float(i));
+
+    return net::SerializeMove(builder, 1, steps, net::MOVE_REDUNDANCY);
+}
+
+int main(int argc, char *argv[])
+{
+    int messages = argc > 1 ? std::max(1, atoi(argv[1])) : 200000;
+    int perPacket = argc > 2 ? std::max(1, atoi(argv[2])) : 8;
+
+    ENetCallbacks callbacks = {CountedMalloc, free, nullptr};
+    if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0) {
+        printf("Failed to initialize enet\n");
+        return 1;
+    }
+
+    // a fresh builder and a copied packet for every message, destroyed the way enet does once it is sent
+    auto unpooled = [](int count)
+    {
+        for (int i = 0; i < count; i++) {
+            flatbuffers::FlatBufferBuilder builder(1024);
+            BuildMove(builder, i);
+            enet_packet_destroy(enet_packet_create(builder.GetBufferPointer(), builder.GetSize(), 0));
+        }
+    };
+
+    net::PacketPool packets;
+    net::MessageBatch batch;
+    size_t batched = 0;
+
+    auto pooled = [&](int count)
+    {
+        for (int i = 0; i < count; i++) {
+            net::BuilderPool::Lease builder = net::GetBuilderPool().Acquire();
+            BuildMove(*builder, i);
+            batch.Add(packets, *builder, 0);
+
+            if ((i + 1) % perPacket == 0 || i + 1 == count) {
+                ENetPacket *packet = batch.TakePacket(packets);
+
+                // every message in the batch has to read back on its own
+                size_t offset = 0;
+                while (net::ReadMessage(packet, offset) != nullptr)
+                    batched++;
+
+                enet_packet_destroy(packet);
+            }
+        }
+    };
+
+    // one pass each to grow the pools and warm the allocator, so the timed passes measure the steady state
+    unpooled(perPacket);
+    pooled(perPacket);
+    batched = 0;
+
+    BenchResult before = Run(messages, unpooled);
+    BenchResult after = Run(messages, pooled);
+
+    if (batched != size_t(messages)) {
+        printf("Read back %zu of %d batched messages\n", batched, messages);
+        return 1;
+    }
+
+    printf("%-24s %16s %16s\n", "path", "messages/sec", "allocs/message");
+    printf("%-24s %16.0f %16.3f\n", "builder per message", before.MessagesPerSecond, before.AllocationsPerMessage);
+    printf("%-24s %16.0f %16.3f\n", "pooled and batched", after.MessagesPerSecond, after.AllocationsPerMessage);
+    printf("%d messages, %d per packet, %zu packet buffers\n", messages, perPacket, packets.GetBufferCount());
+
+    enet_deinitialize();
+    return 0;
+}